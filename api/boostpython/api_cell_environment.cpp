@@ -6,6 +6,7 @@
 #include "core/time_axis.h"
 #include "core/time_series.h"
 #include "core/cell_model.h"
+#include "core/float_ts.h"
 
 namespace expose {
     using namespace boost::python;
@@ -32,5 +33,15 @@ namespace expose {
             .def("init",&CellEnvironmentConstRHumWind::init,args("ta"),"zero all series, set time-axis ta")
             ;
 
+        typedef shyft::core::environment_float_t CellEnvironmentFloat;
+        class_<CellEnvironmentFloat>("CellEnvironmentFloat","As CellEnvironment, with the series in single precision(TsFixedFloat), to save memory for large regions")
+            .def_readwrite("temperature",&CellEnvironmentFloat::temperature)
+            .def_readwrite("precipitation",&CellEnvironmentFloat::precipitation)
+            .def_readwrite("radiation",&CellEnvironmentFloat::radiation)
+            .def_readwrite("wind_speed",&CellEnvironmentFloat::wind_speed)
+            .def_readwrite("rel_hum",&CellEnvironmentFloat::rel_hum)
+            .def("init",&CellEnvironmentFloat::init,args("ta"),"fill all series with nan, set time-axis ta")
+            ;
+
     }
 }
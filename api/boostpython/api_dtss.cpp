@@ -197,6 +197,8 @@ namespace shyft {
             }
             bool get_compress_expressions() const {return impl.compress_expressions;}
             void set_compress_expressions(bool v) {impl.compress_expressions=v;}
+            bool get_compact_wire() const {return impl.srv_con[0].wire_request>0;}
+            void set_compact_wire(bool v) {impl.set_compact_wire(v);}
         };
     }
 }
@@ -400,6 +402,29 @@ namespace expose {
                           )
 
             )
+            .def("set_cache_shards",&DtsServer::set_cache_shards,(py::arg("self"),py::arg("n_shards")),
+                doc_intro("set the number of lock-striped shards of the ts-cache.")
+                doc_intro("The ts-ids are distributed by hash onto n_shards independent lru-caches,")
+                doc_intro("each with its own lock, so that concurrent clients do not serialize on one lock.")
+                doc_intro("Default is 1. The total cache capacity is kept, but evenly split on the shards")
+                doc_parameters()
+                doc_parameter("n_shards","int","number of shards, >0")
+                doc_notes()
+                doc_note("the cache content and the cache statistics are flushed.\n"
+                         "currently this call should only be used when the server is not processing messages"
+                        )
+            )
+            .def("get_cache_shards",&DtsServer::get_cache_shards,(py::arg("self")),
+                doc_intro("returns the number of lock-striped shards of the ts-cache")
+            )
+            .def("set_compress_values",&DtsServer::set_compress_values,(py::arg("self"),py::arg("active")),
+                doc_intro("set compressed storage of time-series values in the internal shyft containers active or passive.")
+                doc_intro("When active, written time-series values are stored in compressed blocks,")
+                doc_intro("typically a fraction of the raw size, and a period read only decompress the blocks it needs.")
+                doc_intro("Default is off. Reading handles both compressed and raw files")
+                doc_parameters()
+                doc_parameter("active","bool","if set True, all internal container writes will compress the values")
+            )
             .def("set_auto_cache",&DtsServer::set_auto_cache,(py::arg("self"),py::arg("active")),
                 doc_intro("set auto caching all reads active or passive.")
                 doc_intro("Default is off, and caching must be done through")
@@ -439,6 +464,17 @@ namespace expose {
                 doc_intro("algorithm. Notice that assigning a lower value than the existing value will also flush out")
                 doc_intro("time-series from cache in the least recently used order.")
             )
+            .add_property("cache_max_bytes",&DtsServer::get_cache_byte_size,&DtsServer::set_cache_byte_size,
+                doc_intro("cache_max_bytes is the maximum estimated number of bytes of time-series points that are")
+                doc_intro("kept in memory, 0 (default) means that only cache_max_items applies.")
+                doc_intro("The size of each time-series is estimated as 8 bytes per point.")
+                doc_intro("Elements exceeding this capacity is elided according to the cache_policy.")
+            )
+            .add_property("cache_policy",&DtsServer::get_cache_policy,&DtsServer::set_cache_policy,
+                doc_intro("cache_policy decides which time-series to evict when the cache is full,")
+                doc_intro("CachePolicy.LRU (default) evicts the least recently used,")
+                doc_intro("CachePolicy.GDSF evicts by greedy-dual-size-frequency, keeping small and frequently used time-series")
+            )
             ;
 
     }
@@ -570,11 +606,22 @@ namespace expose {
                 doc_intro("depth 100 (e.g. nested sums), this can speed up")
                 doc_intro("the transmission by a factor or 3.")
             )
+            .add_property("compact_wire",&DtsClient::get_compact_wire,&DtsClient::set_compact_wire,
+                doc_intro("if True(default), time-series results are received in a compact binary format,")
+                doc_intro("that is faster to read than the general format, provided the server supports it.")
+                doc_intro("Takes effect when the connection is (re)opened.")
+            )
             ;
 
     }
     void dtss_cache_stats() {
         using CacheStats = shyft::dtss::cache_stats;
+        using shyft::dtss::cache_policy;
+        enum_<cache_policy>("CachePolicy")
+            .value("LRU",cache_policy::lru)
+            .value("GDSF",cache_policy::gdsf)
+            .export_values()
+            ;
         class_<CacheStats>("CacheStats",
             doc_intro("Cache statistics for the DtsServer."),
 			init<>(py::arg("self"))
@@ -598,6 +645,9 @@ namespace expose {
             .def_readwrite("fragment_count", &CacheStats::fragment_count,
                 doc_intro("number of time-series fragments in the cache, (greater or equal to id_count)")
             )
+            .def_readwrite("byte_count", &CacheStats::byte_count,
+                doc_intro("estimated number of bytes resident in the cache, 8 bytes per point")
+            )
             ;
 
     }
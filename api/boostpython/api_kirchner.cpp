@@ -9,11 +9,21 @@ namespace expose {
         using namespace boost::python;
         using namespace std;
 
+        enum_<solver_type>("KirchnerSolver")
+            .value("ADAPTIVE_DENSE",adaptive_dense)
+            .value("FIXED_STEP",fixed_step)
+            .export_values()
+            ;
+
         class_<parameter>("KirchnerParameter")
             .def(init<double,optional<double,double>>(args("c1","c2","c3"),"creates parameter object according to parameters"))
             .def_readwrite("c1",&parameter::c1,"default =2.439")
             .def_readwrite("c2",&parameter::c2,"default= 0.966")
             .def_readwrite("c3",&parameter::c3,"default = -0.10")
+            .def_readwrite("solver",&parameter::solver,"the ode solver, default ADAPTIVE_DENSE, FIXED_STEP is faster, with somewhat less accuracy")
+            .def_readwrite("steps_pr_hour",&parameter::steps_pr_hour,"number of steps pr. hour of the time-step for the FIXED_STEP solver, default = 4, cost is proportional, error drops with the square.\n"
+                            "Stepping a year of hourly forcing, 4 takes about 60% of the time of ADAPTIVE_DENSE, and is within 4.5%, ADAPTIVE_DENSE is up to 7% off,\n"
+                            "2 takes about 35%, but is up to 36% off at the onset of heavy rain on a dry catchment, 8 is within 1% at the cost of ADAPTIVE_DENSE")
             ;
 
         class_<state>("KirchnerState")
@@ -3,6 +3,7 @@
 #include "core/utctime_utilities.h"
 #include "core/time_axis.h"
 #include "core/time_series.h"
+#include "core/float_ts.h"
 #include "core/predictions.h"
 #include "api/api.h"
 #include "core/time_series_dd.h"
@@ -385,6 +386,30 @@ namespace expose {
     }
 
 
+    template <class TA>
+    static void float_ts(const char *ts_type_name,const char *doc) {
+        typedef shyft::core::float_ts<TA> pts_t;
+        class_<pts_t,bases<>,shared_ptr<pts_t>,boost::noncopyable>(ts_type_name, doc)
+            .def(init<const TA&,const vector<double>&,time_series::ts_point_fx>(
+				(py::arg("self"),py::arg("ta"),py::arg("v"),py::arg("policy")),
+				doc_intro("constructs a new timeseries from timeaxis, points and policy (how the points are to be interpreted, instant, or average of the interval)")
+				)
+			)
+            .def(init<const TA&,double,time_series::ts_point_fx>(
+				(py::arg("self"),py::arg("ta"),py::arg("fill_value"),py::arg("policy")),
+				doc_intro("constructs a new timeseries from timeaxis, fill-value and policy")
+				)
+			)
+            DEF_STD_TS_STUFF()
+            .add_property("v",&pts_t::values,
+				doc_intro("the values converted to double precision")
+			)
+			.def("get_time_axis", &pts_t::time_axis,(py::arg("self")),
+				"returns the time-axis", return_internal_reference<>()
+			)
+            ;
+    }
+
     BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(point_ts_overloads     ,shyft::api::TsFactory::create_point_ts,4,5);
     BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(time_point_ts_overloads,shyft::api::TsFactory::create_time_point_ts,3,4);
 
@@ -1330,6 +1355,7 @@ namespace expose {
             ;
         point_ts<time_axis::fixed_dt>("TsFixed","A time-series with a fixed delta t time-axis, used by the Shyft core,see also TimeSeries for end-user ts");
         point_ts<time_axis::point_dt>("TsPoint","A time-series with a variable delta time-axis, used by the Shyft core,see also TimeSeries for end-user ts");
+        float_ts<time_axis::fixed_dt>("TsFixedFloat","As TsFixed, values stored in single precision, used by the Shyft core for the *Float cell-models");
         TsFactory();
 		expose_rating_curve_classes();
         expose_apoint_ts();
@@ -241,6 +241,20 @@ namespace expose {
                 doc_parameter("best_effort","bool","default=True, don't throw, just return True/False if problem, with best_effort, unfilled values is nan")
                 doc_returns("success","bool","True if interpolation runs with no exceptions(btk,raises if to few neighbours)")
 		 )
+		 .def("interpolate_range", &M::interpolate_range, (py::arg("self"),py::arg("interpolation_parameter"),py::arg("env"),py::arg("start_step"),py::arg("n_steps")=0,py::arg("best_effort")=true),
+                doc_intro("as interpolate, but only the time-steps start_step..start_step+n_steps of the cell env. series are (re)computed,")
+                doc_intro("the other time-steps are kept as is. Use this for a rolling update, e.g. when only the latest forecast steps changes.")
+                doc_intro("")
+                doc_intro("note: initialize_cell_environment should be called once prior to this function")
+                doc_intro("")
+                doc_parameters()
+                doc_parameter("interpolation_parameter","InterpolationParameter","contains wanted parameters for the interpolation")
+                doc_parameter("env","RegionEnvironment","contains the region environment with geo-localized time-series for P,T,R,W,Rh")
+                doc_parameter("start_step","int","the first step of the region-model time-axis to interpolate")
+                doc_parameter("n_steps","int","number of steps to interpolate, default=0 meaning to the end of the time-axis")
+                doc_parameter("best_effort","bool","default=True, don't throw, just return True/False if problem, with best_effort, unfilled values is nan")
+                doc_returns("success","bool","True if interpolation runs with no exceptions(btk,raises if to few neighbours)")
+		 )
          .def("run_cells",&M::run_cells,(py::arg("self"),py::arg("use_ncore")=0,py::arg("start_step")=0,py::arg("n_steps")=0),
                 doc_intro("run_cells calculations over specified time_axis,optionally with thread_cell_count, start_step and n_steps")
                 doc_intro("require that initialize(time_axis) or run_interpolation is done first")
@@ -308,6 +322,7 @@ namespace expose {
 		 .def("set_calculation_filter", &M::set_calculation_filter, (py::arg("self"), py::arg("catchment_id_list"), py::arg("river_id_list")),
                  "set/reset the catchment *and* river based calculation filter. This affects what get simulate/calculated during\n"
                  "the run command. Pass an empty list to reset/clear the filter (i.e. no filter).\n"
+                 "If the river_id_list is not empty, only those rivers, and the rivers upstream, are routed.\n"
                  "\n"
                  "param catchment_id_list is a catchment id vector\n"
                 "param river_id_list is a river id vector\n"
@@ -400,6 +415,20 @@ namespace expose {
 
     }
 
+    /** copy env_ts, same type */
+    template <class E>
+    static void copy_env_ts(E& d, const E& s) { d = s; }
+
+    /** copy env_ts between different types, like single and double precision series */
+    template <class D, class S>
+    static void copy_env_ts(D& d, const S& s) {
+        d.temperature = decltype(d.temperature)(s.temperature);
+        d.precipitation = decltype(d.precipitation)(s.precipitation);
+        d.radiation = decltype(d.radiation)(s.radiation);
+        d.rel_hum = decltype(d.rel_hum)(s.rel_hum);
+        d.wind_speed = decltype(d.wind_speed)(s.wind_speed);
+    }
+
     template <class F, class O>
     O clone_to_opt_impl(F const& f) {
         O o(f.extract_geo_cell_data(), f.get_region_parameter());
@@ -411,7 +440,7 @@ namespace expose {
         auto fc = f.get_cells();
         auto oc = o.get_cells();
         for (size_t i = 0;i < f.size();++i) {
-            (*oc)[i].env_ts = (*fc)[i].env_ts;
+            copy_env_ts((*oc)[i].env_ts, (*fc)[i].env_ts);
             (*oc)[i].state = (*fc)[i].state;
         }
         return o;
@@ -581,6 +610,11 @@ namespace expose {
         .def("reset_states",&Optimizer::reset_states,"reset the state of the model to the initial state before starting the run/optimize")
         .def("set_parameter_ranges",&Optimizer::set_parameter_ranges,args("p_min","p_max"),"set the parameter ranges, set min=max=wanted parameter value for those not subject to change during optimization")
         .def("set_verbose_level",&Optimizer::set_verbose_level,args("level"),"set verbose level on stdout during calibration,0 is silent,1 is more etc.")
+        .def("set_concurrent_evaluations",&Optimizer::set_concurrent_evaluations,args("n"),
+            "set the number of candidates that optimize_sceua and optimize_dream evaluates concurrently,\n"
+            "each on a clone of the region-model, using one thread pr. clone. Default 1, evaluates on the region-model itself.\n"
+            "The memory needed is n times the region-model."
+        )
         .def("calculate_goal_function",calculate_goal_function_v,args("full_vector_of_parameters"),
                 "(deprecated)calculate the goal_function as used by minbobyqa,etc.,\n"
                 "using the full set of  parameters vectors (as passed to optimize())\n"
@@ -102,6 +102,15 @@ namespace expose {
                 .def_readonly("end_reponse",&PTGSKDischargeCollector::end_response,"end_response, at the end of collected")
                 .def_readwrite("collect_snow",&PTGSKDischargeCollector::collect_snow,"controls collection of snow routine")
                 ;
+            typedef shyft::core::pt_gs_k::discharge_float_collector PTGSKDischargeFloatCollector;
+            class_<PTGSKDischargeFloatCollector>("PTGSKDischargeFloatCollector", "as PTGSKDischargeCollector, with series in single precision(TsFixedFloat)")
+                .def_readonly("cell_area",&PTGSKDischargeFloatCollector::cell_area,"a copy of cell area [m2]")
+                .def_readonly("avg_discharge",&PTGSKDischargeFloatCollector::avg_discharge,"Kirchner Discharge given in [m^3/s] for the timestep")
+                .def_readonly("snow_sca",&PTGSKDischargeFloatCollector::snow_sca," gamma snow covered area fraction, sca.. 0..1 - at the end of timestep (state)")
+                .def_readonly("snow_swe",&PTGSKDischargeFloatCollector::snow_swe,"gamma snow swe, [mm] over the cell sca.. area, - at the end of timestep")
+                .def_readonly("end_reponse",&PTGSKDischargeFloatCollector::end_response,"end_response, at the end of collected")
+                .def_readwrite("collect_snow",&PTGSKDischargeFloatCollector::collect_snow,"controls collection of snow routine")
+                ;
             typedef shyft::core::pt_gs_k::null_collector PTGSKNullCollector;
             class_<PTGSKNullCollector>("PTGSKNullCollector","collector that does not collect anything, useful during calibration to minimize memory&maximize speed")
                 ;
@@ -128,6 +137,7 @@ namespace expose {
               typedef shyft::core::cell<parameter, environment_t, state, null_collector, discharge_collector> PTGSKCellOpt;
               expose::cell<PTGSKCellAll>("PTGSKCellAll","tbd: PTGSKCellAll doc");
               expose::cell<PTGSKCellOpt>("PTGSKCellOpt","tbd: PTGSKCellOpt doc");
+              expose::cell<cell_float_discharge_response_t>("PTGSKCellOptFloat","as PTGSKCellOpt, with env_ts and response series in single precision");
               expose::statistics::gamma_snow<PTGSKCellAll>("PTGSKCell");//it only gives meaning to expose the *All collect cell-type
               expose::statistics::actual_evapotranspiration<PTGSKCellAll>("PTGSKCell");
               expose::statistics::priestley_taylor<PTGSKCellAll>("PTGSKCell");
@@ -142,8 +152,12 @@ namespace expose {
             typedef shyft::core::region_model<pt_gs_k::cell_complete_response_t, shyft::api::a_region_environment> PTGSKModel;
             expose::model<PTGSKModel>("PTGSKModel","PTGSK");
             expose::model<PTGSKOptModel>("PTGSKOptModel","PTGSK");
+            typedef shyft::core::region_model<pt_gs_k::cell_float_discharge_response_t, shyft::api::a_region_environment> PTGSKOptFloatModel;
+            expose::model<PTGSKOptFloatModel>("PTGSKOptFloatModel","PTGSK");
             def_clone_to_similar_model<PTGSKModel, PTGSKOptModel>("create_opt_model_clone");
             def_clone_to_similar_model<PTGSKOptModel,PTGSKModel>("create_full_model_clone");
+            def_clone_to_similar_model<PTGSKModel, PTGSKOptFloatModel>("create_opt_float_model_clone");
+            def_clone_to_similar_model<PTGSKOptFloatModel,PTGSKModel>("create_full_model_clone_from_float");
         }
 
 
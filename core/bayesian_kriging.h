@@ -3,6 +3,9 @@
 #include <string>
 #include <vector>
 #include <iterator>
+#include <list>
+#include <map>
+#include <cmath>
 //#include <cmath>
 //#include <limits>
 #include <stdexcept>
@@ -158,6 +161,63 @@ namespace shyft {
 	                                                                 { f.at(1, i++) = dest.mid_point().z; });
 
 	            }
+
+	            /** \brief solve R.t()*X = B, with R upper triangular, X replacing B */
+	            inline void solve_upper_t(const arma::mat& R, arma::mat& B) {
+	                const arma::uword n = R.n_rows;
+	                for (arma::uword c = 0; c < B.n_cols; ++c) {
+	                    for (arma::uword i = 0; i < n; ++i) {
+	                        double x = B.at(i, c);
+	                        for (arma::uword k = 0; k < i; ++k)
+	                            x -= R.at(k, i)*B.at(k, c);
+	                        B.at(i, c) = x/R.at(i, i);
+	                    }
+	                }
+	            }
+
+	            /** \brief solve R*X = B, with R upper triangular, X replacing B */
+	            inline void solve_upper(const arma::mat& R, arma::mat& B) {
+	                const arma::uword n = R.n_rows;
+	                for (arma::uword c = 0; c < B.n_cols; ++c) {
+	                    for (arma::uword i = n; i-- > 0;) {
+	                        double x = B.at(i, c);
+	                        for (arma::uword k = i + 1; k < n; ++k)
+	                            x -= R.at(i, k)*B.at(k, c);
+	                        B.at(i, c) = x/R.at(i, i);
+	                    }
+	                }
+	            }
+
+	            /** \brief remove variable j from the upper cholesky factor R of K
+	             *
+	             * Removing column j leaves R upper Hessenberg from column j, that is made upper triangular
+	             * again using Givens rotations, so that the result is the factor of K without row and column j.
+	             * The cost is O(n^2), compared to O(n^3) for a new factorization.
+	             */
+	            inline void chol_delete(arma::mat& R, arma::uword j) {
+	                const arma::uword n = R.n_rows;
+	                arma::mat Rn(n, n - 1);
+	                for (arma::uword c = 0, cn = 0; c < n; ++c) {
+	                    if (c == j) continue;
+	                    for (arma::uword i = 0; i < n; ++i)
+	                        Rn.at(i, cn) = R.at(i, c);
+	                    ++cn;
+	                }
+	                for (arma::uword i = j; i + 1 < n; ++i) {
+	                    const double a = Rn.at(i, i), b = Rn.at(i + 1, i);
+	                    const double r = std::hypot(a, b);
+	                    const double c = a/r, s = b/r;
+	                    for (arma::uword k = i; k < n - 1; ++k) {
+	                        const double t1 = Rn.at(i, k), t2 = Rn.at(i + 1, k);
+	                        Rn.at(i, k) = c*t1 + s*t2;
+	                        Rn.at(i + 1, k) = c*t2 - s*t1;
+	                    }
+	                }
+	                R.set_size(n - 1, n - 1);
+	                for (arma::uword c = 0; c < n - 1; ++c)
+	                    for (arma::uword i = 0; i < n - 1; ++i)
+	                        R.at(i, c) = i <= c ? Rn.at(i, c) : 0.0;
+	            }
 	        } // End namespace btk_utils
 
 	        /** \brief Simple BTKParameter class with constant temperature gradient
@@ -228,6 +288,79 @@ namespace shyft {
 	        };
 
 
+	        /** \brief btk_reduced_operators are the operators of the bayesian temperature kriging for a subset of the sources
+	         * \sa btk_operators
+	         */
+	        struct btk_reduced_operators {
+	            arma::mat F;///< elevation matrix of the sources
+	            arma::mat E_beta_w, omega, GH_inv, BM;///< beta_est_weights, krig_weights, and prior/posterior operators
+	        };
+
+	        /** \brief btk_operators keeps the operators of the bayesian temperature kriging that depends only on
+	         * the locations of the sources and destinations and the parameters, not on the temperatures.
+	         * \sa build_btk_operators, btk_interpolation
+	         */
+	        struct btk_operators : btk_reduced_operators {
+	            arma::mat f;///< elevation matrix of the destinations
+	            arma::mat K, k;///< covariance matrices source-source and source-destination
+	            arma::mat R;///< upper cholesky factor of K, so that K = R.t()*R
+	        };
+
+	        /** \brief compute the operators for the sources v, given R, the upper cholesky factor of K for those sources
+	         *
+	         * The inverse of K is never formed, instead K^-1 X is computed by triangular solves with R.
+	         */
+	        template<class P>
+	        btk_reduced_operators btk_subset_operators(const btk_operators& op, const std::vector<arma::uword>& v, const arma::mat& R, const P& parameter) {
+	            btk_reduced_operators r;
+	            arma::mat22 H, H_inv, G, G_inv;
+	            arma::mat22 eye22 = arma::diagmat(arma::vec(2, arma::fill::ones));
+	            arma::uvec sub_idx(v);
+	            r.F = op.F.rows(sub_idx);
+	            arma::mat A = r.F;// R^-T F
+	            utils::solve_upper_t(R, A);
+	            arma::mat B = op.k.rows(sub_idx);// R^-T k
+	            utils::solve_upper_t(R, B);
+	            H_inv = A.t()*A;// F.t() K^-1 F
+	            if (arma::rank(H_inv) == 1) {
+	                throw std::runtime_error("The bayestian temperature kriging algorithm needs at least two sources at different heights.");
+	            }
+	            H = H_inv.i();
+	            G_inv = H_inv;
+	            G_inv.at(1, 1) += 1/(parameter.temperature_gradient_sd()*parameter.temperature_gradient_sd());
+	            G = G_inv.i();
+	            r.GH_inv = G*H_inv;
+	            r.BM = (op.f - A.t()*B).t()*(eye22 - r.GH_inv);
+	            arma::mat W = A*H.t();// (H F.t() K^-1).t() = R^-1 R^-T F H.t()
+	            utils::solve_upper(R, W);
+	            r.E_beta_w = W.t(); // beta_est_weights
+	            utils::solve_upper(R, B);// (k.t() K^-1).t() = R^-1 R^-T k
+	            r.omega = B.t();    // krig_weights
+	            return r;
+	        }
+
+	        /** \brief build the btk_operators for the sources, destinations and parameter
+	         * \throw runtime_error if the sources are not at two or more different heights
+	         * \sa btk_interpolation for requirements to the template parameters
+	         */
+	        template<class S, class D, class P>
+	        btk_operators build_btk_operators(S source_begin, S source_end,
+	                                          D destination_begin, D destination_end, const P& parameter)
+	        {
+	            btk_operators op;
+	            // Gather spatial data for all stations and destinations
+	            utils::build_elevation_matrices(source_begin, source_end, destination_begin, destination_end, op.F, op.f);
+	            utils::build_covariance_matrices(source_begin, source_end, destination_begin, destination_end, parameter, op.K, op.k);
+	            if (!arma::chol(op.R, op.K))
+	                throw std::runtime_error("bayesian kriging temperature: the covariance matrix is not positive definite, check sill and nugget parameters");
+	            // Build full operators
+	            std::vector<arma::uword> all(op.F.n_rows);
+	            for (arma::uword i = 0; i < all.size(); ++i)
+	                all[i] = i;
+	            static_cast<btk_reduced_operators&>(op) = btk_subset_operators(op, all, op.R, parameter);
+	            return op;
+	        }
+
 	        /** \brief Bayesian Temperature Kriging Interpolation
 	         *
 	         * Extracted from the Enki method BayesTKrig by Sjur Kolberg/Sintef.
@@ -274,63 +407,54 @@ namespace shyft {
 	         *       TODO: Should this be a time series?
 	         *   \sa BTKConstParameter \sa BTKParameter
 	         *
+	         * \param start_step the first time-step to interpolate
+	         * \param n_steps number of time-steps to interpolate, the destinations are set for [start_step..start_step+n_steps>
+	         * \param op the operators, as built by build_btk_operators for the same sources, destinations and parameter
 	         */
 	        template<class TSA, class S, class D, class T, class P>
 	        void btk_interpolation(S source_begin, S source_end,
 	                              D destination_begin, D destination_end,
-	                              const T& time_axis, const P& parameter)
+	                              const T& time_axis, const P& parameter,
+	                              size_t start_step, size_t n_steps, const btk_operators& op)
 	        {
 	            // Armadillo's notion of submatrix views are used for slicing out portions of F, k, and K
 	            // to minimize the number of matrix allocations.
 
 	            // Allocate matrices of known sizes:
-	            arma::mat22 H, H_inv, G, G_inv, GH_inv;
 	            arma::mat::fixed<2,1> E_beta_pri, E_beta_w_pri,/* E_beta_post,*/ beta_hat;
 	            // These matrices sizes vary with the number valid sources and the number of destinations.
-	            arma::mat K, k, F, f, K_inv, E_beta_w, omega, BM, T_obs, E_temp_post;
+	            arma::mat T_obs, E_temp_post;
 
 	            // Prior data
 	            E_beta_pri(0, 0) = 0.0; // Old code says this is ok. TODO: Check assumption.
 	            arma::mat22 eye22 = arma::diagmat(arma::vec(2, arma::fill::ones));
 
-	            // Gather spatial data for all stations and destinations
-	            utils::build_elevation_matrices(source_begin, source_end, destination_begin, destination_end, F, f);
-	            utils::build_covariance_matrices(source_begin, source_end, destination_begin, destination_end, parameter, K, k);
-
-	            // Build full operators
-
-	            K_inv = K.i();
-	            H_inv = F.t()*K_inv*F;
-	            if (arma::rank(H_inv) == 1) {
-	                throw std::runtime_error("The bayestian temperature kriging algorithm needs at least two sources at different heights.");
-	            }
-	            H = H_inv.i();
-	            G_inv = H_inv;
-	            G_inv.at(1, 1) += 1/(parameter.temperature_gradient_sd()*parameter.temperature_gradient_sd());
-	            G = G_inv.i();
-	            GH_inv = G*H_inv;
-	            BM = (f - F.t()*K_inv*k).t()*(eye22 - GH_inv);
-	            E_beta_w = H*F.t()*K_inv; // beta_est_weights
-	            omega = k.t()*K_inv;    // krig_weights
-	            // Reduced matrices
-	            arma::mat F_r, E_beta_w_r, omega_r, GH_inv_r, BM_r;
+	            // Reduced operators, for the most recently used patterns of valid sources
+	            typedef std::list<std::pair<std::vector<arma::uword>, btk_reduced_operators>> reduced_list_t;
+	            const size_t max_reduced = 32;
+	            reduced_list_t reduced;// most recently used first
+	            std::map<std::vector<arma::uword>, reduced_list_t::iterator> reduced_ix;
 
-	            // Matrix pointers used in the time loop
-	            arma::mat *F_p=nullptr, *E_beta_w_p=nullptr, *omega_p=nullptr, *GH_inv_p=nullptr, *BM_p=nullptr;
+	            // Operators used in the time loop
+	            const btk_reduced_operators* op_p = nullptr;
 
 	            const size_t num_sources = std::distance(source_begin, source_end);
+	            if (op.F.n_rows != num_sources || op.f.n_cols != (arma::uword)std::distance(destination_begin, destination_end))
+	                throw std::runtime_error("bayesian kriging temperature: operators does not match sources and destinations");
 	            std::vector<TSA> source_accessors;
 	            source_accessors.reserve(num_sources);
 	            std::for_each(source_begin, source_end, [&] (const typename S::value_type& source)
 	                          { source_accessors.emplace_back(TSA(source.temperatures(), time_axis)); });
 	            // Time step loop
-	            const size_t num_timesteps = time_axis.size();
+	            if (start_step + n_steps > time_axis.size())
+	                throw std::runtime_error("bayesian kriging temperature: step range outside time-axis");
+	            const size_t num_timesteps = start_step + n_steps;
 	            std::vector<double> temperatures;
 	            temperatures.reserve(num_sources);
 
 	            std::vector<arma::uword> valid_inds, prev_valid_inds;
 	            valid_inds.reserve(num_sources);
-	            for (size_t t_step=0; t_step < num_timesteps; ++t_step) {
+	            for (size_t t_step=start_step; t_step < num_timesteps; ++t_step) {
 	                temperatures.clear();
 	                prev_valid_inds = valid_inds;
 	                valid_inds.clear();
@@ -350,47 +474,50 @@ namespace shyft {
 	                    }
 	                    if (valid_inds.size() == num_sources) {
 	                        // Use full operators
-	                        F_p = &F;
-	                        E_beta_w_p = &E_beta_w;
-	                        omega_p = &omega;
-	                        GH_inv_p = &GH_inv;
-	                        BM_p = &BM;
+	                        op_p = &op;
 	                    } else {
-	                        // Build new reduced operators from full operators
-	                        arma::uvec sub_idx(valid_inds);
-	                        F_r = F.rows(sub_idx);
-							K_inv = K.submat(sub_idx, sub_idx).i();
-	                        H_inv = F_r.t()*K_inv*F_r;
-	                        H = H_inv.i();
-	                        G_inv = H_inv;
-	                        G_inv(1, 1) += 1/(parameter.temperature_gradient_sd()*parameter.temperature_gradient_sd());
-	                        G = G_inv.i();
-	                        GH_inv_r = G*H_inv;
-	                        arma::mat k_red = k.rows(sub_idx);
-	                        BM_r = (f - F_r.t()*K_inv*k_red).t()*(eye22 - GH_inv_r);
-	                        E_beta_w_r = H*F_r.t()*K_inv; // beta_est_weights
-	                        omega_r = k_red.t()*K_inv;    // krieg_weights
-	                        // Assign pointers
-	                        F_p = &F_r;
-	                        E_beta_w_p = &E_beta_w_r;
-	                        omega_p = &omega_r;
-	                        GH_inv_p = &GH_inv_r;
-	                        BM_p = &BM_r;
+	                        auto f = reduced_ix.find(valid_inds);
+	                        if (f != reduced_ix.end()) {
+	                            reduced.splice(reduced.begin(), reduced, f->second);
+	                        } else {
+	                            // The factor of K for the valid sources, by removing the missing from the full factor,
+	                            // or by a new factorization if that is cheaper (many missing sources)
+	                            arma::mat R_r;
+	                            const double n = double(num_sources), n_v = double(valid_inds.size());
+	                            if ((n - n_v)*n*n < n_v*n_v*n_v/3.0) {
+	                                R_r = op.R;
+	                                for (size_t i = num_sources, v = valid_inds.size(); i-- > 0;) {
+	                                    if (v > 0 && valid_inds[v - 1] == i) --v;
+	                                    else utils::chol_delete(R_r, (arma::uword)i);
+	                                }
+	                            } else {
+	                                arma::uvec sub_idx(valid_inds);
+	                                if (!arma::chol(R_r, op.K.submat(sub_idx, sub_idx)))
+	                                    throw std::runtime_error("bayesian kriging temperature: the covariance matrix is not positive definite");
+	                            }
+	                            reduced.emplace_front(valid_inds, btk_subset_operators(op, valid_inds, R_r, parameter));
+	                            reduced_ix[valid_inds] = reduced.begin();
+	                            if (reduced.size() > max_reduced) {
+	                                reduced_ix.erase(reduced.back().first);
+	                                reduced.pop_back();
+	                            }
+	                        }
+	                        op_p = &reduced.front().second;
 	                    }
 	                }
 
 	                // Build prior data for time step:
 	                E_beta_pri(1, 0) = parameter.temperature_gradient(time_axis.period(t_step));
-	                E_beta_w_pri = ((eye22 - *GH_inv_p)*E_beta_pri);
+	                E_beta_w_pri = ((eye22 - op_p->GH_inv)*E_beta_pri);
 
 	                // Fill T_obs with valid temperatures
 	                T_obs.set_size((arma::uword)valid_inds.size(), 1);
 	                std::copy(std::begin(temperatures), std::end(temperatures), T_obs.begin_col(0));
 	                // Core computational work here:
-	                beta_hat = (*E_beta_w_p)*T_obs;
-	                arma::mat T_hat = f.t()*beta_hat + (*omega_p)*(T_obs - (*F_p)*beta_hat);
-	                //E_beta_post = (*GH_inv_p)*beta_hat + E_beta_w_pri;
-	                E_temp_post = arma::vec(T_hat - (*BM_p)*(beta_hat - E_beta_pri));
+	                beta_hat = op_p->E_beta_w*T_obs;
+	                arma::mat T_hat = op.f.t()*beta_hat + op_p->omega*(T_obs - op_p->F*beta_hat);
+	                //E_beta_post = op_p->GH_inv*beta_hat + E_beta_w_pri;
+	                E_temp_post = arma::vec(T_hat - op_p->BM*(beta_hat - E_beta_pri));
 
 	                arma::uword dist = 0;
 	                for (D d=destination_begin; d != destination_end; ++d)
@@ -398,6 +525,26 @@ namespace shyft {
 
 	            }
 	        }
+
+	        /** \brief btk_interpolation for a range of time-steps, building the operators */
+	        template<class TSA, class S, class D, class T, class P>
+	        void btk_interpolation(S source_begin, S source_end,
+	                              D destination_begin, D destination_end,
+	                              const T& time_axis, const P& parameter,
+	                              size_t start_step, size_t n_steps)
+	        {
+	            auto op = build_btk_operators(source_begin, source_end, destination_begin, destination_end, parameter);
+	            btk_interpolation<TSA>(source_begin, source_end, destination_begin, destination_end, time_axis, parameter, start_step, n_steps, op);
+	        }
+
+	        /** \brief btk_interpolation for all the time-steps of the time_axis */
+	        template<class TSA, class S, class D, class T, class P>
+	        void btk_interpolation(S source_begin, S source_end,
+	                              D destination_begin, D destination_end,
+	                              const T& time_axis, const P& parameter)
+	        {
+	            btk_interpolation<TSA>(source_begin, source_end, destination_begin, destination_end, time_axis, parameter, 0, time_axis.size());
+	        }
 		}
     } // End namespace core
 } // End namespace shyft
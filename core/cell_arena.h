@@ -0,0 +1,245 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#include "time_series.h"
+#include "cell_model.h"
+
+namespace shyft {
+    namespace core {
+
+        /** \brief ts_arena is one contiguous block of values, shared by many arena_ts
+         *
+         * Typically the block is a 2-D array, cells x time-steps, one row pr. cell,
+         * so that the series of all the cells of a region_model is one allocation,
+         * and each series is a contiguous row, as the cell method stacks read it.
+         */
+        struct ts_arena {
+            std::vector<double> v;
+            explicit ts_arena(size_t n, double fill_value = shyft::nan) : v(n, fill_value) {}
+            size_t size() const { return v.size(); }
+            double* data() { return v.data(); }
+        };
+
+        /** \brief a fixed time-axis point time-series, keeping its values in a row of a ts_arena
+         *
+         * Provides the point_ts interface used by the cells, interpolation and method stacks,
+         * but the values are a view into a ts_arena, that could be shared with the other cells.
+         *
+         * Value semantics as point_ts:
+         *  -# a copy is a deep copy, with its own arena, so copies of cells or models never share values,
+         *     env_arena::copy_binding gives a copied vector of cells one common arena again
+         *  -# assignment to a ts with the same time-axis copies the values into the current storage,
+         *     so that the row binding established by bind() is kept
+         *  -# move keeps the binding (so that a vector of cells can grow)
+         *
+         * \tparam TA time-axis, like time_axis::fixed_dt
+         * \sa env_arena
+         */
+        template <class TA>
+        struct arena_ts {
+            typedef TA ta_t;
+            TA ta;
+            ts_point_fx fx_policy = POINT_INSTANT_VALUE;
+
+            arena_ts() = default;
+            arena_ts(const TA& ta, double fill_value, ts_point_fx fx_policy = POINT_INSTANT_VALUE)
+              : ta(ta), fx_policy(fx_policy), arena(std::make_shared<ts_arena>(ta.size(), fill_value)), v(arena->data()) {}
+            explicit arena_ts(const point_ts<TA>& o)
+              : ta(o.ta), fx_policy(o.fx_policy), arena(std::make_shared<ts_arena>(o.ta.size())), v(arena->data()) {
+                std::copy(begin(o.v), end(o.v), v);
+            }
+            arena_ts(const arena_ts& o) : ta(o.ta), fx_policy(o.fx_policy) {
+                if (o.v) {
+                    arena = std::make_shared<ts_arena>(o.size());
+                    v = arena->data();
+                    std::copy(o.v, o.v + o.size(), v);
+                }
+            }
+            arena_ts(arena_ts&& o) noexcept : ta(std::move(o.ta)), fx_policy(o.fx_policy), arena(std::move(o.arena)), v(o.v) { o.v = nullptr; }
+
+            arena_ts& operator=(const arena_ts& o) {
+                if (this != &o) {
+                    if (v && o.v && ta == o.ta) {
+                        std::copy(o.v, o.v + o.size(), v);
+                    } else {
+                        arena_ts c(o);
+                        swap(c);
+                    }
+                    fx_policy = o.fx_policy;
+                }
+                return *this;
+            }
+            arena_ts& operator=(arena_ts&& o) {
+                if (this != &o) {
+                    if (v && o.v && ta == o.ta) {
+                        std::copy(o.v, o.v + o.size(), v);
+                        fx_policy = o.fx_policy;
+                    } else {
+                        swap(o);
+                    }
+                }
+                return *this;
+            }
+            void swap(arena_ts& o) {
+                std::swap(ta, o.ta);
+                std::swap(fx_policy, o.fx_policy);
+                std::swap(arena, o.arena);
+                std::swap(v, o.v);
+            }
+
+            /** bind the ts to ta.size() values of the arena, starting at offset, the values are left as is */
+            void bind(const std::shared_ptr<ts_arena>& a, size_t offset, const TA& ta_) {
+                if (offset + ta_.size() > a->size())
+                    throw std::runtime_error("arena_ts: bind outside arena");
+                ta = ta_;
+                arena = a;
+                v = a->data() + offset;
+            }
+            const std::shared_ptr<ts_arena>& get_arena() const { return arena; }
+            const double* data() const { return v; }
+            double* data() { return v; }
+
+            bool operator==(const arena_ts& o) const { return ta == o.ta && fx_policy == o.fx_policy && (v == o.v || (v && o.v && std::equal(v, v + size(), o.v))); }
+            ts_point_fx point_interpretation() const { return fx_policy; }
+            void set_point_interpretation(ts_point_fx point_interpretation) { fx_policy = point_interpretation; }
+            const TA& time_axis() const { return ta; }
+
+            /**\brief the function value f(t) at time t, fx_policy taken into account, as point_ts */
+            double operator()(utctime t) const {
+                size_t i = ta.index_of(t);
+                if (i == string::npos) return nan;
+                if (fx_policy == ts_point_fx::POINT_INSTANT_VALUE && i + 1 < ta.size() && isfinite(v[i + 1])) {
+                    utctime t1 = ta.time(i);
+                    utctime t2 = ta.time(i + 1);
+                    double f = double(t2 - t)/double(t2 - t1);
+                    return v[i]*f + (1.0 - f)*v[i + 1];
+                }
+                return v[i];
+            }
+            double value(size_t i) const { return v[i]; }
+            vector<double> values() const { return vector<double>(v, v + size()); }
+            size_t size() const { return ta.size(); }
+            size_t index_of(utctime t) const { return ta.index_of(t); }
+            utcperiod total_period() const { return ta.total_period(); }
+            utctime time(size_t i) const { return ta.time(i); }
+            point get(size_t i) const { return point(ta.time(i), value(i)); }
+            point_ts<TA> as_point_ts() const { return point_ts<TA>(ta, values(), fx_policy); }
+
+            void set(size_t i, double x) { v[i] = x; }
+            void add(size_t i, double value) { v[i] += value; }
+            void fill(double value) { std::fill(v, v + size(), value); }
+            void fill_range(double value, int start_step, int n_steps) { if (n_steps == 0) fill(value); else std::fill(v + start_step, v + start_step + n_steps, value); }
+            void scale_by(double value) { std::for_each(v, v + size(), [value](double& x) { x *= value; }); }
+
+          private:
+            std::shared_ptr<ts_arena> arena;///< keeps the storage alive
+            double* v = nullptr;///< the first value, ta.size() values
+        };
+
+        typedef arena_ts<time_axis::fixed_dt> arena_pts_t;
+
+        ///< environment variant with all series in a common ts_arena when used in a region_model, \ref env_arena
+        typedef environment<timeaxis_t, arena_pts_t, arena_pts_t, arena_pts_t, arena_pts_t, arena_pts_t> environment_arena_t;
+
+        /** \brief env_arena binds the environment series of all cells to one ts_arena
+         *
+         * The default for other environment types is to do nothing, returning false,
+         * so that the caller initializes each cell as usual.
+         */
+        template <class E>
+        struct env_arena {
+            static const bool supported = false;
+            template <class C>
+            static bool bind(std::vector<C>&, const typename E::timeaxis_t&) { return false; }
+            template <class C>
+            static void copy_binding(const std::vector<C>&, std::vector<C>&) {}
+        };
+
+        /** \brief env_arena for environment_arena_t
+         *
+         * The arena keeps one block pr. env. variable, each block is n_cells x n_steps, one row pr. cell.
+         * The rows favour run_cells, where each cell reads its own series step by step.
+         * The interpolation computes one time-step for all the cells, so it writes with a stride of n_steps,
+         * as it does with separate point_ts.
+         * If the cells are already bound with the same time-axis, the arena is reused.
+         */
+        template <class TA>
+        struct env_arena<environment<TA, arena_ts<TA>, arena_ts<TA>, arena_ts<TA>, arena_ts<TA>, arena_ts<TA>>> {
+            static const bool supported = true;
+
+            template <class C>
+            static bool bind(std::vector<C>& cells, const TA& ta) {
+                const size_t n = ta.size();
+                const size_t n_cells = cells.size();
+                if (n_cells == 0)
+                    return true;
+                if (is_bound(cells, ta)) {
+                    auto a = cells[0].env_ts.temperature.get_arena();
+                    std::fill(a->data(), a->data() + a->size(), shyft::nan);
+                    return true;
+                }
+                bind_rows(cells, std::make_shared<ts_arena>(5*n*n_cells), ta);
+                return true;
+            }
+
+            /** if src is bound to an arena, bind dst, a copy of src, to a new arena with the same layout and values */
+            template <class C>
+            static void copy_binding(const std::vector<C>& src, std::vector<C>& dst) {
+                if (src.empty() || src.size() != dst.size() || !is_bound(src, src[0].env_ts.temperature.ta))
+                    return;
+                const auto& sa = *src[0].env_ts.temperature.get_arena();
+                auto a = std::make_shared<ts_arena>(sa.size());
+                std::copy(sa.v.cbegin(), sa.v.cend(), a->v.begin());
+                bind_rows(dst, a, src[0].env_ts.temperature.ta);
+            }
+
+          private:
+            /** \return true if the cells are bound to rows of one arena, as done by bind_rows, with time-axis ta */
+            template <class C>
+            static bool is_bound(const std::vector<C>& cells, const TA& ta) {
+                const size_t n = ta.size();
+                const size_t block = n*cells.size();
+                auto a = cells[0].env_ts.temperature.get_arena();
+                bool bound = a && a->size() == 5*block && cells[0].env_ts.temperature.ta == ta;
+                for (size_t i = 0; bound && i < cells.size(); ++i) {
+                    const auto& e = cells[i].env_ts;
+                    const double* r = a->data() + i*n;
+                    bound = e.temperature.data() == r && e.precipitation.data() == r + block && e.radiation.data() == r + 2*block
+                         && e.rel_hum.data() == r + 3*block && e.wind_speed.data() == r + 4*block && e.temperature.ta == ta;
+                }
+                return bound;
+            }
+
+            template <class C>
+            static void bind_rows(std::vector<C>& cells, const std::shared_ptr<ts_arena>& a, const TA& ta) {
+                const size_t n = ta.size();
+                const size_t block = n*cells.size();
+                for (size_t i = 0; i < cells.size(); ++i) {
+                    auto& e = cells[i].env_ts;
+                    e.temperature.bind(a, i*n, ta);
+                    e.precipitation.bind(a, block + i*n, ta);
+                    e.radiation.bind(a, 2*block + i*n, ta);
+                    e.rel_hum.bind(a, 3*block + i*n, ta);
+                    e.wind_speed.bind(a, 4*block + i*n, ta);
+                }
+            }
+        };
+    }
+
+    namespace time_series {
+        /** \brief Specialization of direct_accessor for arena_ts, as for point_ts, no time-axis check */
+        template <class TA>
+        class direct_accessor<core::arena_ts<TA>, TA> {
+          private:
+            const core::arena_ts<TA>& source;
+          public:
+            direct_accessor(const core::arena_ts<TA>& source, const TA& ta) : source(source) {}
+            double value(const size_t i) const { return source.value(i); }
+            size_t size() const { return source.size(); }
+        };
+    }
+}
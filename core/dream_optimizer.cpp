@@ -42,7 +42,15 @@ namespace optimizer {
             chain_states[chain].resize(n_parameters);
         }
 
-        vector<double> x_candidates(n_parameters,0.0);	// Temporary vector containing parameter proposals to be evaluated
+        // The chains are developed in groups, where the candidates of a group are evaluated as one batch. If fx supports concurrent
+        // evaluations, the group is all chains, each proposal generated from the chain states at the start of the iteration,
+        // otherwise each chain is a group, and the proposal of a chain sees the chains developed before it in the same iteration.
+        const size_t group_size = fx.concurrency() > 1 ? n_chains : 1;
+        vector<vector<double>> x_candidates(n_chains,vector<double>(n_parameters,0.0));	// Parameter proposals to be evaluated, pr. chain
+        vector<vector<double>> x_batch;	// The proposals of the current group that are inside the allowed box
+        vector<size_t> batch_chains;	// The chain of each proposal in x_batch
+        vector<double> batch_prob;		// The evaluated posterior log-density of each proposal in x_batch
+        vector<size_t> chain_cr(n_chains,0);	// The index of the cr value drawn for each chain in the current group
         vector<double> omega(n_chains,0.0);	// Last-half average log-post-densities for each chain
         vector<int> cr_L(n_cr,0);			// Number of candidates generated for each cr value
         vector<double> cr_D(n_cr,0.0);		// Sum of sq.norm.dist achieved for each cr value
@@ -57,8 +65,9 @@ namespace optimizer {
             for (size_t p = 0; p < n_parameters; ++p) {
                 chain_states[i][p] = random01();
             }
-            chain_prob[i] = fx.evaluate(chain_states[i]);
-
+        }
+        fx.evaluate_batch(chain_states, chain_prob);
+        for (size_t i = 0; i < n_chains; ++i) {
             // Store the best parameter set achieved so far, to serve as diagnostic output,
             // and to replace outlier states during burn-in with the HPD parameter set achieved so far.
             if (chain_prob[i] > fx_optimal) {
@@ -137,24 +146,27 @@ namespace optimizer {
                 x_variance[parameter] -= pow(mean, 2); // Variance of par[j] over chains
             }
 
-            // Develop the MCMC chain with index 'chain'
-            for (size_t chain = 0; chain < n_chains; ++chain) {
-                double jump_distance = 0; // The distance between previous (existing) parameter set and the new parameter set (accepted candidate) - squared and scaled by the previous-iter inter-chain posterior variance.
-                if (doing_burnin && outliers && omega[chain] < log_x_limit) {
-                    // This chain is an outlier; replace the chain states with the currently best parameter set and prob.
-                    // Chains with both current and average llh (log-likelihood) lower than Q1-2*(Q3-Q1) will be aborted and
-                    // restarted at the highest-probability state found so far in any chain.
-                    for (size_t i = 0; i < n_parameters; ++i) {
-                        // First calculate jump distance between the new candidates (the currently best
-                        // parameter set) and the existing parameter set for the chain.
-                        jump_distance += pow(chain_states[chain][i] - x[i], 2) / x_variance[i];
-                        // Then set the new candidate (current best) as the current values.
-                        chain_states[chain][i] = x[i];
+            // Develop the MCMC chains in groups [c0..c1>, ref. group_size above
+            for (size_t c0 = 0; c0 < n_chains; c0 += group_size) {
+                const size_t c1 = min(n_chains, c0 + group_size);
+                x_batch.clear();
+                batch_chains.clear();
+                // Replace outlier chains, and generate the candidates of the group
+                for (size_t chain = c0; chain < c1; ++chain) {
+                    if (doing_burnin && outliers && omega[chain] < log_x_limit) {
+                        // This chain is an outlier; replace the chain states with the currently best parameter set and prob.
+                        // Chains with both current and average llh (log-likelihood) lower than Q1-2*(Q3-Q1) will be aborted and
+                        // restarted at the highest-probability state found so far in any chain.
+                        for (size_t i = 0; i < n_parameters; ++i) {
+                            // Set the new candidate (current best) as the current values,
+                            // the jump distance is not used for outliers.
+                            chain_states[chain][i] = x[i];
+                        }
+                        chain_prob[chain] = fx_optimal;
+                        n_burnins = iteration_count + min_burnins;
+                        ++n_outliers;
+                        continue;
                     }
-                    chain_prob[chain] = fx_optimal;
-                    n_burnins = iteration_count + min_burnins;
-                    ++n_outliers;
-                } else {
                     // No outlier, perform as normal.
 
                     // Draw a random cross-over probability (cr).
@@ -171,17 +183,18 @@ namespace optimizer {
                             break;
                         ++i_cr;
                     }
+                    chain_cr[chain] = i_cr;
                     double cr = (double) (i_cr + 1) / (double) n_cr; // Individual-parameter cross-over probability (the cr value)
 
                     // Generate a candidate point for chain chain by adding up k difference-vectors
                     // between randomly selected pairs of the other chains
                     size_t d_eff = 0; // Number of actually changed parameter components
-                    generate_candidate_parameters(x_candidates, chain, n_chains, n_parameters, cr, d_eff, chain_states);
+                    generate_candidate_parameters(x_candidates[chain], chain, n_chains, n_parameters, cr, d_eff, chain_states);
 
                     // Check if the candidate point is legal or must be rejected
                     bool reject = false;
                     for (size_t i = 0; i < n_parameters; ++i) {
-                        if (x_candidates[i] < 0 || x_candidates[i] > 1) {
+                        if (x_candidates[chain][i] < 0 || x_candidates[chain][i] > 1) {
                             // Parameter value is outside it's limits
                             reject = true;
                             break;
@@ -195,8 +208,22 @@ namespace optimizer {
                         ++n_pri_rejected;
                     } else {
                         // The proposal is inside the allowed box, we must run the model to evaluate likelihood
-                        // Evaluate the posterior log-density for the candidate parameters, EvalModel provides the likelihood part.
-                        double cand_prob = fx.evaluate(x_candidates);
+                        x_batch.push_back(x_candidates[chain]);
+                        batch_chains.push_back(chain);
+                    }
+                }
+
+                // Evaluate the posterior log-density for the candidate parameters, EvalModel provides the likelihood part.
+                fx.evaluate_batch(x_batch, batch_prob);
+
+                // The Metropolis step, in chain order
+                for (size_t chain = c0, b = 0; chain < c1; ++chain) {
+                    if (doing_burnin && outliers && omega[chain] < log_x_limit)
+                        continue;// replaced above
+                    double jump_distance = 0; // The distance between previous (existing) parameter set and the new parameter set (accepted candidate) - squared and scaled by the previous-iter inter-chain posterior variance.
+                    if (b < batch_chains.size() && batch_chains[b] == chain) {
+                        const double cand_prob = batch_prob[b++];
+                        const vector<double>& x_candidate = x_candidates[chain];
 
                         // If the new candidate parameters results in better results (higher posterior log-density) than
                         // the previous results for the same chain, the candidates will be accepted and become the
@@ -224,9 +251,9 @@ namespace optimizer {
                             for (size_t i = 0; i < n_parameters; ++i) {
                                 // Calculate jump distance between the new (now accepted) candidate parameter set
                                 // and the existing (previous) parameter set for the chain.
-                                jump_distance += pow(chain_states[chain][i] - x_candidates[i], 2) / x_variance[i];
+                                jump_distance += pow(chain_states[chain][i] - x_candidate[i], 2) / x_variance[i];
                                 // Make the accepted candidate parameter set the current parameter set for the chain
-                                chain_states[chain][i] = x_candidates[i];
+                                chain_states[chain][i] = x_candidate[i];
                             }
 
                             // Store the best parameter set achieved so far, to serve as diagnostic output,
@@ -240,12 +267,11 @@ namespace optimizer {
 
                     // Update the count and dist for cr value m.
                     if (doing_burnin) {
-                        cr_L[i_cr]++; // Number of candidates generated for cr value m (i_cr)
-                        cr_D[i_cr] += jump_distance; // If accepted (only then jump_distance is > 0), alter sum of sq.norm.dist achieved for cr value m (i_cr)
+                        cr_L[chain_cr[chain]]++; // Number of candidates generated for cr value m (i_cr)
+                        cr_D[chain_cr[chain]] += jump_distance; // If accepted (only then jump_distance is > 0), alter sum of sq.norm.dist achieved for cr value m (i_cr)
                     }
-
-                } // Non-outlier block
-            } // for (int chain=0; chain<n_chains; chain++) // End single-chain development.
+                } // Metropolis step
+            } // for (size_t c0=0; c0<n_chains; c0 += group_size) // End chain development.
 
 
             if (doing_burnin) {
@@ -3,6 +3,13 @@
 #include "core_serialization.h"
 #include "expression_serialization.h"
 #include "core_archive.h"
+#include "dtss_wire.h"
+#include <sstream>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <dlib/sockstreambuf.h>
 namespace shyft {
 namespace dtss {
 
@@ -233,6 +240,22 @@ server::do_evaluate_ts_vector(utcperiod bind_period, ts_vector_t& atsv,bool use_
     return ts_vector_t{deflate_ts_vector<apoint_ts>(atsv)};
 }
 
+void
+server::do_evaluate_ts_vector_chunked(utcperiod bind_period, ts_vector_t& atsv,bool use_ts_cached_read,bool update_ts_cache,
+                                      size_t chunk_size,const std::function<void(const ts_vector_t&)>& fx) {
+    do_bind_ts(bind_period, atsv,use_ts_cached_read,update_ts_cache);
+    chunk_size=std::max(chunk_size,size_t(1));
+    for(size_t i0=0;i0<atsv.size();i0+=chunk_size) {
+        size_t n=std::min(chunk_size,atsv.size()-i0);
+        ts_vector_t c;c.reserve(n);
+        for(size_t i=i0;i<i0+n;++i) {
+            c.push_back(atsv[i]);
+            atsv[i]=apoint_ts();// release the expression as soon as the chunk is done
+        }
+        fx(ts_vector_t{deflate_ts_vector<apoint_ts>(c)});
+    }
+}
+
 ts_vector_t
 server::do_evaluate_percentiles(utcperiod bind_period, ts_vector_t& atsv, gta_t const&ta, vector<int64_t> const& percentile_spec,bool use_ts_cached_read,bool update_ts_cache) {
     do_bind_ts(bind_period, atsv,use_ts_cached_read,update_ts_cache);
@@ -240,6 +263,193 @@ server::do_evaluate_percentiles(utcperiod bind_period, ts_vector_t& atsv, gta_t
     return percentiles(atsv, ta, p_spec);// we can assume the result is trivial to serialize
 }
 
+void server::handle_message(message_type msg_type, std::istream& in, std::ostream& out, int32_t wire_format, std::mutex* out_mx) {
+    // with an out_mx, each reply frame is composed in a buffer, and written to out holding the lock,
+    // so that replies of concurrent requests on the connection are not interleaved, while evaluation is not serialized
+    std::ostringstream buf;
+    std::ostream& frame = out_mx ? static_cast<std::ostream&>(buf) : out;
+    auto send_frame = [&out, &buf, out_mx]() {
+        if (out_mx) {
+            std::lock_guard<std::mutex> lock(*out_mx);
+            out << buf.str();
+            out.flush();
+            buf.str(std::string());
+        } else {
+            out.flush();
+        }
+    };
+    try { // scoping the binary-archive could be ok, since it forces destruction time (considerable) to taken immediately, reduce memory foot-print early
+          //  at the cost of early& fast response. I leave the commented scopes in there for now, and aim for fastest response-time
+        switch (msg_type) { // currently switch, later maybe table[msg_type]=msg_handler
+        case message_type::EVALUATE_TS_VECTOR:
+        case message_type::EVALUATE_EXPRESSION:{
+            utcperiod bind_period;bool use_ts_cached_read,update_ts_cache;
+            ts_vector_t rtsv;
+            core_iarchive ia(in,core_arch_flags);
+            ia>>bind_period;
+            if(msg_type==message_type::EVALUATE_EXPRESSION) {
+                compressed_ts_expression c_expr;
+                ia>>c_expr;
+                rtsv=expression_decompressor::decompress(c_expr);
+            } else {
+                ia>>rtsv;
+            }
+            ia>>use_ts_cached_read>>update_ts_cache;
+            auto result=do_evaluate_ts_vector(bind_period, rtsv,use_ts_cached_read,update_ts_cache);//first get result
+            msg::write_type(message_type::EVALUATE_TS_VECTOR,frame);// then send
+            wire::write_reply(result,wire_format,frame);
+
+        } break;
+        case message_type::EVALUATE_TS_VECTOR_CHUNKED:
+        case message_type::EVALUATE_EXPRESSION_CHUNKED:{
+            utcperiod bind_period;bool use_ts_cached_read,update_ts_cache;
+            int64_t chunk_size;
+            ts_vector_t rtsv;{
+                core_iarchive ia(in,core_arch_flags);
+                ia>>bind_period;
+                if(msg_type==message_type::EVALUATE_EXPRESSION_CHUNKED) {
+                    compressed_ts_expression c_expr;
+                    ia>>c_expr;
+                    rtsv=expression_decompressor::decompress(c_expr);
+                } else {
+                    ia>>rtsv;
+                }
+                ia>>use_ts_cached_read>>update_ts_cache>>chunk_size;
+            }
+            int64_t n_ts=rtsv.size();
+            msg::write_type(message_type::EVALUATE_TS_VECTOR_CHUNKED,frame);{
+                core_oarchive oa(frame,core_arch_flags);
+                oa<<n_ts;
+            }
+            // each chunk is sent as soon as it is evaluated, an exception is sent instead of the next chunk
+            do_evaluate_ts_vector_chunked(bind_period,rtsv,use_ts_cached_read,update_ts_cache,size_t(std::max(chunk_size,int64_t(1))),
+                [&frame,&send_frame,wire_format](const ts_vector_t& chunk) {
+                    msg::write_type(message_type::EVALUATE_TS_VECTOR_CHUNKED,frame);
+                    wire::write_reply(chunk,wire_format,frame);
+                    send_frame();
+                }
+            );
+        } break;
+        case message_type::EVALUATE_EXPRESSION_PERCENTILES:
+        case message_type::EVALUATE_TS_VECTOR_PERCENTILES: {
+            utcperiod bind_period;bool use_ts_cached_read,update_ts_cache;
+            ts_vector_t rtsv;
+            vector<int64_t> percentile_spec;
+            gta_t ta;
+            core_iarchive ia(in,core_arch_flags);
+            ia >> bind_period;
+            if(msg_type==message_type::EVALUATE_EXPRESSION_PERCENTILES) {
+                compressed_ts_expression c_expr;
+                ia>>c_expr;
+                rtsv=expression_decompressor::decompress(c_expr);
+            } else {
+                ia>>rtsv;
+            }
+
+            ia>>ta>>percentile_spec>>use_ts_cached_read>>update_ts_cache;
+
+            auto result = do_evaluate_percentiles(bind_period, rtsv,ta,percentile_spec,use_ts_cached_read,update_ts_cache);//{
+            msg::write_type(message_type::EVALUATE_TS_VECTOR_PERCENTILES, frame);
+            wire::write_reply(result,wire_format,frame);
+        } break;
+        case message_type::FIND_TS: {
+            string search_expression; //{
+            search_expression = msg::read_string(in);// >> search_expression;
+            auto find_result = do_find_ts(search_expression);
+            msg::write_type(message_type::FIND_TS, frame);
+            core_oarchive oa(frame,core_arch_flags);
+            oa << find_result;
+        } break;
+        case message_type::STORE_TS: {
+            ts_vector_t rtsv;
+            bool overwrite_on_write{ true };
+            bool cache_on_write{ false };
+            core_iarchive ia(in,core_arch_flags);
+            ia >> rtsv >> overwrite_on_write >> cache_on_write;
+            do_store_ts(rtsv, overwrite_on_write, cache_on_write);
+            msg::write_type(message_type::STORE_TS, frame);
+        } break;
+        case message_type::MERGE_STORE_TS: {
+            ts_vector_t rtsv;
+            bool cache_on_write{ false };
+            core_iarchive ia(in,core_arch_flags);
+            ia >> rtsv >> cache_on_write;
+            do_merge_store_ts(rtsv, cache_on_write);
+            msg::write_type(message_type::MERGE_STORE_TS, frame);
+        } break;
+        case message_type::CACHE_FLUSH: {
+            flush_cache();
+            clear_cache_stats();
+            msg::write_type(message_type::CACHE_FLUSH,frame);
+        } break;
+        case message_type::CACHE_STATS: {
+            auto cs = get_cache_stats();
+            msg::write_type(message_type::CACHE_STATS,frame);
+            core_oarchive oa(frame,core_arch_flags);
+            oa<<cs;
+        } break;
+        default:
+            throw runtime_error(string("Server got unknown message type:") + std::to_string((int)msg_type));
+        }
+    } catch (std::exception const& e) {
+        msg::send_exception(e,frame);
+    }
+    send_frame();
+}
+
+namespace {
+/** \brief minimal fixed size worker pool for pipelined requests of one connection
+ *
+ * jobs are executed in posted order by the first available worker,
+ * the destructor waits for all posted jobs to complete.
+ */
+struct worker_pool {
+    explicit worker_pool(size_t n) {
+        for(size_t i=0;i<std::max(n,size_t(1));++i)
+            workers.emplace_back([this]() { work(); });
+    }
+    ~worker_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mx);
+            done=true;
+        }
+        cv.notify_all();
+        for(auto& w:workers)
+            w.join();
+    }
+    void post(std::function<void()>&& job) {
+        {
+            std::lock_guard<std::mutex> lock(mx);
+            jobs.emplace_back(std::move(job));
+        }
+        cv.notify_one();
+    }
+private:
+    void work() {
+        for(;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mx);
+                cv.wait(lock,[this]() {return done || jobs.size()>0;});
+                if(jobs.size()==0)
+                    return;// done, and all jobs drained
+                job=std::move(jobs.front());
+                jobs.pop_front();
+            }
+            try {
+                job();
+            } catch(...) {// the job reports its own errors to the client, here the connection is gone
+            }
+        }
+    }
+    std::mutex mx;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> workers;
+    bool done{false};
+};
+}
+
 void server::on_connect(
     std::istream& in,
     std::ostream& out,
@@ -249,95 +459,60 @@ void server::on_connect(
     unsigned short local_port,
     dlib::uint64 connection_id
     ) {
+    // replies are flushed explicitly, so that pipelined replies can be written from workers while we read.
+    // in and out share one dlib sockstreambuf, with separate get/put areas, but by default it flushes the put area
+    // on each read, so that must be turned off first. Otherwise pipelined requests are served in sequence.
+    bool concurrent_replies = in.rdbuf() != out.rdbuf();
+    if (auto sb = dynamic_cast<dlib::sockstreambuf*>(in.rdbuf())) {
+        sb->do_not_flush_output_on_read();
+        concurrent_replies = true;
+    }
+    if (concurrent_replies)
+        in.tie(nullptr);
+    std::mutex out_mx;// serialize replies written to out, once there are pipeline workers
+    std::unique_ptr<worker_pool> workers;// created on first pipelined request, destructor waits for replies in flight
+    int32_t wire_format{0};// boost archives, until the client negotiates a compact wire format
     while (in.peek() != EOF) {
         auto msg_type= msg::read_type(in);
-        try { // scoping the binary-archive could be ok, since it forces destruction time (considerable) to taken immediately, reduce memory foot-print early
-              //  at the cost of early& fast response. I leave the commented scopes in there for now, and aim for fastest response-time
-            switch (msg_type) { // currently switch, later maybe table[msg_type]=msg_handler
-            case message_type::EVALUATE_TS_VECTOR:
-            case message_type::EVALUATE_EXPRESSION:{
-                utcperiod bind_period;bool use_ts_cached_read,update_ts_cache;
-                ts_vector_t rtsv;
-                core_iarchive ia(in,core_arch_flags);
-                ia>>bind_period;
-                if(msg_type==message_type::EVALUATE_EXPRESSION) {
-                    compressed_ts_expression c_expr;
-                    ia>>c_expr;
-                    rtsv=expression_decompressor::decompress(c_expr);
-                } else {
-                    ia>>rtsv;
-                }
-                ia>>use_ts_cached_read>>update_ts_cache;
-                auto result=do_evaluate_ts_vector(bind_period, rtsv,use_ts_cached_read,update_ts_cache);//first get result
-                msg::write_type(message_type::EVALUATE_TS_VECTOR,out);// then send
-                core_oarchive oa(out,core_arch_flags);
-                oa<<result;
-
-            } break;
-            case message_type::EVALUATE_EXPRESSION_PERCENTILES:
-            case message_type::EVALUATE_TS_VECTOR_PERCENTILES: {
-                utcperiod bind_period;bool use_ts_cached_read,update_ts_cache;
-                ts_vector_t rtsv;
-                vector<int64_t> percentile_spec;
-                gta_t ta;
-                core_iarchive ia(in,core_arch_flags);
-                ia >> bind_period;
-                if(msg_type==message_type::EVALUATE_EXPRESSION_PERCENTILES) {
-                    compressed_ts_expression c_expr;
-                    ia>>c_expr;
-                    rtsv=expression_decompressor::decompress(c_expr);
-                } else {
-                    ia>>rtsv;
+        if(msg_type==message_type::GET_WIRE_FORMAT || msg_type==message_type::SET_WIRE_FORMAT) {// connection state
+            std::lock_guard<std::mutex> lock(out_mx);
+            if(msg_type==message_type::SET_WIRE_FORMAT) {
+                int32_t v;
+                in.read((char*)&v,sizeof(v));
+                if(v<0 || v>wire::version) {
+                    msg::send_exception(runtime_error(string("Server does not support wire format:")+std::to_string(v)),out);
+                    out.flush();
+                    continue;
                 }
-
-                ia>>ta>>percentile_spec>>use_ts_cached_read>>update_ts_cache;
-
-                auto result = do_evaluate_percentiles(bind_period, rtsv,ta,percentile_spec,use_ts_cached_read,update_ts_cache);//{
-                msg::write_type(message_type::EVALUATE_TS_VECTOR_PERCENTILES, out);
-                core_oarchive oa(out,core_arch_flags);
-                oa << result;
-            } break;
-            case message_type::FIND_TS: {
-                string search_expression; //{
-                search_expression = msg::read_string(in);// >> search_expression;
-                auto find_result = do_find_ts(search_expression);
-                msg::write_type(message_type::FIND_TS, out);
-                core_oarchive oa(out,core_arch_flags);
-                oa << find_result;
-            } break;
-            case message_type::STORE_TS: {
-                ts_vector_t rtsv;
-                bool overwrite_on_write{ true };
-                bool cache_on_write{ false };
-                core_iarchive ia(in,core_arch_flags);
-                ia >> rtsv >> overwrite_on_write >> cache_on_write;
-                do_store_ts(rtsv, overwrite_on_write, cache_on_write);
-                msg::write_type(message_type::STORE_TS, out);
-            } break;
-            case message_type::MERGE_STORE_TS: {
-                ts_vector_t rtsv;
-                bool cache_on_write{ false };
-                core_iarchive ia(in,core_arch_flags);
-                ia >> rtsv >> cache_on_write;
-                do_merge_store_ts(rtsv, cache_on_write);
-                msg::write_type(message_type::MERGE_STORE_TS, out);
-            } break;
-            case message_type::CACHE_FLUSH: {
-                flush_cache();
-                clear_cache_stats();
-                msg::write_type(message_type::CACHE_FLUSH,out);
-            } break;
-            case message_type::CACHE_STATS: {
-                auto cs = get_cache_stats();
-                msg::write_type(message_type::CACHE_STATS,out);
-                core_oarchive oa(out,core_arch_flags);
-                oa<<cs;
-            } break;
-            default:
-                throw runtime_error(string("Server got unknown message type:") + std::to_string((int)msg_type));
+                wire_format=v;
+            }
+            msg::write_type(msg_type,out);
+            int32_t v=msg_type==message_type::GET_WIRE_FORMAT?wire::version:wire_format;
+            out.write((const char*)&v,sizeof(v));
+            out.flush();
+        } else if(msg_type==message_type::PIPELINED) {
+            int64_t request_id;
+            auto body=msg::read_pipelined(request_id,in);
+            auto job=[this,request_id,body,wire_format,&out,&out_mx]() {
+                std::istringstream rq(body);
+                std::ostringstream rp;
+                handle_message(msg::read_type(rq),rq,rp,wire_format);
+                auto reply=rp.str();
+                std::lock_guard<std::mutex> lock(out_mx);
+                msg::write_pipelined(request_id,reply,out);
+                out.flush();
+            };
+            if(!concurrent_replies) {
+                job();
+                continue;
+            }
+            if(!workers) {
+                size_t n_hw=std::max(1u,std::thread::hardware_concurrency());
+                workers=std::make_unique<worker_pool>(std::min(std::max(pipeline_workers,size_t(1)),size_t(n_hw)));
             }
-        } catch (std::exception const& e) {
-            msg::send_exception(e,out);
+            workers->post(std::move(job));
+        } else {// the lock is only taken for writing the replies, so pipelined requests in flight are not held back
+            handle_message(msg_type,in,out,wire_format,workers?&out_mx:nullptr);
         }
     }
 }
@@ -10,6 +10,7 @@
 #include <memory>
 #include <utility>
 #include <functional>
+#include <mutex>
 #include <cstring>
 #include <regex>
 
@@ -82,7 +83,7 @@ using find_call_back_t = std::function<ts_info_vector_t(std::string search_expre
  *
  */
 struct server : dlib::server_iostream {
-    using ts_cache_t = cache<apoint_ts_frag,apoint_ts>;
+    using ts_cache_t = sharded_cache<apoint_ts_frag,apoint_ts>;
     // callbacks for extensions
     read_call_back_t bind_ts_cb; ///< called to read non shyft:// unbound ts
     find_call_back_t find_ts_cb; ///< called for all non shyft:// find operations
@@ -91,6 +92,8 @@ struct server : dlib::server_iostream {
     std::unordered_map<std::string, ts_db> container;///< mapping of internal shyft <container> -> ts_db
     ts_cache_t ts_cache{1000000};// default 1 mill ts in cache
     bool cache_all_reads{false};
+    std::size_t pipeline_workers{4};///< max worker threads per connection for pipelined requests, capped at hardware concurrency
+    bool compress_values{false};///< if true, containers write compressed values, \ref ts_db::compress_values
     // constructors
 
     server()=default;
@@ -121,6 +124,14 @@ struct server : dlib::server_iostream {
     //-- container management
     void add_container(const std::string &container_name,const std::string& root_dir) {
         container[container_name]=ts_db(root_dir); // TODO: This is not thread-safe(so needs to be done before starting)
+        container[container_name].compress_values=compress_values;
+    }
+
+    /** set compressed values on/off for writes to current and later added containers */
+    void set_compress_values(bool active) {
+        compress_values=active;
+        for(auto& c:container)
+            c.second.compress_values=active;
     }
 
     const ts_db& internal(const std::string& container_name) const {
@@ -140,6 +151,20 @@ struct server : dlib::server_iostream {
     void set_cache_size(std::size_t max_size) { ts_cache.set_capacity(max_size);}
     void set_auto_cache(bool active) { cache_all_reads=active;}
     std::size_t get_cache_size() const {return ts_cache.get_capacity();}
+    /** set number of lock-striped cache shards, keeps capacity, but flushes cache and cache-stats
+     * \note not thread-safe, so needs to be done before starting
+     */
+    void set_cache_shards(std::size_t n_shards) {
+        ts_cache_t nc(ts_cache.get_capacity(),n_shards);
+        nc.set_byte_capacity(ts_cache.get_byte_capacity());
+        nc.set_policy(ts_cache.get_policy());
+        ts_cache=std::move(nc);
+    }
+    std::size_t get_cache_shards() const {return ts_cache.get_shard_count();}
+    void set_cache_byte_size(std::size_t max_bytes) { ts_cache.set_byte_capacity(max_bytes);}
+    std::size_t get_cache_byte_size() const {return ts_cache.get_byte_capacity();}
+    void set_cache_policy(cache_policy p) { ts_cache.set_policy(p);}
+    cache_policy get_cache_policy() const {return ts_cache.get_policy();}
 
     ts_info_vector_t do_find_ts(const std::string& search_expression);
 
@@ -166,8 +191,23 @@ struct server : dlib::server_iostream {
     ts_vector_t do_read(const id_vector_t& ts_ids,utcperiod p,bool use_ts_cached_read,bool update_ts_cache);
     void do_bind_ts(utcperiod bind_period, ts_vector_t& atsv,bool use_ts_cached_read,bool update_ts_cache);
     ts_vector_t do_evaluate_ts_vector(utcperiod bind_period, ts_vector_t& atsv,bool use_ts_cached_read,bool update_ts_cache);
+    /** \brief as do_evaluate_ts_vector, but evaluates chunk_size ts at a time, passing each result chunk to fx
+     *
+     * the expressions of a chunk are released once evaluated, so that peak memory is bound
+     * by the chunk rather than the complete result.
+     */
+    void do_evaluate_ts_vector_chunked(utcperiod bind_period, ts_vector_t& atsv,bool use_ts_cached_read,bool update_ts_cache,
+                                       std::size_t chunk_size,const std::function<void(const ts_vector_t&)>& fx);
     ts_vector_t do_evaluate_percentiles(utcperiod bind_period, ts_vector_t& atsv, gta_t const&ta,std::vector<int64_t> const& percentile_spec,bool use_ts_cached_read,bool update_ts_cache);
 
+    /** \brief handle one request of type msg_type, reading the remains from in, writing the reply to out
+     *
+     * exceptions are sent as SERVER_EXCEPTION replies,
+     * ts-vector replies are written in the wire_format negotiated for the connection, \ref wire::write_reply
+     * if out_mx is given, it is locked while a complete reply frame is written to out, but not during evaluation.
+     */
+    void handle_message(message_type msg_type, std::istream& in, std::ostream& out, int32_t wire_format=0, std::mutex* out_mx=nullptr);
+
     // ref. dlib, all connection calls are directed here
     void on_connect(
         std::istream& in,
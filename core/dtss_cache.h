@@ -7,13 +7,16 @@
 #include <map>
 #include <unordered_map>
 #include <list>
+#include <set>
 #include <algorithm>
 #include <memory>
+#include <functional>
 #include <utility>
 #include <mutex>
 #include <stdexcept>
 
 #include "core_serialization.h"
+#include <boost/serialization/version.hpp>
 #include "utctime_utilities.h"
 #include "time_series.h"
 #include "time_series_merge.h"
@@ -27,6 +30,7 @@ namespace shyft {
         using std::unordered_map;
         using std::pair;
         using std::list;
+        using std::set;
         using std::make_shared;
         using std::shared_ptr;
         using std::lower_bound;
@@ -162,6 +166,15 @@ namespace shyft {
             }
             size_t get_capacity() const {return _capacity;}
 
+            /** \return number of items in the cache */
+            size_t size() const {return _key_to_value.size();}
+
+            /** \return the least recently used key, requires size()>0 */
+            const key_type& lru_key() const {
+                assert(!_key_tracker.empty());
+                return _key_tracker.front();
+            }
+
 			/** Flush cache */
 			void flush() {
 				_key_tracker.clear();
@@ -344,6 +357,7 @@ namespace shyft {
             size_t id_count{ 0 };///< current count of disticnt ts-ids in the cache
             size_t point_count{ 0 };///< current estimate of ts-points in the cache, one point ~8 bytes
             size_t fragment_count{ 0 };///< current count of ts-fragments, equal or larger than id_count
+            size_t byte_count{ 0 };///< current estimate of bytes resident in the cache, point_count x 8
         /** nice to have summary function */
             friend inline cache_stats operator + (cache_stats l, const cache_stats& r) {
                 l.hits += r.hits;
@@ -352,6 +366,7 @@ namespace shyft {
                 l.id_count += r.id_count;
                 l.point_count += r.point_count;
                 l.fragment_count += r.fragment_count;
+                l.byte_count += r.byte_count;
                 return l;
             }
 
@@ -359,6 +374,18 @@ namespace shyft {
         };
 
 
+        /** \brief eviction policy for the dtss cache
+         *
+         * lru: evict the least recently used ts-id
+         * gdsf: greedy-dual-size-frequency, evict the ts-id with lowest priority
+         *       h = clock + hit_count/bytes, where clock is raised to the h of each evicted item,
+         *       so that small and frequently used ts are kept, and old items age out.
+         */
+        enum class cache_policy {
+            lru,
+            gdsf
+        };
+
         /** \brief a dtss cache for id-based ts-fragments
          *
          * Provides thread-safe:
@@ -375,6 +402,10 @@ namespace shyft {
          * maintain by lru, - where the value-type (ts_frag) is maintained as a
          *                    minimal set of non-overlapping disjoint ts-fragments.
          *
+         * capacity is given by max ts-id count, and optionally by a byte budget,
+         * where the size of each ts-id is estimated using mini_frag::estimate_size.
+         * when exceeding any of them, items are evicted by the \ref cache_policy.
+         *
          * \sa lru_cache
          * \sa cache_stats
          * \sa apoints_ts_frag
@@ -388,6 +419,64 @@ namespace shyft {
             mutable mutex mx; ///< mutex to protect access to c and cs
             internal_cache c;///< internal cache implementation
             cache_stats cs;///< internal cache stats to collect misses/hits
+            size_t max_bytes{0};///< byte budget, 0 means no byte budget
+            size_t bytes{0};///< current estimate of bytes resident
+            cache_policy policy{cache_policy::lru};
+            struct gdsf_item {
+                double h;///< priority
+                size_t freq;///< hit count
+            };
+            double gdsf_clock{0.0};///< inflation value, the h of the last evicted item
+            unordered_map<string, gdsf_item> gdsf_items;///< gdsf priority for each id
+            set<pair<double, string>> gdsf_order;///< ids ordered by gdsf priority, lowest first
+
+            static size_t byte_size(const value_type& mf) { return mf.estimate_size()*sizeof(double); }
+
+            /** gdsf: register a hit (or an update if not hit) of id with sz bytes */
+            void touch(const string& id, size_t sz, bool hit) {
+                if (policy != cache_policy::gdsf)
+                    return;
+                auto f = gdsf_items.find(id);
+                size_t freq = 1;
+                if (f != gdsf_items.end()) {
+                    gdsf_order.erase(std::make_pair(f->second.h, id));
+                    freq = f->second.freq + (hit ? 1 : 0);
+                }
+                double h = gdsf_clock + double(freq)/double(max(sz, size_t(1)));
+                gdsf_items[id] = gdsf_item{ h, freq };
+                gdsf_order.emplace(h, id);
+            }
+
+            /** remove id from internal structures, tracking bytes */
+            void internal_remove(const string& id) {
+                if (!c.item_exists(id))
+                    return;
+                bytes -= min(bytes, byte_size(c.get_item(id)));
+                c.remove_item(id);
+                auto f = gdsf_items.find(id);
+                if (f != gdsf_items.end()) {
+                    gdsf_order.erase(std::make_pair(f->second.h, id));
+                    gdsf_items.erase(f);
+                }
+            }
+
+            /** evict one item according to policy, requires c.size()>0 */
+            void evict_one() {
+                if (policy == cache_policy::gdsf && gdsf_order.size()) {
+                    gdsf_clock = gdsf_order.begin()->first;
+                    string id = gdsf_order.begin()->second;
+                    internal_remove(id);
+                } else {
+                    string id = c.lru_key();
+                    internal_remove(id);
+                }
+            }
+
+            /** evict until within byte budget, keeping at least one item */
+            void enforce_byte_budget() {
+                while (max_bytes && bytes > max_bytes && c.size() > 1)
+                    evict_one();
+            }
 
                            /** get one single item from cache, if exists, and matches period, record hits/misses */
             bool internal_try_get(const string& id, const utcperiod& p, ts_t& ts) {
@@ -403,19 +492,30 @@ namespace shyft {
                     return false;
                 }
                 ts = mf.get_by_ix(ix).ts();
+                touch(id, byte_size(mf), true);
                 return true;
             }
 
             /** add one single item to cache, defrag if already there */
             void internal_add(const string &id, const ts_t &ts) {
+                size_t sz;
                 if (!c.item_exists(id)) {
+                    if (c.size() >= c.get_capacity())
+                        evict_one();// by policy, before the lru would do it
                     value_type mf; mf.add(ts_frag{ ts });
+                    sz = byte_size(mf);
                     c.add_item(id, mf);
+                    bytes += sz;
                 }
                 else {
                     auto&mf = c.get_item(id);
+                    bytes -= min(bytes, byte_size(mf));
                     mf.add(ts_frag{ ts });
+                    sz = byte_size(mf);
+                    bytes += sz;
                 }
+                touch(id, sz, false);
+                enforce_byte_budget();
             }
 
         public:
@@ -431,7 +531,10 @@ namespace shyft {
             *
             */
             void set_capacity(size_t id_max_count) {
+                if (id_max_count == 0) throw runtime_error("cache capacity must be >0");
                 lock_guard<mutex> guard(mx);
+                while (c.size() > id_max_count)
+                    evict_one();
                 c.set_capacity(id_max_count);
             }
             size_t get_capacity() const {
@@ -439,6 +542,45 @@ namespace shyft {
                 return c.get_capacity();
             }
 
+            /** \brief adjust the cache byte budget
+             *
+             * Set the max estimated bytes resident in the cache,
+             * evicting items by policy if needed.
+             * An item that alone exceeds the budget is kept until it is evicted by later adds.
+             *
+             * \param byte_max_count the new byte budget, 0 means no byte budget, only id count
+             */
+            void set_byte_capacity(size_t byte_max_count) {
+                lock_guard<mutex> guard(mx);
+                max_bytes = byte_max_count;
+                enforce_byte_budget();
+            }
+            size_t get_byte_capacity() const {
+                lock_guard<mutex> guard(mx);
+                return max_bytes;
+            }
+
+            /** \brief set the eviction policy
+             *
+             * When switching to gdsf, present items starts with equal hit count.
+             */
+            void set_policy(cache_policy p) {
+                lock_guard<mutex> guard(mx);
+                if (p == policy)
+                    return;
+                policy = p;
+                gdsf_items.clear();
+                gdsf_order.clear();
+                gdsf_clock = 0.0;
+                if (policy == cache_policy::gdsf) {
+                    c.apply_to_items([this](const string& id, const value_type& mf) { touch(id, byte_size(mf), false); });
+                }
+            }
+            cache_policy get_policy() const {
+                lock_guard<mutex> guard(mx);
+                return policy;
+            }
+
             /** try get a ts that matches id and period.
             *
             * \sa get
@@ -519,7 +661,7 @@ namespace shyft {
              */
             void remove(const string& id) {
                 lock_guard<mutex> guard(mx);
-                c.remove_item(id);
+                internal_remove(id);
             }
 
             /** \brief remove specified ts-ids from cache
@@ -531,7 +673,7 @@ namespace shyft {
             void remove(const vector<string>& ids) {
                 lock_guard<mutex> guard(mx);
                 for (const auto& id:ids)
-                    c.remove_item(id);
+                    internal_remove(id);
             }
 
             /** \brief flushes the cache
@@ -543,6 +685,10 @@ namespace shyft {
             void flush() {
                 lock_guard<mutex> guard(mx);
 				c.flush();
+                bytes = 0;
+                gdsf_items.clear();
+                gdsf_order.clear();
+                gdsf_clock = 0.0;
             }
 
             /** Provide cache-statistics
@@ -558,6 +704,7 @@ namespace shyft {
 					++r.id_count;
 				};
 				c.apply_to_items(fx);
+                r.byte_count = bytes;
                 return r;
             }
 
@@ -568,6 +715,167 @@ namespace shyft {
             }
 
         };
+
+        /** \brief a sharded, lock-striped dtss cache for id-based ts-fragments
+         *
+         * Provides the same thread-safe interface as \ref cache, but the ts-ids are
+         * distributed by hash onto n independent cache shards, each with its own lru and mutex.
+         * Concurrent requests for different ts-ids then mostly lock different shards,
+         * instead of all waiting for one mutex.
+         *
+         * The lru-order and capacity is maintained per shard, the capacity is split evenly among the
+         * shards, so a shard that by hash receives more than its share of ids evicts earlier.
+         * The cache-stats are the sum over all shards.
+         *
+         * \note with one shard, the behaviour is equal to \ref cache
+         *
+         * \sa cache
+         */
+        template<class ts_frag, class ts_t>
+        struct sharded_cache {
+            using shard_type = cache<ts_frag, ts_t>;
+        private:
+            vector<std::unique_ptr<shard_type>> shards;///< the shards, immutable after construction
+            std::hash<string> id_hash;
+            size_t capacity;///< the total capacity, as set, the shards have capacity/n_shards rounded up
+            size_t byte_capacity{0};///< the total byte budget, as set, 0 means no budget
+
+            static size_t shard_capacity(size_t id_max_count, size_t n_shards) {
+                return max(size_t(1), (id_max_count + n_shards - 1) / n_shards);
+            }
+
+            shard_type& shard(const string& id) const {
+                return *shards[shards.size() == 1 ? 0 : id_hash(id) % shards.size()];
+            }
+
+            /** group ids by shard index, keeping the relative order */
+            vector<vector<string>> ids_by_shard(const vector<string>& ids) const {
+                vector<vector<string>> r(shards.size());
+                for (const auto& id : ids)
+                    r[shards.size() == 1 ? 0 : id_hash(id) % shards.size()].push_back(id);
+                return r;
+            }
+
+        public:
+            /** construct a cache with max ts-id count, distributed on n_shards
+             * \param id_max_count total max ts-id count of the cache
+             * \param n_shards number of shards, required to be > 0
+             */
+            explicit sharded_cache(size_t id_max_count, size_t n_shards = 1) : capacity(id_max_count) {
+                if (n_shards == 0)
+                    throw runtime_error("cache shard count must be >0");
+                for (size_t i = 0; i < n_shards; ++i)
+                    shards.emplace_back(new shard_type(shard_capacity(id_max_count, n_shards)));
+            }
+
+            size_t get_shard_count() const { return shards.size(); }
+
+            /** adjust the total capacity, evenly distributed over the shards \sa cache::set_capacity */
+            void set_capacity(size_t id_max_count) {
+                if (id_max_count == 0) throw runtime_error("cache capacity must be >0");
+                for (auto& s : shards)
+                    s->set_capacity(shard_capacity(id_max_count, shards.size()));
+                capacity = id_max_count;
+            }
+
+            size_t get_capacity() const { return capacity; }
+
+            /** adjust the total byte budget, evenly distributed over the shards \sa cache::set_byte_capacity */
+            void set_byte_capacity(size_t byte_max_count) {
+                for (auto& s : shards)
+                    s->set_byte_capacity(byte_max_count ? shard_capacity(byte_max_count, shards.size()) : 0);
+                byte_capacity = byte_max_count;
+            }
+
+            size_t get_byte_capacity() const { return byte_capacity; }
+
+            /** \sa cache::set_policy */
+            void set_policy(cache_policy p) {
+                for (auto& s : shards)
+                    s->set_policy(p);
+            }
+
+            cache_policy get_policy() const { return shards[0]->get_policy(); }
+
+            /** \sa cache::try_get */
+            bool try_get(const string& id, const utcperiod& p, ts_t& ts) {
+                return shard(id).try_get(id, p, ts);
+            }
+
+            /** \sa cache::get, locks each involved shard once */
+            unordered_map<string, ts_t> get(const vector<string>& ids, const utcperiod& p) {
+                if (shards.size() == 1)
+                    return shards[0]->get(ids, p);
+                unordered_map<string, ts_t> r;
+                auto sids = ids_by_shard(ids);
+                for (size_t i = 0; i < sids.size(); ++i) {
+                    if (sids[i].size() == 0) continue;
+                    auto ri = shards[i]->get(sids[i], p);
+                    r.insert(begin(ri), end(ri));
+                }
+                return r;
+            }
+
+            /** \sa cache::add */
+            void add(const string& id, const ts_t& ts) {
+                shard(id).add(id, ts);
+            }
+
+            /** \sa cache::add, locks each involved shard once */
+            template<typename TSV>
+            void add(const vector<string>& ids, const TSV& tss) {
+                if (ids.size() != tss.size())
+                    throw runtime_error("attempt to add mismatched size for ts-ids and ts to cache");
+                if (shards.size() == 1) {
+                    shards[0]->add(ids, tss);
+                    return;
+                }
+                vector<vector<string>> sids(shards.size());
+                vector<vector<ts_t>> stss(shards.size());
+                for (size_t i = 0; i < ids.size(); ++i) {
+                    auto s = id_hash(ids[i]) % shards.size();
+                    sids[s].push_back(ids[i]);
+                    stss[s].push_back(tss[i]);
+                }
+                for (size_t s = 0; s < shards.size(); ++s)
+                    if (sids[s].size())
+                        shards[s]->add(sids[s], stss[s]);
+            }
+
+            /** \sa cache::remove */
+            void remove(const string& id) {
+                shard(id).remove(id);
+            }
+
+            /** \sa cache::remove */
+            void remove(const vector<string>& ids) {
+                auto sids = ids_by_shard(ids);
+                for (size_t i = 0; i < sids.size(); ++i)
+                    if (sids[i].size())
+                        shards[i]->remove(sids[i]);
+            }
+
+            /** \sa cache::flush */
+            void flush() {
+                for (auto& s : shards)
+                    s->flush();
+            }
+
+            /** \return the sum of cache_stats over all shards */
+            cache_stats get_cache_stats() {
+                cache_stats r;
+                for (auto& s : shards)
+                    r = r + s->get_cache_stats();
+                return r;
+            }
+
+            /** \sa cache::clear_cache_stats */
+            void clear_cache_stats() {
+                for (auto& s : shards)
+                    s->clear_cache_stats();
+            }
+        };
     }
 }
 x_serialize_export_key(shyft::dtss::cache_stats);
+BOOST_CLASS_VERSION(shyft::dtss::cache_stats, 1);// 1: byte_count
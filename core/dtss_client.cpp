@@ -7,6 +7,7 @@
 #include <regex>
 #include <future>
 #include <utility>
+#include <sstream>
 
 #include "dtss_client.h"
 #include "dtss_url.h"
@@ -15,6 +16,7 @@
 #include "core_serialization.h"
 #include "core_archive.h"
 #include "expression_serialization.h"
+#include "dtss_wire.h"
 
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/shared_ptr.hpp>
@@ -39,12 +41,66 @@ using shyft::time_series::statistics_property;
 
 void srv_connection::open(int timeout_ms) {
     io->open(host_port,max(timeout_ms,this->timeout_ms));
+    wire_format=0;// the server starts each connection with boost archives
+    wire_set=false;
+    wire_ack_pending=false;
 }
 void srv_connection::close(int timeout_ms) {
     io->close(max(timeout_ms,this->timeout_ms));
 }
 void srv_connection::reopen(int timeout_ms) {
-    io->open(host_port,max(timeout_ms,this->timeout_ms));
+    open(timeout_ms);
+}
+
+int32_t srv_connection::server_wire_version() {
+    if(srv_wire_version<0) {// first use, ask the server
+        auto& io=*(this->io);
+        msg::write_type(message_type::GET_WIRE_FORMAT, io);
+        auto response_type = msg::read_type(io);
+        if (response_type == message_type::SERVER_EXCEPTION) {// older server, keep boost archives
+            msg::read_exception(io);
+            srv_wire_version=0;
+        } else if (response_type != message_type::GET_WIRE_FORMAT) {
+            throw std::runtime_error(std::string("Got unexpected response:") + std::to_string((int)response_type));
+        } else {
+            io.read((char*)&srv_wire_version, sizeof(srv_wire_version));
+        }
+    }
+    return srv_wire_version;
+}
+
+void srv_connection::use_wire_format() {
+    if(wire_set)
+        return;
+    wire_set=true;
+    wire_format=0;
+    if(wire_request<=0)
+        return;
+    auto& io=*(this->io);
+    int32_t v = min(wire_request, server_wire_version());
+    if (v <= 0)
+        return;
+    msg::write_type(message_type::SET_WIRE_FORMAT, io);// the reply is read by read_wire_ack, ahead of the request reply
+    io.write((const char*)&v, sizeof(v));
+    wire_format=v;
+    wire_ack_pending=true;
+}
+
+void srv_connection::read_wire_ack() {
+    if(!wire_ack_pending)
+        return;
+    wire_ack_pending=false;
+    auto& io=*(this->io);
+    auto response_type = msg::read_type(io);
+    if (response_type == message_type::SERVER_EXCEPTION) {// rejected, e.g. the server was replaced, so ask again on next connect
+        msg::read_exception(io);
+        wire_format=0;
+        srv_wire_version=-1;
+        return;
+    } else if (response_type != message_type::SET_WIRE_FORMAT) {
+        throw std::runtime_error(std::string("Got unexpected response:") + std::to_string((int)response_type));
+    }
+    io.read((char*)&wire_format, sizeof(wire_format));
 }
 
 
@@ -93,7 +149,7 @@ struct scoped_connect {
 client::client ( const string& host_port, bool auto_connect, int timeout_ms )
     :auto_connect(auto_connect)
 {
-    srv_con.push_back(srv_connection{make_unique<dlib::iosockstream>(),host_port,timeout_ms});
+    srv_con.push_back(srv_connection{make_unique<dlib::iosockstream>(),host_port,timeout_ms,wire::version});
     if(!auto_connect)
         srv_con[0].open();
 }
@@ -102,12 +158,17 @@ client::client(const vector<string>& host_ports,bool auto_connect,int timeout_ms
     if(host_ports.size()==0)
         throw runtime_error("host_ports must contain at least one element");
     for(const auto &hp:host_ports) {
-        srv_con.push_back(srv_connection{make_unique<dlib::iosockstream>(),hp,timeout_ms});
+        srv_con.push_back(srv_connection{make_unique<dlib::iosockstream>(),hp,timeout_ms,wire::version});
     }
     if(!auto_connect)
         reopen(timeout_ms);
 }
 
+void client::set_compact_wire(bool active) {
+    for(auto&sc:srv_con)
+        sc.wire_request=active?wire::version:0;
+}
+
 void client::reopen(int timeout_ms) {
     for(auto&sc:srv_con)
         sc.reopen(timeout_ms);
@@ -143,6 +204,7 @@ client::percentiles(ts_vector_t const& tsv, utcperiod p, gta_t const&ta, const v
     if(srv_con.size()==1 || tsv.size()< srv_con.size()) {
         scoped_connect ac(*this);
         dlib::iosockstream& io = *(srv_con[0].io);
+        srv_con[0].use_wire_format();
         msg::write_type(compress_expressions?message_type::EVALUATE_EXPRESSION_PERCENTILES:message_type::EVALUATE_TS_VECTOR_PERCENTILES, io);
         core_oarchive oa(io,core_arch_flags);
         oa << p;
@@ -152,15 +214,13 @@ client::percentiles(ts_vector_t const& tsv, utcperiod p, gta_t const&ta, const v
             oa<< tsv;
         }
         oa<< ta << percentile_spec<<use_ts_cached_read<<update_ts_cache;
+        srv_con[0].read_wire_ack();
         auto response_type = msg::read_type(io);
         if (response_type == message_type::SERVER_EXCEPTION) {
             auto re = msg::read_exception(io);
             throw re;
         } else if (response_type == message_type::EVALUATE_TS_VECTOR_PERCENTILES) {
-            ts_vector_t r;
-            core_iarchive ia(io,core_arch_flags);
-            ia >> r;
-            return r;
+            return wire::read_reply(srv_con[0].wire_format, io);
         }
         throw std::runtime_error(std::string("Got unexpected response:") + std::to_string((int)response_type));
     } else {
@@ -184,7 +244,9 @@ client::evaluate(ts_vector_t const& tsv, utcperiod p,bool use_ts_cached_read,boo
         throw std::runtime_error("percentiles require a valid period-specification");
     scoped_connect ac(*this);
     // local lambda to ensure one definition of communication with the server
-    auto eval_io = [this] (dlib::iosockstream&io,const ts_vector_t& tsv,const utcperiod& p,bool use_ts_cached_read,bool update_ts_cache) {
+    auto eval_io = [this] (srv_connection& sc,const ts_vector_t& tsv,const utcperiod& p,bool use_ts_cached_read,bool update_ts_cache) {
+        dlib::iosockstream& io = *(sc.io);
+        sc.use_wire_format();
             msg::write_type(compress_expressions?message_type::EVALUATE_EXPRESSION:message_type::EVALUATE_TS_VECTOR, io); {
             core_oarchive oa(io,core_arch_flags);
             oa << p ;
@@ -195,31 +257,27 @@ client::evaluate(ts_vector_t const& tsv, utcperiod p,bool use_ts_cached_read,boo
                 oa<< tsv<<use_ts_cached_read<<update_ts_cache;
             }
         }
+        sc.read_wire_ack();
         auto response_type = msg::read_type(io);
         if (response_type == message_type::SERVER_EXCEPTION) {
             auto re = msg::read_exception(io);
             throw re;
         } else if (response_type == message_type::EVALUATE_TS_VECTOR) {
-            ts_vector_t r; {
-                core_iarchive ia(io,core_arch_flags);
-                ia >> r;
-            }
-            return r;
+            return wire::read_reply(sc.wire_format, io);
         }
         throw std::runtime_error(std::string("Got unexpected response:") + std::to_string((int)response_type));
     };
 
     if(srv_con.size()==1 || tsv.size() == 1) { // one server, or just one ts, do it easy
-        dlib::iosockstream& io = *(srv_con[0].io);
-        return eval_io(io,tsv,p,use_ts_cached_read,update_ts_cache);
+        return eval_io(srv_con[0],tsv,p,use_ts_cached_read,update_ts_cache);
     } else {
         ts_vector_t rt(tsv.size()); // make place for the result contributions from threads
         // lamda to eval partition on server
         auto eval_partition= [&rt,&tsv,&eval_io,p,use_ts_cached_read,update_ts_cache]
-            (dlib::iosockstream& io,size_t i0, size_t n) {
+            (srv_connection& sc,size_t i0, size_t n) {
                 ts_vector_t ptsv;ptsv.reserve(tsv.size());
                 for(size_t i=i0;i<i0+n;++i) ptsv.push_back(tsv[i]);
-                auto pt = eval_io(io,ptsv,p,use_ts_cached_read,update_ts_cache);
+                auto pt = eval_io(sc,ptsv,p,use_ts_cached_read,update_ts_cache);
                 for(size_t i=0;i<pt.size();++i)
                     rt[i0+i]=pt[i];
         };
@@ -231,7 +289,7 @@ client::evaluate(ts_vector_t const& tsv, utcperiod p,bool use_ts_cached_read,boo
             calcs.push_back(std::async(
                             std::launch::async,
                             [this,i,i0,n,&eval_partition] () {
-                                eval_partition (*(srv_con[i].io),i0,n);
+                                eval_partition (srv_con[i],i0,n);
                             }
                            )
                   );
@@ -243,6 +301,139 @@ client::evaluate(ts_vector_t const& tsv, utcperiod p,bool use_ts_cached_read,boo
     }
 }
 
+void
+client::evaluate_chunked(ts_vector_t const& tsv, utcperiod p,bool use_ts_cached_read,bool update_ts_cache,
+                         size_t chunk_size,const std::function<void(size_t,const ts_vector_t&)>& fx) {
+    if (tsv.size() == 0)
+        throw std::runtime_error("evaluate requires a source ts-vector with more than 0 time-series");
+    if (!p.valid())
+        throw std::runtime_error("evaluate require a valid period-specification");
+    scoped_connect ac(*this);
+    dlib::iosockstream& io = *(srv_con[0].io);
+    srv_con[0].use_wire_format();
+    msg::write_type(compress_expressions?message_type::EVALUATE_EXPRESSION_CHUNKED:message_type::EVALUATE_TS_VECTOR_CHUNKED, io); {
+        core_oarchive oa(io,core_arch_flags);
+        oa << p ;
+        if(compress_expressions) {
+            oa<< expression_compressor::compress(tsv);
+        } else {
+            oa<< tsv;
+        }
+        oa<<use_ts_cached_read<<update_ts_cache<<int64_t(chunk_size);
+    }
+    // reply: n_ts, then chunks until n_ts received, or an exception
+    auto read_reply_type=[&io]() {
+        auto response_type = msg::read_type(io);
+        if (response_type == message_type::SERVER_EXCEPTION) {
+            auto re = msg::read_exception(io);
+            throw re;
+        } else if (response_type != message_type::EVALUATE_TS_VECTOR_CHUNKED) {
+            throw std::runtime_error(std::string("Got unexpected response:") + std::to_string((int)response_type));
+        }
+    };
+    srv_con[0].read_wire_ack();
+    read_reply_type();
+    int64_t n_ts;{
+        core_iarchive ia(io,core_arch_flags);
+        ia>>n_ts;
+    }
+    size_t i0=0;
+    while (i0 < size_t(n_ts)) {
+        read_reply_type();
+        auto chunk = wire::read_reply(srv_con[0].wire_format, io);
+        if (chunk.size() == 0)
+            throw std::runtime_error("Got unexpected empty chunk");
+        fx(i0,chunk);
+        i0+=chunk.size();
+    }
+}
+
+vector<ts_vector_t>
+client::evaluate_pipelined(const vector<ts_vector_t>& tsvs, utcperiod p,bool use_ts_cached_read,bool update_ts_cache) {
+    if (!p.valid())
+        throw std::runtime_error("evaluate_pipelined require a valid period-specification");
+    vector<ts_vector_t> r(tsvs.size());
+    if (tsvs.size() == 0)
+        return r;
+    vector<string> errors(tsvs.size());
+    scoped_connect ac(*this);
+    // send requests i0, i0+n_srv.. on io, then collect the replies in the order they arrive
+    auto pipeline_io = [this,&tsvs,&r,&errors,p,use_ts_cached_read,update_ts_cache] (srv_connection& sc,size_t i0) {
+        dlib::iosockstream& io = *(sc.io);
+        size_t n_srv = srv_con.size();
+        size_t n_sent = 0;
+        // servers without a wire version predate PIPELINED, and would read the envelope body as the next request,
+        // so those get one plain request at the time
+        bool pipelined = sc.server_wire_version() > 0;
+        sc.use_wire_format();
+        for (size_t i = i0; i < tsvs.size(); i += n_srv) {
+            std::ostringstream rq;
+            msg::write_type(compress_expressions?message_type::EVALUATE_EXPRESSION:message_type::EVALUATE_TS_VECTOR, rq); {
+                core_oarchive oa(rq,core_arch_flags);
+                oa << p;
+                if(compress_expressions) {
+                    oa<< expression_compressor::compress(tsvs[i])<<use_ts_cached_read<<update_ts_cache;
+                } else {
+                    oa<< tsvs[i]<<use_ts_cached_read<<update_ts_cache;
+                }
+            }
+            if (!pipelined) {
+                auto b = rq.str();
+                io.write(b.data(), b.size());
+                io.flush();
+                auto reply_type = msg::read_type(io);
+                if (reply_type == message_type::SERVER_EXCEPTION) {
+                    errors[i] = msg::read_exception(io).what();
+                } else if (reply_type == message_type::EVALUATE_TS_VECTOR) {
+                    r[i] = wire::read_reply(sc.wire_format, io);
+                } else {
+                    throw std::runtime_error(std::string("Got unexpected response:") + std::to_string((int)reply_type));
+                }
+                continue;
+            }
+            msg::write_pipelined(int64_t(i), rq.str(), io);
+            ++n_sent;
+        }
+        io.flush();
+        sc.read_wire_ack();
+        for (size_t j = 0; j < n_sent; ++j) {
+            auto response_type = msg::read_type(io);
+            if (response_type == message_type::SERVER_EXCEPTION) {// not a pipeline reply, e.g. server not supporting it
+                auto re = msg::read_exception(io);
+                throw re;
+            } else if (response_type != message_type::PIPELINED) {
+                throw std::runtime_error(std::string("Got unexpected response:") + std::to_string((int)response_type));
+            }
+            int64_t id;
+            std::istringstream rp(msg::read_pipelined(id, io));
+            if (id < 0 || size_t(id) >= tsvs.size())
+                throw std::runtime_error(std::string("Got unexpected request-id:") + std::to_string(id));
+            auto reply_type = msg::read_type(rp);
+            if (reply_type == message_type::SERVER_EXCEPTION) {
+                errors[id] = msg::read_exception(rp).what();
+            } else if (reply_type == message_type::EVALUATE_TS_VECTOR) {
+                r[id] = wire::read_reply(sc.wire_format, rp);
+            } else {
+                errors[id] = std::string("Got unexpected response:") + std::to_string((int)reply_type);
+            }
+        }
+    };
+    if (srv_con.size() == 1) {
+        pipeline_io(srv_con[0], 0);
+    } else {
+        vector<future<void>> calcs;
+        for (size_t i = 0; i < srv_con.size(); ++i) {
+            calcs.push_back(std::async(std::launch::async, [this,i,&pipeline_io] () { pipeline_io(srv_con[i], i); }));
+        }
+        for (auto &f : calcs)
+            f.get();
+    }
+    for (const auto& e : errors)
+        if (e.size())
+            throw std::runtime_error(e);
+    return r;
+}
+
 void
 client::store_ts(const ts_vector_t &tsv, bool overwrite_on_write, bool cache_on_write) {
     if (tsv.size() == 0)
@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 
 #include <dlib/iosockstream.h>
 #include <dlib/misc_api.h>
@@ -50,9 +51,25 @@ struct srv_connection {
     unique_ptr<dlib::iosockstream> io;
     string host_port;
     int timeout_ms;
+    int32_t wire_request{0};///< compact wire format to negotiate, 0 means boost archives, \ref wire::version
+    int32_t wire_format{0};///< the wire format negotiated for the open connection
+    int32_t srv_wire_version{-1};///< the wire version of the server, asked for once, -1 until known
+    bool wire_set{false};///< the wire format is established for the open connection
+    bool wire_ack_pending{false};///< a SET_WIRE_FORMAT is sent, and its reply is not yet read
     void open(int timeout_ms=1000);
     void close(int timeout_ms=1000);
     void reopen(int timeout_ms=1000);
+    /** the wire version of the server, asked for on first use, 0 for servers prior to wire formats and pipelining */
+    int32_t server_wire_version();
+    /** \brief establish the wire format of the open connection, prior to writing a request with a ts-vector reply
+     *
+     * The server wire version is asked for on the first use only, and kept for later connections.
+     * The SET_WIRE_FORMAT is written ahead of the request, without waiting for the reply,
+     * so that (re)connects does not pay extra round trips, \sa read_wire_ack
+     */
+    void use_wire_format();
+    /** read the reply to the SET_WIRE_FORMAT written by use_wire_format, if any, prior to the reply of the request */
+    void read_wire_ack();
 };
 
 /** \brief a dtss client
@@ -71,6 +88,11 @@ struct client {
 
     bool compress_expressions{true};///< compress expressions to gain speed
 
+    /** use the compact wire format for ts-vector replies, if the server supports it, \ref wire::version
+     * takes effect when connections are (re)opened, the format is negotiated with the first request needing it
+     */
+    void set_compact_wire(bool active);
+
 	client (const string& host_port, bool auto_connect = true, int timeout_ms=1000);
 
     client(const vector<string>& host_ports,bool auto_connect,int timeout_ms);
@@ -83,6 +105,27 @@ struct client {
 
 	vector<apoint_ts> evaluate(ts_vector_t const& tsv, utcperiod p,bool use_ts_cached_read,bool update_ts_cache) ;
 
+    /** \brief evaluate, receiving the result in chunks as they are evaluated by the server
+     *
+     * The server evaluates and sends chunk_size ts at a time, so that server memory is bounded,
+     * and the first results arrives early. fx(i0,chunk) is called for each chunk as it arrives,
+     * where i0 is the position of chunk[0] in tsv.
+     */
+    void evaluate_chunked(ts_vector_t const& tsv, utcperiod p,bool use_ts_cached_read,bool update_ts_cache,
+                          size_t chunk_size,const std::function<void(size_t,const ts_vector_t&)>& fx);
+
+    /** \brief evaluate several independent ts-vectors pipelined over the connection(s)
+     *
+     * All requests are sent tagged with request-ids without waiting for replies,
+     * the server evaluates them concurrently, and replies as they complete.
+     * With more than one server, the requests are distributed round-robin.
+     * Servers prior to pipelining, (no wire version), get the requests one at the time.
+     * If any of the requests fails, the first failing (by position) exception is thrown.
+     *
+     * \return the evaluated ts-vectors, in the order of tsvs
+     */
+    vector<ts_vector_t> evaluate_pipelined(const vector<ts_vector_t>& tsvs, utcperiod p,bool use_ts_cached_read,bool update_ts_cache);
+
 	void store_ts(const ts_vector_t &tsv, bool overwrite_on_write, bool cache_on_write) ;
     
     void merge_store_ts(const ts_vector_t &tsv, bool cache_on_write) ;
@@ -10,6 +10,8 @@
 #include <utility>
 #include <functional>
 #include <cstring>
+#include <cctype>
+#include <mutex>
 
 #include <boost/filesystem.hpp>
 namespace fs = boost::filesystem;
@@ -18,11 +20,13 @@ namespace fs = boost::filesystem;
 
 #ifdef _WIN32
 #include <io.h>
+#include <intrin.h>
 #else
 #include <sys/io.h>
 #define O_BINARY 0
 #define O_SEQUENTIAL 0
 #include <sys/stat.h>
+#include <sys/file.h>
 #endif
 #include <fcntl.h>
 
@@ -83,6 +87,13 @@ using gts_t = shyft::time_series::point_ts<gta_t>;
  *
  * <values>         -> double[<n>] // <n> from the header
  *
+ * if signature is 'TS2', the values are compressed in independent blocks, \ref ts_db_value_codec :
+ * <values>         -> <block_n> <n_blocks> <offsets> <blocks>
+ *      <block_n>   -> uint32_t // number of values pr. block, last block could have less
+ *     <n_blocks>   -> uint32_t
+ *      <offsets>   -> uint64_t[<n_blocks>+1] // byte offset of each block, relative to start of <blocks>
+ *       <blocks>   -> uint8_t[<offsets>[<n_blocks>]] // compressed values
+ *
  */
 #pragma pack(push,1)
 struct ts_db_header {
@@ -96,9 +107,551 @@ struct ts_db_header {
 	ts_db_header(time_series::ts_point_fx point_fx, time_axis::generic_dt::generic_type ta_type, uint32_t n, utcperiod data_period)
 		: point_fx(point_fx), ta_type(ta_type), n(n), data_period(data_period) {
 	}
+	bool compressed_values() const { return signature[2] == '2'; }
+	void set_compressed_values(bool c) { signature[2] = c ? '2' : '1'; }
 };
 #pragma pack(pop)
 
+/** \brief xor (gorilla-style) compression of ts_db value blocks
+ *
+ * Each value is xor'ed with the previous one, and only the meaningful bits of the xor are stored:
+ *
+ *     '0'                             same as previous value (runs of nan, repeated values)
+ *     '10' <bits>                     meaningful bits fits within the previous leading/trailing zero window
+ *     '11' <lz:5> <len-1:6> <bits>    new window of leading zeros lz, and len meaningful bits
+ *
+ * The first value of a block is stored as is (64 bits), so each block decodes independently.
+ */
+struct ts_db_value_codec {
+
+	static void encode(const double* v, std::size_t n, std::vector<char>& out) {
+		if (n == 0)
+			return;
+		bit_writer w{ out };
+		uint64_t prev = bits_of(v[0]);
+		w.put(prev, 64);
+		int p_lz = -1, p_tz = 0;
+		for (std::size_t i = 1; i < n; ++i) {
+			uint64_t cur = bits_of(v[i]);
+			uint64_t x = cur ^ prev;
+			prev = cur;
+			if (x == 0) {
+				w.put(0, 1);
+				continue;
+			}
+			int lz = std::min(clz(x), 31);
+			int tz = ctz(x);
+			if (p_lz >= 0 && lz >= p_lz && tz >= p_tz) {
+				w.put(2, 2);
+				w.put(x >> p_tz, 64 - p_lz - p_tz);
+			} else {
+				int len = 64 - lz - tz;
+				w.put(3, 2);
+				w.put(uint64_t(lz), 5);
+				w.put(uint64_t(len - 1), 6);
+				w.put(x >> tz, len);
+				p_lz = lz; p_tz = tz;
+			}
+		}
+		w.finish();
+	}
+
+	static void decode(const char* d, std::size_t sz, double* v, std::size_t n) {
+		if (n == 0)
+			return;
+		bit_reader r{ reinterpret_cast<const unsigned char*>(d), sz };
+		uint64_t prev = r.get(64);
+		v[0] = value_of(prev);
+		int p_lz = 0, p_tz = 0;
+		for (std::size_t i = 1; i < n; ++i) {
+			if (r.get(1)) {
+				if (r.get(1)) {
+					p_lz = int(r.get(5));
+					int len = int(r.get(6)) + 1;
+					p_tz = 64 - p_lz - len;
+				}
+				prev ^= r.get(64 - p_lz - p_tz) << p_tz;
+			}
+			v[i] = value_of(prev);
+		}
+	}
+
+private:
+	static uint64_t bits_of(double x) { uint64_t b; std::memcpy(&b, &x, sizeof(b)); return b; }
+	static double value_of(uint64_t b) { double x; std::memcpy(&x, &b, sizeof(x)); return x; }
+#ifdef _WIN32
+	static int clz(uint64_t x) { unsigned long i; _BitScanReverse64(&i, x); return 63 - int(i); }
+	static int ctz(uint64_t x) { unsigned long i; _BitScanForward64(&i, x); return int(i); }
+#else
+	static int clz(uint64_t x) { return __builtin_clzll(x); }
+	static int ctz(uint64_t x) { return __builtin_ctzll(x); }
+#endif
+
+	/** msb-first bit-stream appended to out */
+	struct bit_writer {
+		std::vector<char>& out;
+		uint64_t acc = 0;
+		int n = 0;
+		void put(uint64_t b, int nb) {
+			while (nb > 0) {
+				int k = std::min(nb, 64 - n);
+				uint64_t chunk = k == 64 ? b : (b >> (nb - k)) & ((uint64_t(1) << k) - 1);
+				acc = k == 64 ? chunk : (acc << k) | chunk;
+				n += k; nb -= k;
+				if (n == 64)
+					flush(8);
+			}
+		}
+		void finish() {
+			if (n) {
+				acc <<= (64 - n);
+				flush((n + 7) / 8);
+			}
+		}
+		void flush(int n_bytes) {
+			for (int i = 0; i < n_bytes; ++i)
+				out.push_back(char(acc >> (56 - 8*i)));
+			acc = 0; n = 0;
+		}
+	};
+
+	struct bit_reader {
+		const unsigned char* d;
+		std::size_t sz;
+		std::size_t pos = 0;///< bit position
+		uint64_t get(int nb) {
+			uint64_t r = 0;
+			while (nb > 0) {
+				std::size_t byte = pos >> 3;
+				if (byte >= sz)
+					throw std::runtime_error("dtss_store: corrupt compressed values");
+				int avail = 8 - int(pos & 7);
+				int k = std::min(nb, avail);
+				r = (r << k) | ((d[byte] >> (avail - k)) & ((1u << k) - 1));
+				pos += k; nb -= k;
+			}
+			return r;
+		}
+	};
+};
+
+/** \brief persistent catalog of the ts in a ts_db container
+ *
+ * Keeps the ts_info of every ts in the container, so that find() can be answered
+ * without scanning the directory tree, nor opening the ts-files to read the headers.
+ *
+ * The in-memory index is ordered on the lower-case ts name, so a find with an anchored
+ * literal prefix, like '^hydmet_station/1/.*', only visits the range of names starting with that prefix,
+ * \ref literal_prefix.
+ *
+ * The catalog is persisted as an append-only log in the file '.ts_db_catalog' at the container root:
+ *
+ *  <catalog>   -> 'TSC1' <record>*
+ *  <record>    -> <put> | <remove>
+ *  <put>       -> 1:uint8_t <name> <point_fx:int8_t> <data_period:int64_t int64_t> <modified:int64_t>
+ *  <remove>    -> 2:uint8_t <name>
+ *  <name>      -> <sz:uint32_t> uint8_t[<sz>]
+ *
+ * Each record is written with one fwrite, so other ts_db instances on the same container (possibly
+ * in other processes) can follow the changes by replaying the tail of the log, \ref refresh.
+ * When the log grows well beyond the number of ts, it is compacted to one put pr. ts.
+ * Appends and compactions hold an exclusive lock on the file, and compaction replaces the file,
+ * so writers check that the locked file is still the catalog, and reopen it otherwise, \ref lock_log.
+ *
+ * The catalog is loaded on first use, and if it can not be written, e.g. a read-only container,
+ * it is kept in memory only, \ref reset.
+ *
+ * \note ts-files written directly to the container, bypassing ts_db, are not in the catalog
+ *       until ts_db::rebuild_catalog is called.
+ */
+struct ts_db_catalog {
+	static std::string file_name() { return ".ts_db_catalog"; } ///< name of the catalog file at the container root
+
+	explicit ts_db_catalog(const std::string& root_dir) :fn((fs::path(root_dir) / file_name()).string()) {}
+	~ts_db_catalog() { close_log(); }
+	ts_db_catalog(const ts_db_catalog&) = delete;
+	ts_db_catalog& operator=(const ts_db_catalog&) = delete;
+
+	/** load the persisted catalog, \return false if there is none(or it is not readable), and a rebuild is needed */
+	bool load() {
+		std::lock_guard<std::mutex> lock(mx);
+		return load_log();
+	}
+
+	/** load the catalog on first use, and then follow changes made by other instances,
+	 * \return false if the catalog file is missing, and a rebuild is needed
+	 */
+	bool refresh() {
+		std::lock_guard<std::mutex> lock(mx);
+		if (!persistent)
+			return true;
+		file_id id;
+		if (!path_id(fn, id))
+			return false;
+		if (!loaded || id != log_id) // first use, or compacted by someone else
+			return load_log();
+		boost::system::error_code ec;
+		auto sz = fs::file_size(fn, ec);
+		if (ec)
+			return false;
+		if (sz == log_end)
+			return true;
+		if (sz < log_end)
+			return load_log();
+		return replay(log_end, sz);
+	}
+
+	/** replace the catalog with tsi, and persist it as a compact log, or keep it in memory only if the container is read-only */
+	void reset(const std::vector<ts_info>& tsi) {
+		std::lock_guard<std::mutex> lock(mx);
+		index.clear();
+		for (const auto& i : tsi)
+			index[key(i.name)] = i;
+		loaded = true;
+		persistent = true;
+		try {
+			log_lock lk(*this);
+			compact();
+		} catch (const std::exception&) {
+			close_log();
+			persistent = false;
+		}
+	}
+
+	/** add or update the ts_info for i.name */
+	void put(const ts_info& i) {
+		std::lock_guard<std::mutex> lock(mx);
+		std::string r;
+		r.push_back(char(PUT));
+		append_name(r, i.name);
+		append_pod(r, int8_t(i.point_fx));
+		append_pod(r, int64_t(i.data_period.start));
+		append_pod(r, int64_t(i.data_period.end));
+		append_pod(r, int64_t(i.modified));
+		update(r, [this, &i]() { index[key(i.name)] = i; });
+	}
+
+	/** remove the ts name from the catalog */
+	void remove(const std::string& name) {
+		std::lock_guard<std::mutex> lock(mx);
+		std::string r;
+		r.push_back(char(REMOVE));
+		append_name(r, name);
+		update(r, [this, &name]() { index.erase(key(name)); });
+	}
+
+	/** \return ts_info for all names that matches the regular expression, same semantics as ts_db::find */
+	std::vector<ts_info> find(const std::string& match) const {
+		std::regex r_match(match, std::regex_constants::ECMAScript | std::regex_constants::icase);
+		std::string prefix = lower(literal_prefix(match));
+		std::vector<ts_info> r;
+		std::lock_guard<std::mutex> lock(mx);
+		for (auto it = index.lower_bound(prefix); it != index.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+			if (std::regex_search(it->second.name, r_match))
+				r.push_back(it->second);
+		}
+		return r;
+	}
+
+	std::size_t size() const {
+		std::lock_guard<std::mutex> lock(mx);
+		return index.size();
+	}
+
+	/** false if the catalog could not be written, e.g. a read-only container, and is kept in memory only */
+	bool is_persistent() const {
+		std::lock_guard<std::mutex> lock(mx);
+		return persistent;
+	}
+
+	/** \brief the literal prefix that any name matched by the regular expression must start with
+	 *
+	 * Only expressions anchored with '^', without alternation, have a prefix,
+	 * e.g. '^hydmet_station/1/.*' -> 'hydmet_station/1/', but 'hydmet_station/1/.*' -> ''.
+	 */
+	static std::string literal_prefix(const std::string& match) {
+		std::string r;
+		if (match.empty() || match[0] != '^' || match.find('|') != std::string::npos)
+			return r;
+		static const std::string special("\\^$.|?*+()[]{}");
+		for (std::size_t i = 1; i < match.size(); ++i) {
+			char c = match[i];
+			if (special.find(c) != std::string::npos) {
+				if ((c == '?' || c == '*' || c == '{') && r.size())
+					r.pop_back(); // the last char is optional
+				break;
+			}
+			r.push_back(c);
+		}
+		return r;
+	}
+
+private:
+	enum record_type : uint8_t { PUT = 1, REMOVE = 2 };
+	static const char* magic() { return "TSC1"; }
+	static const std::size_t magic_sz = 4;
+
+	/** identity of a file, so that we can tell when the catalog file is replaced by a compaction */
+	struct file_id {
+		uint64_t dev{ 0 };
+		uint64_t ino{ 0 };
+		bool operator==(const file_id& o) const { return dev == o.dev && ino == o.ino; }
+		bool operator!=(const file_id& o) const { return !(*this == o); }
+	};
+
+	/** exclusive lock of the catalog file, held while appending or compacting, \ref lock_log */
+	struct log_lock {
+		ts_db_catalog& c;
+		explicit log_lock(ts_db_catalog& c) :c(c) { c.lock_log(); }
+		~log_lock() { c.unlock_log(); }
+		log_lock(const log_lock&) = delete;
+		log_lock& operator=(const log_lock&) = delete;
+	};
+
+	std::string fn; ///< full path of the catalog file
+	mutable std::mutex mx;
+	std::map<std::string, ts_info> index; ///< lower(name) '\0' name -> ts_info, ordered for prefix search
+	std::FILE* log = nullptr; ///< the catalog file, opened for append
+	file_id log_id; ///< the catalog file we are in sync with
+	uint64_t log_end = 0; ///< the size of the log we are in sync with
+	std::size_t n_records = 0; ///< records in the log, to decide when to compact
+	bool loaded = false; ///< the index is loaded, or rebuilt, done lazily on first use
+	bool persistent = true; ///< false if the catalog could not be written, and lives in memory only
+
+	static std::string lower(const std::string& s) {
+		std::string r(s);
+		for (auto& c : r)
+			c = char(std::tolower((unsigned char)c));
+		return r;
+	}
+	static std::string key(const std::string& name) {
+		std::string k = lower(name);
+		k.push_back('\0');
+		return k + name;
+	}
+	template <class V>
+	static void append_pod(std::string& r, const V& x) {
+		r.append((const char*)&x, sizeof(x));
+	}
+	static void append_name(std::string& r, const std::string& name) {
+		append_pod(r, uint32_t(name.size()));
+		r.append(name);
+	}
+
+	static file_id handle_id(std::FILE* fh) {
+		file_id r;
+#ifndef _WIN32
+		struct stat s;
+		if (::fstat(::fileno(fh), &s) == 0) {
+			r.dev = uint64_t(s.st_dev);
+			r.ino = uint64_t(s.st_ino);
+		}
+#endif
+		return r;
+	}
+	/** \return false if there is no file fn */
+	static bool path_id(const std::string& fn, file_id& r) {
+#ifndef _WIN32
+		struct stat s;
+		if (::stat(fn.c_str(), &s) != 0)
+			return false;
+		r.dev = uint64_t(s.st_dev);
+		r.ino = uint64_t(s.st_ino);
+		return true;
+#else
+		r = file_id{};
+		return fs::exists(fn);
+#endif
+	}
+
+	void close_log() {
+		if (log) {
+			std::fclose(log);
+			log = nullptr;
+		}
+	}
+
+	/** \brief open the catalog file for append, and lock it exclusively
+	 *
+	 * If another instance compacted the catalog while we waited for the lock,
+	 * the handle refers to the replaced file, so we reopen and lock the new one.
+	 * \note on windows there is no locking, so there only one instance should write to a container.
+	 */
+	void lock_log() {
+		for (;;) {
+			if (!log) {
+				log = std::fopen(fn.c_str(), "ab");
+				if (!log)
+					throw std::runtime_error("ts_db: failed to open catalog " + fn);
+			}
+#ifndef _WIN32
+			if (::flock(::fileno(log), LOCK_EX) != 0)
+				throw std::runtime_error("ts_db: failed to lock catalog " + fn);
+			file_id id;
+			if (path_id(fn, id) && id == handle_id(log))
+				return;
+			close_log();
+#else
+			return;
+#endif
+		}
+	}
+
+	void unlock_log() noexcept {
+#ifndef _WIN32
+		if (log)
+			::flock(::fileno(log), LOCK_UN);
+#endif
+	}
+
+	/** \brief with the log locked, catch up with the records written by others
+	 *
+	 * A partial last record, from a crashed writer, is dropped by a compaction.
+	 * \return false if the catalog file is not readable, then it is removed, to be rebuilt on the next find
+	 */
+	bool sync_log() {
+		std::fseek(log, 0, SEEK_END);
+		uint64_t sz = uint64_t(std::ftell(log));
+		if (!loaded || handle_id(log) != log_id || sz < log_end) {
+			if (!load_log()) {
+				close_log();
+				boost::system::error_code ec;
+				fs::remove(fn, ec);
+				return false;
+			}
+		} else if (sz > log_end) {
+			replay(log_end, sz);
+		}
+		if (log_end < sz) {
+			compact();
+			lock_log();
+		}
+		return true;
+	}
+
+	/** append record r to the log, in sync with other instances, then apply it to the index */
+	template <class F>
+	void update(const std::string& r, F&& apply) {
+		if (!persistent || (!loaded && !fs::exists(fn))) { // nothing to keep in sync with, the ts-file will be found by the rebuild
+			apply();
+			return;
+		}
+		log_lock lk(*this);
+		if (!sync_log()) {
+			apply();
+			return;
+		}
+		if (std::fwrite(r.data(), sizeof(char), r.size(), log) != r.size() || std::fflush(log) != 0)
+			throw std::runtime_error("ts_db: failed to write catalog " + fn);
+		log_end += r.size();
+		apply();
+		if (++n_records > 2*index.size() + 1000)
+			compact();
+	}
+
+	/** write the index as puts to a new file, and replace the log with it, the log must be locked, \ref lock_log */
+	void compact() {
+		std::string tmp_fn = fn + ".tmp";
+		std::unique_ptr<std::FILE, decltype(&std::fclose)> fh{ std::fopen(tmp_fn.c_str(), "wb"), &std::fclose };
+		if (!fh.get())
+			throw std::runtime_error("ts_db: failed to create catalog " + tmp_fn);
+		std::string r(magic(), magic_sz);
+		for (const auto& x : index) {
+			const auto& i = x.second;
+			r.push_back(char(PUT));
+			append_name(r, i.name);
+			append_pod(r, int8_t(i.point_fx));
+			append_pod(r, int64_t(i.data_period.start));
+			append_pod(r, int64_t(i.data_period.end));
+			append_pod(r, int64_t(i.modified));
+		}
+		if (std::fwrite(r.data(), sizeof(char), r.size(), fh.get()) != r.size() || std::fflush(fh.get()) != 0)
+			throw std::runtime_error("ts_db: failed to write catalog " + tmp_fn);
+		auto id = handle_id(fh.get());
+		fh.reset();
+		fs::rename(tmp_fn, fn);
+		close_log(); // releases the lock, instances waiting for it will see the new file
+		log_id = id;
+		log_end = r.size();
+		n_records = index.size();
+		loaded = true;
+	}
+
+	bool load_log() {
+		index.clear();
+		log_end = 0;
+		n_records = 0;
+		loaded = false;
+		std::unique_ptr<std::FILE, decltype(&std::fclose)> fh{ std::fopen(fn.c_str(), "rb"), &std::fclose };
+		if (!fh.get())
+			return false;
+		log_id = handle_id(fh.get());
+		char m[magic_sz];
+		if (std::fseek(fh.get(), 0, SEEK_END) != 0)
+			return false;
+		uint64_t sz = uint64_t(std::ftell(fh.get()));
+		std::rewind(fh.get());
+		if (sz < magic_sz || std::fread(m, sizeof(char), magic_sz, fh.get()) != magic_sz || std::memcmp(m, magic(), magic_sz) != 0)
+			return false;
+		log_end = magic_sz;
+		loaded = replay(fh.get(), magic_sz, sz);
+		return loaded;
+	}
+
+	/** apply the complete records in [from..to> of the log file, a partial last record is left for later */
+	bool replay(uint64_t from, uint64_t to) {
+		std::unique_ptr<std::FILE, decltype(&std::fclose)> fh{ std::fopen(fn.c_str(), "rb"), &std::fclose };
+		if (!fh.get())
+			return false;
+		return replay(fh.get(), from, to);
+	}
+
+	bool replay(std::FILE* fh, uint64_t from, uint64_t to) {
+		std::vector<char> buf(std::size_t(to - from));
+		if (std::fseek(fh, long(from), SEEK_SET) != 0 || std::fread(buf.data(), sizeof(char), buf.size(), fh) != buf.size())
+			return false;
+		const char* p = buf.data();
+		const char* e = p + buf.size();
+		auto take = [&p, e](void* d, std::size_t n) {
+			if (std::size_t(e - p) < n)
+				return false;
+			std::memcpy(d, p, n);
+			p += n;
+			return true;
+		};
+		while (p < e) {
+			const char* r0 = p;
+			uint8_t op; uint32_t sz;
+			if (!take(&op, sizeof(op)) || !take(&sz, sizeof(sz)) || std::size_t(e - p) < sz) {
+				p = r0;
+				break;
+			}
+			std::string name(p, sz);
+			p += sz;
+			if (op == PUT) {
+				int8_t fx; int64_t t0, t1, modified;
+				if (!take(&fx, sizeof(fx)) || !take(&t0, sizeof(t0)) || !take(&t1, sizeof(t1)) || !take(&modified, sizeof(modified))) {
+					p = r0;
+					break;
+				}
+				ts_info i;
+				i.name = name;
+				i.point_fx = time_series::ts_point_fx(fx);
+				i.data_period = utcperiod(utctime(t0), utctime(t1));
+				i.modified = utctime(modified);
+				index[key(name)] = i;
+			} else if (op == REMOVE) {
+				index.erase(key(name));
+			} else {
+				return false;
+			}
+			++n_records;
+		}
+		log_end = from + uint64_t(p - buf.data());
+		return true;
+	}
+};
+
 
 /** \brief A simple file-io based internal time-series storage for the dtss.
  *
@@ -136,7 +689,10 @@ struct ts_db_header {
  */
 struct ts_db {
 	std::string root_dir; ///< root_dir points to the top of the container
+	bool compress_values{ false }; ///< if true, save() writes compressed value blocks, \ref ts_db_value_codec, reading handles both
+	static const uint32_t compressed_block_n = 4096; ///< values pr. compressed block, the unit of decompression for a period read
   private:
+	std::shared_ptr<ts_db_catalog> catalog; ///< ts_info of all ts in the container, serving find(), shared by copies
 
   	/** helper class needed for win compensating code */
 	struct close_write_handle {
@@ -203,6 +759,7 @@ public:
 			}
 		}
 		make_calendar_lookups();
+		catalog = std::make_shared<ts_db_catalog>(root_dir);// loaded, or rebuilt, on the first find
 	}
 
 	~ts_db() {
@@ -211,12 +768,14 @@ public:
 
 	// note that we need special care(windows) for the operations below
 	// basically we don't copy/move the fclose_windows, rather just wait it out before overwrite.
-	ts_db(const ts_db&c) :root_dir(c.root_dir),calendars(c.calendars) {}
-	ts_db(ts_db&&c) :root_dir(c.root_dir), calendars(c.calendars) {};
+	ts_db(const ts_db&c) :root_dir(c.root_dir), compress_values(c.compress_values), catalog(c.catalog), calendars(c.calendars) {}
+	ts_db(ts_db&&c) :root_dir(c.root_dir), compress_values(c.compress_values), catalog(c.catalog), calendars(c.calendars) {};
 	ts_db & operator=(const ts_db&o) {
 		if (&o != this) {
 			wait_for_close_fh();
 			root_dir = o.root_dir;
+			compress_values = o.compress_values;
+			catalog = o.catalog;
 			calendars = o.calendars;
 		}
 		return *this;
@@ -225,6 +784,8 @@ public:
 		if (&o != this) {
 			wait_for_close_fh();
 			root_dir = o.root_dir;
+			compress_values = o.compress_values;
+			catalog = o.catalog;
 			calendars = o.calendars;
 		}
 		return *this;
@@ -267,11 +828,23 @@ public:
 		} else {
             fh.reset(std::fopen(ffp.c_str(), "wb"));
 		}
+		ts_db_header h;
 		if (!do_merge) {
-			write_ts(fh.get(), ts);
+			write_ts(fh.get(), ts, compress_values);
+			h = mk_header(ts, compress_values);
+		} else if (old_header.compressed_values() || compress_values) {
+			// the in-place merge works on raw values, so decode once, merge in memory, and rewrite the file
+			auto merged = merge_decoded(old_header, read_ts(fh.get(), utcperiod{}), ts);
+			wait_for_close_fh();
+			fh.reset(std::fopen(ffp.c_str(), "wb"));
+			write_ts(fh.get(), merged, compress_values);
+			h = mk_header(merged, compress_values);
 		} else {
 			merge_ts(fh.get(), old_header, ts);
+			h = read_header(fh.get());
 		}
+		if (catalog)
+			catalog->put(mk_ts_info(catalog_name(ffp), h, core::utctime_now()));
 	}
 
 	/** read a ts from specified file */
@@ -292,6 +865,8 @@ public:
 		for (std::size_t retry = 0; retry < 10; ++retry) {
 			try {
 				fs::remove(fp);
+				if (catalog)
+					catalog->remove(catalog_name(fp));
 				return;
 			} catch (...) { // windows usually fails, due to delayed file-close/file-release so we retry 10 x 0.3 seconds
 				std::this_thread::sleep_for(std::chrono::duration<int, std::milli>(300));
@@ -306,38 +881,56 @@ public:
 		auto ffp = make_full_path(fn);
 		std::unique_ptr<std::FILE, decltype(&std::fclose)> fh{ std::fopen(ffp.c_str(), "rb"), &std::fclose };
 		auto h = read_header(fh.get());
-		ts_info i;
-		i.name = fn;
-		i.point_fx = h.point_fx;
-		i.modified = utctime(fs::last_write_time(ffp));
-		i.data_period = h.data_period;
-		// consider time-axis type info, dt.. as well
-		return i;
+		return mk_ts_info(fn, h, utctime(fs::last_write_time(ffp)));
 	}
 
 	/** find all ts_info s that matches the specified re match string
 	 *
 	 * e.g.: match= 'hydmet_station/.*_id/temperature'
 	 *    would find all time-series /hydmet_station/xxx_id/temperature
+	 *
+	 * The search is done in the container catalog, without touching the ts-files,
+	 * anchor the match, like '^hydmet_station/', to limit the search to names with that prefix,
+	 * \ref ts_db_catalog
 	 */
 	std::vector<ts_info> find(const std::string& match) const {
 		wait_for_close_fh();
+		if (!catalog)
+			return std::vector<ts_info>{};
+		if (!catalog->refresh())
+			rebuild_catalog();
+		return catalog->find(match);
+	}
+
+	/** rebuild the container catalog by scanning the container for ts-files
+	 *
+	 * Done automatically if the container has no catalog, and needed only
+	 * if ts-files are added/removed to the container bypassing the ts_db.
+	 */
+	void rebuild_catalog() const {
+		wait_for_close_fh();
+		if (!catalog)
+			return;
 		fs::path root(root_dir);
 		std::vector<ts_info> r;
-		std::regex r_match(match, std::regex_constants::ECMAScript | std::regex_constants::icase);
 		for (auto&& x : fs::recursive_directory_iterator(root)) {
-			if (fs::is_regular(x.path())) {
-				std::string fn = x.path().lexically_relative(root).generic_string(); // x.path() except root-part
-				if (std::regex_search(fn, r_match)) {
-					r.push_back(get_ts_info(fn)); // TODO: maybe multi-core this into a job-queue
-				}
-			} else if (fs::is_directory(x.path())) {
-				// TODO: elide recursion into the x, calling
-				// if x.path is not part of match
-				//   x.no_push();
+			if (!fs::is_regular(x.path()))
+				continue;
+			std::string fn = x.path().lexically_relative(root).generic_string(); // x.path() except root-part
+			if (fn.compare(0, ts_db_catalog::file_name().size(), ts_db_catalog::file_name()) == 0)
+				continue;
+			try {
+				std::unique_ptr<std::FILE, decltype(&std::fclose)> fh{ std::fopen(x.path().string().c_str(), "rb"), &std::fclose };
+				if (!fh.get())
+					continue;
+				auto h = read_header(fh.get());
+				if (h.signature[0] == 'T' && h.signature[1] == 'S')
+					r.push_back(mk_ts_info(fn, h, utctime(fs::last_write_time(x.path()))));
+			} catch (const std::exception&) {
+				// too short to be a ts-file, skip it
 			}
 		}
-		return r;
+		catalog->reset(r);
 	}
 
 private:
@@ -389,8 +982,25 @@ private:
 		return fn_path.string();
 	}
 
-	ts_db_header mk_header(const gts_t& ts) const {
-		return ts_db_header{ ts.point_interpretation(),ts.time_axis().gt,uint32_t(ts.size()),ts.total_period() };
+	/** the name of the ts in the catalog, the container relative path, as for find() */
+	std::string catalog_name(const std::string& ffp) const {
+		return fs::path(ffp).lexically_normal().lexically_relative(fs::path(root_dir).lexically_normal()).generic_string();
+	}
+
+	static ts_info mk_ts_info(const std::string& name, const ts_db_header& h, utctime modified) {
+		ts_info i;
+		i.name = name;
+		i.point_fx = h.point_fx;
+		i.modified = modified;
+		i.data_period = h.data_period;
+		// consider time-axis type info, dt.. as well
+		return i;
+	}
+
+	ts_db_header mk_header(const gts_t& ts, bool compressed) const {
+		ts_db_header h{ ts.point_interpretation(),ts.time_axis().gt,uint32_t(ts.size()),ts.total_period() };
+		h.set_compressed_values(compressed);
+		return h;
 	}
 
 	// ----------
@@ -399,8 +1009,8 @@ private:
 		if (std::fwrite(d, sizeof(char), sz, fh) != sz)
 			throw std::runtime_error("dtss_store: failed to write do disk");
 	}
-	void write_header(std::FILE * fh, const gts_t & ats) const {
-		ts_db_header h = mk_header(ats);
+	void write_header(std::FILE * fh, const gts_t & ats, bool compressed) const {
+		ts_db_header h = mk_header(ats, compressed);
 		write(fh, static_cast<const void*>(&h), sizeof(h));
 	}
 	void write_time_axis(std::FILE * fh, const gta_t& ta) const {
@@ -426,10 +1036,77 @@ private:
 	void write_values(std::FILE * fh, const std::vector<double>& v) const {
 		write(fh, static_cast<const void*>(v.data()), sizeof(double)*v.size());
 	}
-	void write_ts(std::FILE * fh, const gts_t& ats) const {
-		write_header(fh, ats);
+	void write_compressed_values(std::FILE * fh, const std::vector<double>& v) const {
+		uint32_t block_n = compressed_block_n;
+		uint32_t n_blocks = uint32_t((v.size() + block_n - 1) / block_n);
+		std::vector<uint64_t> offsets; offsets.reserve(n_blocks + 1);
+		std::vector<char> blocks; blocks.reserve(v.size()*2);// typically a lot less than 8 bytes/value
+		for (uint32_t b = 0; b < n_blocks; ++b) {
+			offsets.push_back(blocks.size());
+			std::size_t i0 = std::size_t(b)*block_n;
+			ts_db_value_codec::encode(v.data() + i0, std::min<std::size_t>(block_n, v.size() - i0), blocks);
+		}
+		offsets.push_back(blocks.size());
+		write(fh, static_cast<const void*>(&block_n), sizeof(block_n));
+		write(fh, static_cast<const void*>(&n_blocks), sizeof(n_blocks));
+		write(fh, static_cast<const void*>(offsets.data()), sizeof(uint64_t)*offsets.size());
+		write(fh, static_cast<const void*>(blocks.data()), blocks.size());
+	}
+	void write_ts(std::FILE * fh, const gts_t& ats, bool compressed) const {
+		write_header(fh, ats, compressed);
 		write_time_axis(fh, ats.ta);
-		write_values(fh, ats.v);
+		if (compressed)
+			write_compressed_values(fh, ats.v);
+		else
+			write_values(fh, ats.v);
+	}
+	/** \return old_ts merged with ats, as merge_ts does in-place on a raw file, but on the decoded values in memory */
+	gts_t merge_decoded(const ts_db_header & old_header, const gts_t & old_ts, const gts_t & ats) const {
+		check_ta_alignment(old_header, old_ts.ta, ats);
+		const core::utcperiod old_p = old_ts.ta.total_period(), new_p = ats.ta.total_period();
+		const core::utctime t0 = std::min(old_p.start, new_p.start), tn = std::max(old_p.end, new_p.end);
+		switch (old_header.ta_type) {
+		case time_axis::generic_dt::FIXED: {
+			auto ix = [&](core::utctime t) { return static_cast<std::size_t>((t - t0) / ats.ta.f.dt); };
+			std::vector<double> v(ix(tn), shyft::nan);// gaps between old and new are nan
+			std::copy(old_ts.v.cbegin(), old_ts.v.cend(), v.begin() + ix(old_p.start));
+			std::copy(ats.v.cbegin(), ats.v.cend(), v.begin() + ix(new_p.start));
+			return gts_t{ gta_t(t0, ats.ta.f.dt, v.size()), std::move(v), old_header.point_fx };
+		}
+		case time_axis::generic_dt::CALENDAR: {
+			auto ix = [&](core::utctime t) { return static_cast<std::size_t>(ats.ta.c.cal->diff_units(t0, t, ats.ta.c.dt)); };
+			std::vector<double> v(ix(tn), shyft::nan);
+			std::copy(old_ts.v.cbegin(), old_ts.v.cend(), v.begin() + ix(old_p.start));
+			std::copy(ats.v.cbegin(), ats.v.cend(), v.begin() + ix(new_p.start));
+			return gts_t{ gta_t(ats.ta.c.cal, t0, ats.ta.c.dt, v.size()), std::move(v), old_header.point_fx };
+		}
+		case time_axis::generic_dt::POINT: break;
+		}
+		const auto& ot = old_ts.ta.p.t;
+		std::vector<core::utctime> t;
+		t.reserve(ot.size() + ats.size() + 2);
+		std::vector<double> v;
+		v.reserve(ot.size() + ats.size() + 2);
+		// old points before new start, and the gap up to the new start
+		auto old_end = std::lower_bound(ot.cbegin(), ot.cend(), new_p.start);
+		t.insert(t.end(), ot.cbegin(), old_end);
+		v.insert(v.end(), old_ts.v.cbegin(), old_ts.v.cbegin() + std::distance(ot.cbegin(), old_end));
+		if (new_p.start > old_p.end) {
+			t.emplace_back(old_p.end);
+			v.emplace_back(shyft::nan);
+		}
+		t.insert(t.end(), ats.ta.p.t.cbegin(), ats.ta.p.t.cend());
+		v.insert(v.end(), ats.v.cbegin(), ats.v.cend());
+		if (new_p.end >= old_p.end)
+			return gts_t{ gta_t(t, new_p.end), std::move(v), old_header.point_fx };
+		// old points after new end, starting with the old value at new end, or nan for the gap up to the old start
+		auto old_begin = std::upper_bound(ot.cbegin(), ot.cend(), new_p.end);
+		std::size_t ib = std::distance(ot.cbegin(), old_begin);
+		t.emplace_back(new_p.end);
+		v.emplace_back(ib > 0 ? old_ts.v[ib - 1] : shyft::nan);
+		t.insert(t.end(), old_begin, ot.cend());
+		v.insert(v.end(), old_ts.v.cbegin() + ib, old_ts.v.cend());
+		return gts_t{ gta_t(t, old_p.end), std::move(v), old_header.point_fx };
 	}
 
 	// ----------
@@ -691,7 +1368,7 @@ private:
 		} break;
 		}
 	}
-	void check_ta_alignment(std::FILE * fh, const ts_db_header & old_header, const time_axis::generic_dt & old_ta, const gts_t & ats) const {
+	void check_ta_alignment(const ts_db_header & old_header, const time_axis::generic_dt & old_ta, const gts_t & ats) const {
 		if (ats.fx_policy != old_header.point_fx) {
 			throw std::runtime_error("dtss_store: cannot merge with different point interpretation");
 		}
@@ -728,7 +1405,7 @@ private:
 		std::size_t ignored{};
 		time_axis::generic_dt old_ta = read_time_axis(fh, old_header, old_header.data_period, ignored);
 
-		check_ta_alignment(fh, old_header, old_ta, ats);
+		check_ta_alignment(old_header, old_ta, ats);
 		do_merge(fh, old_header, old_ta, ats);
 	}
 
@@ -876,10 +1553,40 @@ private:
 
 		const std::size_t points_n = ta.size();
 		std::vector<double> val(points_n, 0.);
+		if (h.compressed_values()) {
+			read_compressed_values(fh, h, skip_n, val);
+			return val;
+		}
 		std::fseek(fh, sizeof(double)*skip_n, SEEK_CUR);
 		read(fh, static_cast<void *>(val.data()), sizeof(double)*points_n);
 		return val;
 	}
+	/** read val.size() values starting at skip_n, decompressing only the blocks covering them */
+	void read_compressed_values(std::FILE * fh, const ts_db_header& h, const std::size_t skip_n, std::vector<double>& val) const {
+		if (val.size() == 0)
+			return;
+		uint32_t block_n{}, n_blocks{};
+		read(fh, static_cast<void*>(&block_n), sizeof(block_n));
+		read(fh, static_cast<void*>(&n_blocks), sizeof(n_blocks));
+		if (block_n == 0 || std::size_t(n_blocks)*block_n < skip_n + val.size())
+			throw std::runtime_error("dtss_store: corrupt compressed values header");
+		std::vector<uint64_t> offsets(n_blocks + 1);
+		read(fh, static_cast<void*>(offsets.data()), sizeof(uint64_t)*offsets.size());
+		std::size_t b0 = skip_n / block_n;
+		std::size_t b1 = (skip_n + val.size() - 1) / block_n;
+		std::vector<char> blocks(offsets[b1 + 1] - offsets[b0]);
+		std::fseek(fh, offsets[b0], SEEK_CUR);
+		read(fh, static_cast<void*>(blocks.data()), blocks.size());// one read for all needed blocks
+		std::vector<double> bv(block_n);
+		for (std::size_t b = b0; b <= b1; ++b) {
+			std::size_t i0 = b*block_n;// first value index of the block
+			std::size_t bn = std::min<std::size_t>(block_n, h.n - i0);
+			ts_db_value_codec::decode(blocks.data() + (offsets[b] - offsets[b0]), offsets[b + 1] - offsets[b], bv.data(), bn);
+			std::size_t from = std::max(i0, skip_n);
+			std::size_t to = std::min(i0 + bn, skip_n + val.size());
+			std::copy(bv.begin() + (from - i0), bv.begin() + (to - i0), val.begin() + (from - skip_n));
+		}
+	}
 	gts_t read_ts(std::FILE * fh, const utcperiod p) const {
 		std::size_t skip_n = 0u;
 		ts_db_header h = read_header(fh);
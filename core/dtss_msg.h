@@ -22,6 +22,11 @@ enum class message_type : uint8_t {
 	EVALUATE_EXPRESSION,
 	EVALUATE_EXPRESSION_PERCENTILES,
     MERGE_STORE_TS,
+    PIPELINED,///< envelope: request-id and one complete request/reply, allowing many in flight, replies out of order
+    EVALUATE_TS_VECTOR_CHUNKED,///< as EVALUATE_TS_VECTOR, but the reply is n_ts, followed by chunks of ts as evaluated
+    EVALUATE_EXPRESSION_CHUNKED,///< as EVALUATE_EXPRESSION, with the chunked reply of EVALUATE_TS_VECTOR_CHUNKED
+    GET_WIRE_FORMAT,///< no args, reply is int32 highest supported compact wire format version
+    SET_WIRE_FORMAT,///< int32 version, use this compact wire format for ts-vector replies on the connection, 0 for boost archive
 	// EVALUATE_TS_VECTOR_HISTOGRAM //-- tsv,period,ta,bin_min,bin_max -> ts_vector[n_bins]
 };
 
@@ -57,11 +62,30 @@ template <class T>
 std::string read_string(T& in) {
 	std::int32_t sz;
 	in.read((char*)&sz, sizeof(sz));
+	if (!in.good() || sz < 0)
+		throw std::runtime_error("dtss: failed to read string from stream");
 	std::string msg(sz, '\0');
 	in.read((char*)msg.data(), sz);
+	if (!in.good())
+		throw std::runtime_error("dtss: failed to read string from stream");
 	return msg;
 }
 
+/** pipelined envelope: type, request-id, then the enclosed message as a sized string */
+template <class T>
+void write_pipelined(int64_t request_id, const std::string& body, T& out) {
+	write_type(message_type::PIPELINED, out);
+	out.write((const char*)&request_id, sizeof(request_id));
+	write_string(body, out);
+}
+
+/** read request-id and body of a pipelined envelope, the PIPELINED type is already consumed */
+template <class T>
+std::string read_pipelined(int64_t& request_id, T& in) {
+	in.read((char*)&request_id, sizeof(request_id));
+	return read_string(in);
+}
+
 template <class T>
 void write_exception(const std::exception& e, T& out) {
 	int32_t sz = strlen(e.what());
@@ -0,0 +1,201 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+
+#include "core_serialization.h"
+#include "core_archive.h"
+#include "core/time_series_dd.h"
+
+namespace shyft {
+namespace dtss {
+namespace wire {
+
+/** \brief compact binary wire format for ts-vector replies
+ *
+ * The boost binary archives tracks each object, and are slow to read for large point-series.
+ * This is a versioned, schema-light alternative for vectors of concrete time-series:
+ *
+ *   int32 version, int64 n_ts, then for each ts:
+ *     int8 kind
+ *       NONE:    empty ts, nothing more
+ *       POINT:   int8 point_fx, int8 time-axis type, time-axis descriptor, int64 n, double v[n]
+ *                  fixed: int64 t, int64 dt, int64 n
+ *                  point: int64 n, int64 t[n], int64 t_end
+ *       ARCHIVE: the apoint_ts as a core archive, for anything else(calendar time-axis, expressions)
+ *
+ * Values and time-points are written directly from, and read directly into, the
+ * contiguous vectors of each ts, one block per vector.
+ * Integers and doubles are in native byte-order, as for the other dtss messages.
+ *
+ * The format is only used on connections where the client negotiated it,
+ * \sa message_type::GET_WIRE_FORMAT, message_type::SET_WIRE_FORMAT
+ */
+static const int32_t version = 1;///< the highest supported version, 0 means boost archives
+
+enum ts_kind : int8_t {
+    NONE = 0,
+    POINT = 1,
+    ARCHIVE = 2
+};
+
+using shyft::time_series::dd::apoint_ts;
+using shyft::time_series::dd::ats_vector;
+using shyft::time_series::dd::gpoint_ts;
+using shyft::time_series::dd::gta_t;
+using shyft::time_series::dd::gts_t;
+
+template <class T, class V>
+void write_pod(const V& x, T& out) {
+    out.write((const char*)&x, sizeof(x));
+}
+
+template <class V, class T>
+V read_pod(T& in) {
+    V x;
+    in.read((char*)&x, sizeof(x));
+    if (!in.good())
+        throw std::runtime_error("compact wire format: unexpected end of stream");
+    return x;
+}
+
+/** \return a length-prefix read from in, throws if negative */
+template <class T>
+size_t read_size(T& in) {
+    auto n = read_pod<int64_t>(in);
+    if (n < 0)
+        throw std::runtime_error("compact wire format: invalid length " + std::to_string(n));
+    return size_t(n);
+}
+
+/** read n pod values into v, growing v one block at a time, so that a corrupt length fails on the read, not on the allocation */
+template <class V, class T>
+void read_block(T& in, std::vector<V>& v, size_t n) {
+    const size_t block_n = size_t(1) << 20;
+    v.clear();
+    while (v.size() < n) {
+        const size_t i = v.size();
+        v.resize(i + std::min(block_n, n - i));
+        in.read((char*)(v.data() + i), (v.size() - i)*sizeof(V));
+        if (!in.good())
+            throw std::runtime_error("compact wire format: unexpected end of stream");
+    }
+}
+
+template <class T>
+void write_ts(const apoint_ts& ats, T& out) {
+    if (!ats.ts) {
+        write_pod(int8_t(NONE), out);
+        return;
+    }
+    auto gts = dynamic_cast<const gpoint_ts*>(ats.ts.get());
+    if (!gts || gts->rep.ta.gt == gta_t::CALENDAR) {
+        write_pod(int8_t(ARCHIVE), out);
+        core::core_oarchive oa(out, core_arch_flags);
+        oa << ats;
+        return;
+    }
+    const auto& ta = gts->rep.ta;
+    write_pod(int8_t(POINT), out);
+    write_pod(int8_t(gts->rep.fx_policy), out);
+    write_pod(int8_t(ta.gt), out);
+    if (ta.gt == gta_t::FIXED) {
+        write_pod(int64_t(ta.f.t), out);
+        write_pod(int64_t(ta.f.dt), out);
+        write_pod(int64_t(ta.f.n), out);
+    } else {
+        static_assert(sizeof(core::utctime) == sizeof(int64_t), "compact wire format requires 64 bit utctime");
+        write_pod(int64_t(ta.p.t.size()), out);
+        out.write((const char*)ta.p.t.data(), ta.p.t.size()*sizeof(int64_t));
+        write_pod(int64_t(ta.p.t_end), out);
+    }
+    const auto& v = gts->rep.v;
+    write_pod(int64_t(v.size()), out);
+    out.write((const char*)v.data(), v.size()*sizeof(double));
+}
+
+template <class T>
+apoint_ts read_ts(T& in) {
+    auto kind = read_pod<int8_t>(in);
+    if (kind == NONE)
+        return apoint_ts();
+    if (kind == ARCHIVE) {
+        apoint_ts ats;
+        core::core_iarchive ia(in, core_arch_flags);
+        ia >> ats;
+        return ats;
+    }
+    if (kind != POINT)
+        throw std::runtime_error("compact wire format: unknown ts kind " + std::to_string(int(kind)));
+    auto fx = time_series::ts_point_fx(read_pod<int8_t>(in));
+    auto gt = read_pod<int8_t>(in);
+    gta_t ta;
+    if (gt == gta_t::FIXED) {
+        auto t = read_pod<int64_t>(in);
+        auto dt = read_pod<int64_t>(in);
+        auto n = read_size(in);
+        ta = gta_t(t, dt, n);
+    } else if (gt == gta_t::POINT) {
+        ta.gt = gta_t::POINT;
+        read_block(in, ta.p.t, read_size(in));
+        ta.p.t_end = read_pod<int64_t>(in);
+    } else {
+        throw std::runtime_error("compact wire format: unknown time-axis type " + std::to_string(int(gt)));
+    }
+    auto n = read_size(in);
+    if (n != ta.size())
+        throw std::runtime_error("compact wire format: time-axis size is different from value-size");
+    std::vector<double> v;
+    read_block(in, v, n);
+    return apoint_ts(std::make_shared<gpoint_ts>(gts_t(std::move(ta), std::move(v), fx)));
+}
+
+template <class T>
+void write_ts_vector(const ats_vector& tsv, T& out) {
+    write_pod(version, out);
+    write_pod(int64_t(tsv.size()), out);
+    for (const auto& ats : tsv)
+        write_ts(ats, out);
+}
+
+template <class T>
+ats_vector read_ts_vector(T& in) {
+    auto v = read_pod<int32_t>(in);
+    if (v < 1 || v > version)
+        throw std::runtime_error("compact wire format: unsupported version " + std::to_string(v));
+    ats_vector r;
+    auto n = read_size(in);
+    r.reserve(std::min(n, size_t(1024)));// n is not trusted until the ts are read
+    for (size_t i = 0; i < n; ++i)
+        r.push_back(read_ts(in));
+    return r;
+}
+
+/** write tsv in the wire_format negotiated for the connection, 0 means boost archive */
+template <class T>
+void write_reply(const ats_vector& tsv, int32_t wire_format, T& out) {
+    if (wire_format > 0) {
+        write_ts_vector(tsv, out);
+    } else {
+        core::core_oarchive oa(out, core_arch_flags);
+        oa << tsv;
+    }
+}
+
+/** read tsv in the wire_format negotiated for the connection, 0 means boost archive */
+template <class T>
+ats_vector read_reply(int32_t wire_format, T& in) {
+    if (wire_format > 0)
+        return read_ts_vector(in);
+    ats_vector r;
+    core::core_iarchive ia(in, core_arch_flags);
+    ia >> r;
+    return r;
+}
+
+}
+}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "time_series.h"
+#include "cell_model.h"
+
+namespace shyft {
+    namespace core {
+
+        /** \brief a point time-series keeping its values in single precision
+         *
+         * Provides the point_ts interface used by the cells, interpolation and method stacks,
+         * with values stored as float, and converted to/from double on access,
+         * so that computations are done in double, while the memory and bandwidth
+         * needed for the cell env. and response series is halved.
+         *
+         * \tparam TA time-axis, like time_axis::fixed_dt
+         * \sa environment_float_t
+         */
+        template <class TA>
+        struct float_ts {
+            typedef TA ta_t;
+            TA ta;
+            std::vector<float> v;
+            ts_point_fx fx_policy = POINT_INSTANT_VALUE;
+
+            float_ts() = default;
+            float_ts(const TA& ta, double fill_value, ts_point_fx fx_policy = POINT_INSTANT_VALUE)
+              : ta(ta), v(ta.size(), float(fill_value)), fx_policy(fx_policy) {}
+            float_ts(const TA& ta, const std::vector<double>& vv, ts_point_fx fx_policy = POINT_INSTANT_VALUE)
+              : ta(ta), v(begin(vv), end(vv)), fx_policy(fx_policy) {
+                if (ta.size() != v.size())
+                    throw std::runtime_error("float_ts: time-axis and values must have equal size");
+            }
+            explicit float_ts(const point_ts<TA>& o) : ta(o.ta), v(begin(o.v), end(o.v)), fx_policy(o.fx_policy) {}
+
+            bool operator==(const float_ts& o) const { return ta == o.ta && fx_policy == o.fx_policy && v == o.v; }
+            ts_point_fx point_interpretation() const { return fx_policy; }
+            void set_point_interpretation(ts_point_fx point_interpretation) { fx_policy = point_interpretation; }
+            const TA& time_axis() const { return ta; }
+
+            /**\brief the function value f(t) at time t, fx_policy taken into account, as point_ts */
+            double operator()(utctime t) const {
+                size_t i = ta.index_of(t);
+                if (i == string::npos) return nan;
+                if (fx_policy == ts_point_fx::POINT_INSTANT_VALUE && i + 1 < ta.size() && isfinite(v[i + 1])) {
+                    utctime t1 = ta.time(i);
+                    utctime t2 = ta.time(i + 1);
+                    double f = double(t2 - t)/double(t2 - t1);
+                    return v[i]*f + (1.0 - f)*v[i + 1];
+                }
+                return v[i];
+            }
+            double value(size_t i) const { return v[i]; }
+            vector<double> values() const { return vector<double>(begin(v), end(v)); }
+            size_t size() const { return ta.size(); }
+            size_t index_of(utctime t) const { return ta.index_of(t); }
+            utcperiod total_period() const { return ta.total_period(); }
+            utctime time(size_t i) const { return ta.time(i); }
+            point get(size_t i) const { return point(ta.time(i), value(i)); }
+            point_ts<TA> as_point_ts() const { return point_ts<TA>(ta, values(), fx_policy); }
+            operator point_ts<TA>() const { return as_point_ts(); }///< so that statistics, routing and collectors accepting point_ts works
+
+            void set(size_t i, double x) { v[i] = float(x); }
+            void add(size_t i, double value) { v[i] = float(v[i] + value); }
+            void fill(double value) { std::fill(begin(v), end(v), float(value)); }
+            void fill_range(double value, int start_step, int n_steps) { if (n_steps == 0) fill(value); else std::fill(begin(v) + start_step, begin(v) + start_step + n_steps, float(value)); }
+            void scale_by(double value) { std::for_each(begin(v), end(v), [value](float& x) { x = float(x*value); }); }
+        };
+
+        typedef float_ts<time_axis::fixed_dt> fpts_t;
+
+        ///< environment variant with all series in single precision, for large regions, \ref float_ts
+        typedef environment<timeaxis_t, fpts_t, fpts_t, fpts_t, fpts_t, fpts_t> environment_float_t;
+
+        /** as ts_init for pts_t, initialize a float_ts prior to a run */
+        inline void ts_init(fpts_t& ts, time_axis::fixed_dt const& ta, int start_step, int n_steps, ts_point_fx fx_policy) {
+            double const fill_value = shyft::nan;
+            if (ts.ta != ta || ta.size() == 0) {
+                ts = fpts_t(ta, fill_value, fx_policy);
+            } else {
+                ts.fill_range(fill_value, start_step, n_steps);
+            }
+        }
+    }
+
+    namespace time_series {
+        /** \brief Specialization of direct_accessor for float_ts, as for point_ts, no time-axis check */
+        template <class TA>
+        class direct_accessor<core::float_ts<TA>, TA> {
+          private:
+            const core::float_ts<TA>& source;
+          public:
+            direct_accessor(const core::float_ts<TA>& source, const TA& ta) : source(source) {}
+            double value(const size_t i) const { return source.value(i); }
+            size_t size() const { return source.size(); }
+        };
+    }
+}
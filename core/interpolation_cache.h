@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "geo_point.h"
+#include "inverse_distance.h"
+#include "bayesian_kriging.h"
+
+namespace shyft {
+    namespace core {
+
+        /** \brief geometry_key identifies the geometry dependent part of an interpolation
+         *
+         * That is the locations of the sources and destinations, and the parameters that
+         * the weights or operators depends on. Two keys are equal if all locations and parameters
+         * are exactly equal.
+         * The destinations are shared, since they are usually the same for all the variables of a region_model.
+         */
+        struct geometry_key {
+            std::vector<geo_point> sources;
+            std::shared_ptr<const std::vector<geo_point>> destinations;
+            std::vector<double> parameters;
+
+            bool operator==(const geometry_key& o) const {
+                return equal_points(sources, o.sources) && parameters == o.parameters
+                    && destinations && o.destinations
+                    && (destinations == o.destinations || equal_points(*destinations, *o.destinations));
+            }
+            bool operator!=(const geometry_key& o) const { return !operator==(o); }
+
+            /** \return the mid_point of the sources [b..e> */
+            template <class It>
+            static std::vector<geo_point> points(It b, It e) {
+                std::vector<geo_point> r;
+                for (; b != e; ++b)
+                    r.emplace_back(b->mid_point());
+                return r;
+            }
+
+          private:
+            static bool equal_points(const std::vector<geo_point>& a, const std::vector<geo_point>& b) {
+                return a.size() == b.size() && std::equal(begin(a), end(a), begin(b),
+                    [](const geo_point& p, const geo_point& q) { return p.x == q.x && p.y == q.y && p.z == q.z; });
+            }
+        };
+
+        /** \brief keeps one value, computed by a build function, as long as the geometry_key is unchanged
+         * \tparam T the type of the kept value, like inverse_distance::idw_weights
+         */
+        template <class T>
+        struct geometry_cached {
+            geometry_key key;
+            std::shared_ptr<const T> value;
+
+            /** \return the kept value if the key is equal, otherwise the result of build(), that is kept with the key */
+            template <class F>
+            std::shared_ptr<const T> get(geometry_key&& k, F&& build) {
+                if (value && key == k)
+                    return value;
+                value = std::make_shared<const T>(build());
+                key = std::move(k);
+                return value;
+            }
+            void clear() {
+                value.reset();
+                key = geometry_key();
+            }
+        };
+
+        /** \brief interpolation_cache keeps the source/destination weights and operators of the region_model interpolation
+         *
+         * So that repeated interpolation, like in calibration or ensemble runs with the same stations and cells,
+         * only does the data dependent work. Each variable is kept separately, so that it's computed
+         * when the locations of the cells, the sources, or the parameter of that variable changes.
+         * The kept values are immutable, so a copy of the cache, e.g. in a cloned region_model, shares them.
+         * \sa region_model::interpolate
+         */
+        struct interpolation_cache {
+            geometry_cached<inverse_distance::idw_weights> temperature_idw;
+            geometry_cached<bayesian_kriging::btk_operators> temperature_btk;
+            geometry_cached<inverse_distance::idw_weights> precipitation;
+            geometry_cached<inverse_distance::idw_weights> radiation;
+            geometry_cached<inverse_distance::idw_weights> wind_speed;
+            geometry_cached<inverse_distance::idw_weights> rel_hum;
+
+            void clear() {
+                temperature_idw.clear();
+                temperature_btk.clear();
+                precipitation.clear();
+                radiation.clear();
+                wind_speed.clear();
+                rel_hum.clear();
+            }
+
+            /** the parameters that the idw_weights depends on */
+            static std::vector<double> idw_key(const inverse_distance::parameter& p) {
+                return std::vector<double>{double(p.max_members), p.max_distance, p.distance_measure_factor, p.zscale};
+            }
+
+            /** the parameters that the btk_operators depends on */
+            template <class P>
+            static std::vector<double> btk_key(const P& p) {
+                return std::vector<double>{p.sill(), p.nug(), p.range(), p.zscale(), p.temperature_gradient_sd()};
+            }
+        };
+    }
+}
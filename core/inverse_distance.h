@@ -72,6 +72,157 @@ namespace shyft {
 			};
 
 
+			/** \brief source_grid is a spatial index of the source locations, using buckets in the x,y plane
+			 *
+			 * Used to find the candidate neighbours of a destination, without scanning all the sources.
+			 * The bucket size is the search radius, unless that gives too many buckets compared to the number of sources.
+			 * \tparam G geo_point type, with .x and .y
+			 */
+			template <class G>
+			struct source_grid {
+				/** \param source_begin,source_end iterators to sources with .mid_point()
+				 * \param radius the search radius, if not finite, all sources are candidates for all destinations
+				 */
+				template <class S>
+				source_grid(S source_begin, S source_end, double radius) : n(distance(source_begin, source_end)), r(radius) {
+					if (n == 0 || !isfinite(r) || r <= 0.0)
+						return;
+					vector<G> p; p.reserve(n);
+					for (auto s = source_begin; s != source_end; ++s)
+						p.emplace_back(s->mid_point());
+					x0 = x1 = p[0].x; y0 = y1 = p[0].y;
+					for (const auto& q : p) {
+						x0 = std::min(x0, q.x); x1 = std::max(x1, q.x);
+						y0 = std::min(y0, q.y); y1 = std::max(y1, q.y);
+					}
+					c = r;
+					const double max_buckets = 4.0*n + 64.0;// keep memory linear in number of sources
+					while (((x1 - x0)/c + 1.0)*((y1 - y0)/c + 1.0) > max_buckets)
+						c *= 2.0;
+					nx = size_t((x1 - x0)/c) + 1;
+					ny = size_t((y1 - y0)/c) + 1;
+					bucket_begin.assign(nx*ny + 1, 0);
+					vector<size_t> b(n);
+					for (size_t i = 0; i < n; ++i) {
+						b[i] = bucket_of(p[i].x, p[i].y);
+						++bucket_begin[b[i] + 1];
+					}
+					for (size_t k = 0; k < nx*ny; ++k)
+						bucket_begin[k + 1] += bucket_begin[k];
+					ix.resize(n);
+					vector<size_t> pos(begin(bucket_begin), end(bucket_begin) - 1);
+					for (size_t i = 0; i < n; ++i)
+						ix[pos[b[i]]++] = i;
+				}
+
+				/** replace the content of candidates with the index of the sources in the buckets within radius in x and y from p, in source order */
+				void near(const G& p, vector<size_t>& candidates) const {
+					candidates.clear();
+					if (bucket_begin.empty()) {// no index, all are candidates
+						for (size_t i = 0; i < n; ++i)
+							candidates.push_back(i);
+						return;
+					}
+					if (p.x + r < x0 || p.x - r > x1 || p.y + r < y0 || p.y - r > y1)
+						return;
+					const size_t i0 = bucket_ix(p.x - r, x0, nx), i1 = bucket_ix(p.x + r, x0, nx);
+					const size_t j0 = bucket_ix(p.y - r, y0, ny), j1 = bucket_ix(p.y + r, y0, ny);
+					for (size_t j = j0; j <= j1; ++j)
+						for (size_t i = i0; i <= i1; ++i)
+							for (size_t k = bucket_begin[j*nx + i]; k < bucket_begin[j*nx + i + 1]; ++k)
+								candidates.push_back(ix[k]);
+					sort(begin(candidates), end(candidates));
+				}
+
+			private:
+				size_t n;///< number of sources
+				double r;///< search radius
+				double x0{0}, x1{0}, y0{0}, y1{0};///< bounding box of the sources
+				double c{0};///< bucket size
+				size_t nx{0}, ny{0};
+				vector<size_t> bucket_begin;///< sources of bucket k are ix[bucket_begin[k]..bucket_begin[k+1]>
+				vector<size_t> ix;
+				size_t bucket_ix(double v, double v0, size_t nv) const {
+					double k = std::floor((v - v0)/c);
+					return k <= 0.0 ? 0 : std::min(nv - 1, size_t(k));
+				}
+				size_t bucket_of(double x, double y) const { return bucket_ix(y, y0, ny)*nx + bucket_ix(x, x0, nx); }
+			};
+
+			/** \brief idw_weights keeps the neighbours and weights of each destination as a CSR sparse matrix
+			 *
+			 * Row j, the destination j, has entries [row[j]..row[j+1]>,
+			 * where col[e] is the index of the source, and w[e] its weight.
+			 */
+			struct idw_weights {
+				vector<size_t> row{0};
+				vector<size_t> col;
+				vector<double> w;
+				size_t size() const { return row.size() - 1; }
+			};
+
+			/** \brief build the idw_weights for the destinations, using the sources within reaching distance
+			 *
+			 * For each destination, the sources with weight over the weight of max_distance are used,
+			 * limited to the max_members with the largest weight.
+			 * The search for candidates is done using a source_grid, assuming that
+			 * the M::distance_measure increases with the horizontal distance, as for geo_point.
+			 * \sa run_interpolation for template parameters
+			 */
+			template<class M, class S, class D, class P>
+			idw_weights build_idw_weights(S source_begin, S source_end, D destination_begin, D destination_end, const P& parameter) {
+				typedef typename S::value_type source_t;
+				typedef typename source_t::geo_point_t geo_point_t;
+				struct source_weight {
+					source_weight(size_t source = 0, double weight = 0) : source(source), weight(weight) {}
+					size_t source;
+					double weight;
+				};
+
+				static const double max_weight = 1.0; // Used in place of inf for weights
+
+				const double min_weight = 1.0 / M::distance_measure(geo_point_t(0.0),
+					geo_point_t(parameter.max_distance),
+					parameter.distance_measure_factor, parameter.zscale);
+
+				vector<geo_point_t> source_point;
+				for (auto s = source_begin; s != source_end; ++s)
+					source_point.emplace_back(s->mid_point());
+				source_grid<geo_point_t> grid(source_begin, source_end, parameter.max_distance);
+
+				idw_weights r;
+				vector<size_t> candidates;
+				vector<source_weight> swl;
+				swl.reserve(source_point.size());
+				size_t max_entries = parameter.max_members;
+				for (auto destination = destination_begin; destination != destination_end; ++destination) {
+					auto destination_point = destination->mid_point();
+					swl.clear();
+					grid.near(destination_point, candidates);
+					// unsorted source weight list, in source order, only those near enough
+					for (auto i : candidates) {
+						double weight = std::min(max_weight, 1.0 / M::distance_measure(destination_point,
+							source_point[i], parameter.distance_measure_factor, parameter.zscale));
+						if (weight >= min_weight) // max distance value tranformed to minimum weight, so we only use those near enough
+							swl.emplace_back(i, weight);
+					}
+					// TODO: fix rare issue that if we get NaNs, and there are more sources in range than max_entries
+					//      then this approach using partial sort + truncate at max_entries, will not promote those truncated
+					//      even if they are in range.
+					if (swl.size() > max_entries) {
+						partial_sort(begin(swl), begin(swl) + max_entries, end(swl),
+							[](const source_weight& a, const source_weight &b) { return a.weight > b.weight; });
+						swl.resize(max_entries);
+					}
+					for (const auto& sw : swl) {
+						r.col.push_back(sw.source);
+						r.w.push_back(sw.weight);
+					}
+					r.row.push_back(r.col.size());
+				}
+				return r;
+			}
+
 			/** \brief Inverse Distance Weighted Interpolation
 			* The Inverse Distance Weighted algorithm.
 			*
@@ -131,6 +282,8 @@ namespace shyft {
 			*      Ref. to Model classes for more details.
 			*  -#  M::distance_measure, a static method that accepts three arguments; a,b of type of S|D.geo_point() and a measure parameter f, and returns the squared distance
 			*  -#  M::transform(sourcevalue, scalevalue, const S &source, const D& destination), --> source value transformed to destination level
+			*      if the scale_computer is not source based, the transform should be affine in the sourcevalue, a*sourcevalue + b,
+			*      because a and b are computed once for each source/destination pair.
 			*
 			* \sa BayesianKriging for more advanced interpolation
 			*
@@ -142,107 +295,126 @@ namespace shyft {
 				D destination_begin, D destination_end,
 				const T& timeAxis, const P& parameter,
 				F&& dest_set_value) // in short, a setter function for the result..
-				//std::function< void(typename D::value_type& ,size_t ,double ) > dest_set_value ) // in short, a setter function for the result..
 			{
-				typedef typename S::value_type const * source_pointer;
-				typedef typename S::value_type source_t;
-
-				struct source_weight {
-					source_weight(source_pointer source = nullptr, double weight = 0) : source(source), weight(weight) {}
-					source_pointer source;
-					double weight;
-					// Source::TsAccessor(S,TimeAxis) should go into this one..
-					// at least if we plan for parallel computing in this alg.
-				};
-
-				static const double max_weight = 1.0; // Used in place of inf for weights
-
-				const double min_weight = 1.0 / M::distance_measure(typename source_t::geo_point_t(0.0),
-					typename source_t::geo_point_t(parameter.max_distance),
-					parameter.distance_measure_factor, parameter.zscale);
+				// 1. create the idw_weights, that is; for each destination cell,
+				//     - the sources with weights that are within reaching distance
+				auto iw = build_idw_weights<M>(source_begin, source_end, destination_begin, destination_end, parameter);
+				run_interpolation<M>(source_begin, source_end, destination_begin, destination_end, timeAxis, parameter, iw, 0, dest_set_value);
+			}
 
-				const size_t source_count = distance(source_begin, source_end);
+			/** \brief run_interpolation as above, using precomputed idw_weights
+			*
+			* \param weights as built by build_idw_weights for the same sources and parameter
+			* \param row0 the row of weights for the first destination, so that a range of destinations can be interpolated by each thread
+			*/
+			template<class M, class S, class D, class T, class P, class F>
+			void run_interpolation(S source_begin, S source_end,
+				D destination_begin, D destination_end,
+				const T& timeAxis, const P& parameter,
+				const idw_weights& weights, size_t row0,
+				F&& dest_set_value)
+			{
+				typedef typename S::value_type const * source_pointer;
 				const size_t destination_count = distance(destination_begin, destination_end);
+				if (row0 + destination_count > weights.size())
+					throw runtime_error("idw: the weights do not cover the destinations");
+
+				//    the rows of the destinations, and their columns referring to the position in used,
+				//    keeping only the sources used by any of the destinations
+				const size_t e0 = weights.row[row0];
+				vector<size_t> row(begin(weights.row) + row0, begin(weights.row) + row0 + destination_count + 1);
+				for (auto& r : row)
+					r -= e0;
+				vector<size_t> col(begin(weights.col) + e0, begin(weights.col) + e0 + row.back());
+				const double* w_e = weights.w.data() + e0;
+				const size_t source_count = distance(source_begin, source_end);
+				vector<size_t> used_ix(source_count, string::npos);
+				vector<source_pointer> used;
+				for (auto& c : col) {
+					if (c >= source_count)
+						throw runtime_error("idw: the weights refer to a missing source");
+					if (used_ix[c] == string::npos) {
+						used_ix[c] = used.size();
+						used.push_back(&*(source_begin + c));
+					}
+					c = used_ix[c];
+				}
 
-				typedef vector<source_weight> source_weight_list;
-				vector<source_weight_list> cell_neighbours;
-
-				cell_neighbours.reserve(destination_count);
-
-				// 1. create cell_ neighbors,
-				//    that is; for each destination cell,
-				//     - a list of sources with weights that are within reaching distance
-				source_weight_list swl;
-				swl.reserve(source_count);
-				size_t max_entries = parameter.max_members;
-				for (auto destination = destination_begin; destination != destination_end; ++destination) { // for each destination, create a unique SourceWeightList
-					auto destination_point = destination->mid_point();
-					swl.clear();
-					// First, just create unsorted SourceWeightList
-					for_each(source_begin, source_end, [&](const typename S::value_type& source) {
-						double weight = std::min(max_weight, 1.0 / M::distance_measure(destination_point,
-							source.mid_point(), parameter.distance_measure_factor, parameter.zscale));
-						if (weight >= min_weight) // max distance value tranformed to minimum weight, so we only use those near enough
-							swl.emplace_back(&source, weight);
-					});
-
-					// now source weight list,swl, contains only sources that can be used for this dest. cell.
-					// TODO: fix rare issue that if we get NaNs, and there are more sources in range than max_entries
-					//      then this approach using partial sort + truncate at max_entries, will not promote those truncated
-					//      even if they are in range.
-					if (swl.size() > max_entries) {   // drop sorting if less than needed elements.. (maybe thats already done in partial sort ?)
-						partial_sort(begin(swl), begin(swl) + max_entries, end(swl),
-							[](const source_weight& a, const source_weight &b) { return a.weight > b.weight; });  // partial sort the list (later: only if max_entries>usable_sources.size..)
-						swl.resize(max_entries); // get rid of left-overs
+				// 2. for models with a constant scale, M::transform(v) = a*v + b, computed once pr. entry
+				const bool source_based = M::scale_computer::is_source_based();
+				typename M::scale_computer gc(parameter);
+				vector<double> coef_a, coef_b;
+				if (!source_based) {
+					gc.clear();
+					const double scale = gc.compute();
+					coef_a.reserve(col.size()); coef_b.reserve(col.size());
+					for (size_t j = 0; j < destination_count; ++j) {
+						auto destination = destination_begin + j;
+						for (size_t e = row[j]; e < row[j + 1]; ++e) {
+							double b = M::transform(0.0, scale, *used[col[e]], *destination);
+							coef_b.push_back(b);
+							coef_a.push_back(M::transform(1.0, scale, *used[col[e]], *destination) - b);
+						}
 					}
-					cell_neighbours.emplace_back(swl);  // done with this destination source, n_dest x n_source allocs
 				}
 
 				//
-				// 2. for each destination, do the IDW
-				//     using cell_neighbors that keeps a list of reachable sources
-				//     Only use sources that provides a valid value using isfinite()
-				//    if the supplied Model::scale_computer (gradient..) require it, also
-				//    feed that model with valid source values to get a computed scale factor.
+				// 3. for each block of time-steps, gather the source values in a contiguous [source][step] array,
+				//    then for each destination, do the IDW as a sparse matrix x dense matrix product.
+				//    Only use sources that provides a valid value using isfinite(), the weights are
+				//    normalized pr. step with the sum of weights of the valid sources.
+				//    If the supplied Model::scale_computer (gradient..) is source based, it's
+				//    fed with the valid source values of each destination to compute the scale pr. step.
 				//
-				vector<double> destination_scale; destination_scale.reserve(destination_count);
-				bool first_time_scale_calc = true;
-				typename M::scale_computer gc(parameter);
-
-				for (size_t i = 0; i < timeAxis.size(); ++i) {
-					auto period_i = timeAxis(i);
-
-					// compute gradient, scale whatever, based on available sources..
-					if (M::scale_computer::is_source_based() || first_time_scale_calc) {
-						destination_scale.clear();
-						for (size_t j = 0; j < cell_neighbours.size(); ++j) {
-							const auto &cell_neighbor = cell_neighbours[j];
-							gc.clear();// reset the scale computer
-							for (const auto & sw : cell_neighbor) {
-								double source_value = sw.source->value(period_i);
-								if (isfinite(source_value)) // only use valid source values
-									gc.add(*(sw.source), period_i);
+				const size_t n_steps = timeAxis.size();
+				const size_t block = 64;
+				vector<double> values(used.size()*block);
+				vector<double> destination_scale(source_based ? destination_count*block : 0);
+				vector<double> sum_weight_value(block), sum_weights(block);
+				for (size_t t0 = 0; t0 < n_steps; t0 += block) {
+					const size_t nb = std::min(block, n_steps - t0);
+					for (size_t k = 0; k < nb; ++k) {
+						auto period_i = timeAxis(t0 + k);
+						for (size_t s = 0; s < used.size(); ++s)
+							values[s*block + k] = used[s]->value(period_i);
+						if (source_based) { // compute gradient, scale whatever, based on available sources..
+							for (size_t j = 0; j < destination_count; ++j) {
+								gc.clear();
+								for (size_t e = row[j]; e < row[j + 1]; ++e)
+									if (isfinite(values[col[e]*block + k])) // only use valid source values
+										gc.add(*used[col[e]], period_i);
+								destination_scale[j*block + k] = gc.compute();
 							}
-							destination_scale.emplace_back(gc.compute());//could pass (destination_begin +j)->mid_point(), so we know the dest position ?
-							first_time_scale_calc = false;// all models except temperature(due to gradient) are one time only,
 						}
 					}
-					//
-					// Now that we got the destination_computer in place, we can just iterate over
-					//
-					for (size_t j = 0; j < cell_neighbours.size(); ++j) {
-						double sum_weights = 0, sum_weight_value = 0;
-						auto &cell_neighbor = cell_neighbours[j];
+					for (size_t j = 0; j < destination_count; ++j) {
 						auto destination = destination_begin + j;
-						double computed_scale = destination_scale[j];
-						for (const auto& sw : cell_neighbor) {
-							double source_value = sw.source->value(period_i);
-							if (isfinite(source_value)) { // only use valid source values
-								sum_weight_value += sw.weight*M::transform(source_value, computed_scale, *(sw.source), *destination);
-								sum_weights += sw.weight;
+						std::fill(begin(sum_weight_value), begin(sum_weight_value) + nb, 0.0);
+						std::fill(begin(sum_weights), begin(sum_weights) + nb, 0.0);
+						for (size_t e = row[j]; e < row[j + 1]; ++e) {
+							const double* v = values.data() + col[e]*block;
+							const double w = w_e[e];
+							if (source_based) {
+								const double* scale = destination_scale.data() + j*block;
+								const auto& source = *used[col[e]];
+								for (size_t k = 0; k < nb; ++k) {
+									if (isfinite(v[k])) {
+										sum_weight_value[k] += w*M::transform(v[k], scale[k], source, *destination);
+										sum_weights[k] += w;
+									}
+								}
+							} else {
+								const double a = coef_a[e], b = coef_b[e];
+								for (size_t k = 0; k < nb; ++k) {
+									if (isfinite(v[k])) {
+										sum_weight_value[k] += w*(a*v[k] + b);
+										sum_weights[k] += w;
+									}
+								}
 							}
 						}
-						dest_set_value(*destination, period_i, sum_weight_value / sum_weights);
+						for (size_t k = 0; k < nb; ++k)
+							dest_set_value(*destination, timeAxis(t0 + k), sum_weight_value[k] / sum_weights[k]);
 					}
 				}
 			}
@@ -473,11 +645,17 @@ namespace shyft {
 			 */
 			template <class TA>
 			class idw_timeaxis {
+				size_t i0;
 				size_t n;
 			public:
-				explicit idw_timeaxis(TA time_axis) :n(time_axis.size()) {}
+				explicit idw_timeaxis(TA time_axis) :i0(0), n(time_axis.size()) {}
+				/** a window of the time_axis, covering steps [start_step..start_step+n_steps> */
+				idw_timeaxis(TA time_axis, size_t start_step, size_t n_steps) :i0(start_step), n(n_steps) {
+					if (start_step + n_steps > time_axis.size())
+						throw std::runtime_error("idw: step range outside time-axis");
+				}
 				size_t size() const { return n; }
-				size_t operator()(const size_t i) const { return i; }
+				size_t operator()(const size_t i) const { return i0 + i; }
 			};
 
 			/** \brief run interpolation step, for a given IDW model, sources and parameters.
@@ -495,13 +673,26 @@ namespace shyft {
 			*/
 			template<typename IDWModel, typename IDWModelSource, typename ApiSource, typename P, typename D, typename ResultSetter, typename TimeAxis>
 			void run_interpolation(const TimeAxis &ta, ApiSource const & api_sources, const P& parameters, D &cells, ResultSetter&& result_setter,int ncore=-1) {
+				run_interpolation<IDWModel, IDWModelSource>(ta, 0, ta.size(), api_sources, parameters, cells, result_setter, ncore);
+			}
+
+			/** \brief run interpolation step, as above, but only for the time-steps [start_step..start_step+n_steps> of ta
+			*
+			* The result_setter is called with the index of the time-step in ta, so that the values of the other time-steps
+			* of the destinations are left untouched. The source/destination weights are computed once pr. call,
+			* unless supplied, so the cost of a call is proportional to n_steps, not ta.size().
+			*
+			* \param weights if not null, the weights as built by build_idw_weights for the api_sources and cells
+			*/
+			template<typename IDWModel, typename IDWModelSource, typename ApiSource, typename P, typename D, typename ResultSetter, typename TimeAxis>
+			void run_interpolation(const TimeAxis &ta, size_t start_step, size_t n_steps, ApiSource const & api_sources, const P& parameters, D &cells, ResultSetter&& result_setter,int ncore=-1, const idw_weights* weights=nullptr) {
 				using namespace std;
 				/// 1. make a vector of ts-accessors for the sources. Notice that this vector needs to be modified, since the accessor 'remembers'
 				///    the last position. It is essential for performance, -but again-, then each thread needs it's own copy of the sources.
 				///    Since the accessors just have a const *reference* to the underlying TS; there is no memory involved, so copy is no problem.
 
 
-				idw_timeaxis<TimeAxis> idw_ta(ta);
+				idw_timeaxis<TimeAxis> idw_ta(ta, start_step, n_steps);
 				///    - and figure out a suitable ncore number. Using single cpu 4..8 core shows we can have more threads than cores, and gain speed.
                 if (ncore < 0) {
                     ncore = (int) thread::hardware_concurrency();//in case of not available, default to 4,
@@ -511,7 +702,10 @@ namespace shyft {
                 if (ncore < 2) {
                     vector<IDWModelSource> src; src.reserve(api_sources.size());
                     for (auto& s : api_sources) src.emplace_back(s, ta);
-                    run_interpolation<IDWModel>(begin(src), end(src), begin(cells), end(cells), idw_ta, parameters, result_setter);
+                    if (weights)
+                        run_interpolation<IDWModel>(begin(src), end(src), begin(cells), end(cells), idw_ta, parameters, *weights, 0, result_setter);
+                    else
+                        run_interpolation<IDWModel>(begin(src), end(src), begin(cells), end(cells), idw_ta, parameters, result_setter);
                 } else {
                     /// 2. Create a set of futures, for the threads that we want to run
                     vector<future<void>> calcs;
@@ -524,8 +718,11 @@ namespace shyft {
                         vector<IDWModelSource> src; src.reserve(api_sources.size());// need one source set pr. thread, since src accessors is not threadsafe
                         for (auto& s : api_sources) src.emplace_back(s, ta);
                         calcs.emplace_back( /// spawn a thread to run IDW on this part of the cells, using *all* sources (later we could speculate in sources needed)
-                            async(launch::async, [src, cells_iterator, &idw_ta, &parameters, &result_setter, n]() { /// capture src by value, we *want* a copy of that..
-                            run_interpolation<IDWModel>(begin(src), end(src), cells_iterator, cells_iterator + n, idw_ta, parameters, result_setter);
+                            async(launch::async, [src, cells_iterator, &idw_ta, &parameters, &result_setter, n, weights, i]() { /// capture src by value, we *want* a copy of that..
+                            if (weights)
+                                run_interpolation<IDWModel>(begin(src), end(src), cells_iterator, cells_iterator + n, idw_ta, parameters, *weights, i, result_setter);
+                            else
+                                run_interpolation<IDWModel>(begin(src), end(src), cells_iterator, cells_iterator + n, idw_ta, parameters, result_setter);
                         })
                         );
                         cells_iterator = cells_iterator + n;
@@ -535,6 +732,18 @@ namespace shyft {
                     for (auto&f : calcs) f.get();
                 }
 			}
+
+			/** \brief build the idw_weights for the api_sources and cells, as used by run_interpolation
+			*
+			* The weights depend only on the locations and the parameters, so they can be kept and reused
+			* for other series from the same locations, \ref interpolation_cache.
+			*/
+			template<typename IDWModel, typename IDWModelSource, typename ApiSource, typename P, typename D, typename TimeAxis>
+			idw_weights build_idw_weights(const TimeAxis &ta, ApiSource const & api_sources, const P& parameters, D &cells) {
+				vector<IDWModelSource> src; src.reserve(api_sources.size());
+				for (auto& s : api_sources) src.emplace_back(s, ta);
+				return build_idw_weights<IDWModel>(begin(src), end(src), begin(cells), end(cells), parameters);
+			}
 		} // namespace  inverse_distance
 	} // Namespace core
 } // Namespace shyft
@@ -6,6 +6,8 @@
 #include <cmath>
 #include <limits>
 #include <future>
+#include <mutex>
+#include <condition_variable>
 #include <utility>
 #include <memory>
 #include <stdexcept>
@@ -68,6 +70,12 @@ namespace shyft {
                 x = model.from_scaled(_x);
                 return res;
             }
+            ///< the number of concurrent evaluations m(x) supports, m.concurrency() if M provides it, otherwise 1
+            template<class M>
+            auto model_concurrency(const M& m, int) -> decltype(m.concurrency()) { return m.concurrency(); }
+            template<class M>
+            size_t model_concurrency(const M&, long) { return 1; }
+
             ///<Template class to transform model evaluation into something that dream can run
             template<class M>
             struct dream_fx : public shyft::core::optimizer::ifx {
@@ -76,6 +84,7 @@ namespace shyft {
                 double evaluate(const vector<double> &x) {
                     return -m(x); // notice that dream find maximumvalue, so we need to negate the goal function, effectively finding the minimum value.
                 }
+                size_t concurrency() const { return model_concurrency(m, 0); }
             };
 
             /** \brief template function that find the x that minimizes the evaluated value of model M using DREAM algorithm
@@ -105,6 +114,7 @@ namespace shyft {
                 double evaluate(const vector<double> &x) {
                     return m(x);
                 }
+                size_t concurrency() const { return model_concurrency(m, 0); }
             };
 
             /** \brief template for the function that finds the x that minimizes the evaluated value of model M using SCEUA algorithm
@@ -379,6 +389,56 @@ namespace shyft {
                 vector<double> p_max;
                 int print_progress_level;
                 size_t n_catchments=0;///< optimized counted number of model.catchments available
+                size_t n_concurrent_evaluations=1;///< if > 1, optimize_sceua and optimize_dream evaluates this number of candidates concurrently
+                int n_run_steps=0;///< the steps from the start of the model time-axis to the end of the last target, 0 means all steps
+
+                /** keeps the calculation filter of the model, and restores it, and the step range, when the optimization is done, or interrupted */
+                struct optimization_scope {
+                    optimizer& o;
+                    vector<int> catchment_filter;///< the calculation filter of the model prior to the optimization
+                    vector<int> river_filter;
+                    explicit optimization_scope(optimizer& o)
+                        : o(o), catchment_filter(o.model.get_catchment_calculation_filter()), river_filter(o.model.get_river_calculation_filter()) {}
+                    ~optimization_scope() {
+                        o.evaluators.reset();
+                        o.n_run_steps = 0;
+                        try {
+                            o.model.set_calculation_filter(catchment_filter, river_filter);
+                        } catch (...) {// the catchments or rivers are changed meanwhile, so clear it, a destructor must not throw
+                            o.model.set_catchment_calculation_filter(vector<int>{});
+                        }
+                    }
+                };
+
+                /** \brief the clones of the model used for concurrent evaluations, one evaluation at a time pr. clone
+                 *
+                 * Each clone has its own optimizer, with the targets and parameter ranges of the owner.
+                 * Kept by a shared_ptr, so that the owner is still copyable.
+                 */
+                struct evaluation_pool {
+                    vector<unique_ptr<region_model_t>> models;
+                    vector<unique_ptr<optimizer>> optimizers;///< one pr. model
+                    vector<size_t> idle;///< the optimizers that are not in use
+                    std::mutex mx;
+                    std::condition_variable cv;
+                    std::mutex trace_mx;///< protects the parameters_trace and goal_fn_trace of the owner
+
+                    size_t acquire() {
+                        std::unique_lock<std::mutex> lock(mx);
+                        cv.wait(lock, [this]() { return !idle.empty(); });
+                        size_t i = idle.back();
+                        idle.pop_back();
+                        return i;
+                    }
+                    void release(size_t i) {
+                        {
+                            std::lock_guard<std::mutex> lock(mx);
+                            idle.push_back(i);
+                        }
+                        cv.notify_one();
+                    }
+                };
+                std::shared_ptr<evaluation_pool> evaluators;///< established by optimize_sceua/dream if n_concurrent_evaluations > 1
                 //Need to handle expanded/reduced parameter vector based on min..max range to optimize speed for bobyqa
                 const double activate_limit = 0.000001;
                 bool is_active_parameter(size_t i) const { return fabs(p_max[i] - p_min[i]) > activate_limit; }
@@ -460,9 +520,13 @@ namespace shyft {
                  * Ensures :
                  *  -# the model have a global parameter-set
                  *  -# the collection of SCA/SWE is turned on if requested
-                 *  -# the catchment-filter is set according to target-specification request
+                 *  -# the calculation filter is set to the catchments and rivers of the targets, and the rivers upstream,
+                 *     so that only rivers of ROUTED_DISCHARGE targets are routed by the runs
+                 *  -# the model is run from the start of the time-axis (spin-up) to the end of the last target
+                 * The filter of the model is kept, and restored, by the optimization_scope that must enclose this call.
                  */
                 void prepare_optimize() {
+                    evaluators.reset();// any leftover from an interrupted optimize_sceua/dream
                     // 1. ensure vectors reflects current state of lower..upper bounds
                     p_min = p_vector(parameter_lower_bound);
                     p_max = p_vector(parameter_upper_bound);
@@ -471,6 +535,7 @@ namespace shyft {
                     // 3. figure out the catchment indexes to evaluate..
                     //    and if we need to turn on snow collection
                     vector<int> catchment_indexes;
+                    vector<int> river_ids;
 
                     model.set_snow_sca_swe_collection(-1, false);//turn off all snow by default.
                     for (const auto&t : targets) {
@@ -479,6 +544,7 @@ namespace shyft {
                             for (auto cid : t.catchment_indexes)
                                 model.set_snow_sca_swe_collection(cid, true);//turn on for those with something like snow enabled
                         if (t.catchment_property == ROUTED_DISCHARGE) {
+                            river_ids.push_back(t.river_id);
                             auto river_cids = model.get_catchment_feeding_to_river(t.river_id);
                             for (auto rc : river_cids)catchment_indexes.push_back(rc);
                         }
@@ -492,12 +558,34 @@ namespace shyft {
                         if (model.has_catchment_parameter(i))
                             throw runtime_error("Cannot calibrate on local parameters.");
                     }
-                    model.set_catchment_calculation_filter(catchment_indexes); //Only calculate the catchments that we optimize
+                    if (river_ids.size() > 1) {
+                        sort(begin(river_ids), end(river_ids));
+                        river_ids.erase(unique(begin(river_ids), end(river_ids)), end(river_ids));
+                    }
+                    model.set_calculation_filter(catchment_indexes, river_ids); //Only calculate the catchments and route the rivers that we optimize
+                    n_run_steps = compute_run_steps();
                     // 4. detects if initial state is established, if not it automatically do a copy of the current state
                     auto_initial_state_check();
                     parameters_trace.clear();// wipe out parameters_trace
                     goal_fn_trace.clear();// and the corresponding goal_fn values
                 }
+                /** \return the number of steps from the start of the model time-axis to the end of the last target,
+                 * or 0, meaning all steps, if a target ends beyond the time-axis, or there are no targets
+                 */
+                int compute_run_steps() const {
+                    const auto& ta = model.time_axis;
+                    size_t n = 0;
+                    for (const auto& t : targets) {
+                        auto tp = t.ts.total_period();
+                        if (tp.end > ta.total_period().end)
+                            return 0;
+                        size_t i = ta.index_of(tp.end - utctime(1));
+                        if (i == std::string::npos)
+                            continue;// ends before the time-axis, nothing to compare with
+                        n = std::max(n, i + 1);
+                    }
+                    return n < ta.size() ? int(n) : 0;
+                }
                 void auto_initial_state_check() {
                     if (model.initial_state.size() != model.get_cells()->size()) {
                         if (print_progress_level > 0)
@@ -522,16 +610,19 @@ namespace shyft {
                  * \param max_n_evaluations stop after n calls of the objective functions, i.e. simulations.
                  * \param tr_start is the trust region start , default 0.1, ref bobyqa
                  * \param tr_stop is the trust region stop, default 1e-5, ref bobyqa
-                 * \return the optimized parameter vector
+                 * \return the optimized parameter vector, that is also set on the model, and run over the whole time-axis, \ref run_with
                  */
                 vector<double> optimize(const vector<double>& p, size_t max_n_evaluations = 1500, double tr_start = 0.1, double tr_stop = 1.0e-5) {
+                    optimization_scope scope(*this);
                     prepare_optimize();
                     // reduce using min..max the parameter space,
                     p_expanded = p;//put all parameters into class scope so that we can reduce/expand as needed during optimization
                     auto rp = reduce_p_vector(p);
                     min_bobyqa(*this, rp, max_n_evaluations, tr_start, tr_stop);
                     // expand,put inplace p to return vector.
-                    return  expand_p_vector(rp);
+                    auto r = expand_p_vector(rp);
+                    run_with(r);
+                    return r;
                 }
 
                 /**optimize using minbobyqa, using p as starting parameters, return new optimized parameters */
@@ -547,15 +638,19 @@ namespace shyft {
                  * down to a minimum number to facilitate fast run.
                  * \param p is used as start point (not really, DREAM use random, but we should be able to pass u and q....
                  * \param max_n_evaluations stop after n calls of the objective functions, i.e. simulations.
-                 * \return the optimized parameter vector
+                 * \return the optimized parameter vector, that is also set on the model, and run over the whole time-axis, \ref run_with
                  */
                 vector<double> optimize_dream(const vector<double>& p, size_t max_n_evaluations = 1500) {
+                    optimization_scope scope(*this);
                     prepare_optimize();
                     // reduce using min..max the parameter space,
                     p_expanded = p;//put all parameters into class scope so that we can reduce/expand as needed during optimization
                     auto rp = reduce_p_vector(p);
+                    make_evaluators();
                     min_dream<optimizer>(*this, rp, max_n_evaluations);
-                    return expand_p_vector(rp);// expand,put inplace p to return vector.
+                    auto r = expand_p_vector(rp);// expand,put inplace p to return vector.
+                    run_with(r);
+                    return r;
                 }
                 /** optimize using the dream algorithm, returning the new optimized parameter set*/
                 PA optimize_dream(const PA &p, size_t max_n_evaluations = 1500) {
@@ -572,15 +667,19 @@ namespace shyft {
                  * \param max_n_evaluations stop after n calls of the objective functions, i.e. simulations.
                  * \param x_eps is stop condition when all changes in x's are within this range
                  * \param y_eps is stop condition, and search is stopped when goal function does not improve anymore within this range
-                 * \return the optimized parameter vector
+                 * \return the optimized parameter vector, that is also set on the model, and run over the whole time-axis, \ref run_with
                  */
                 vector<double> optimize_sceua(const vector<double>& p, size_t max_n_evaluations = 1500, double x_eps = 0.0001, double y_eps = 1.0e-5) {
+                    optimization_scope scope(*this);
                     prepare_optimize();
                     // reduce using min..max the parameter space,
                     p_expanded = p;//put all parameters into class scope so that we can reduce/expand as needed during optimization
                     auto rp = reduce_p_vector(p);
+                    make_evaluators();
                     min_sceua(*this, rp, max_n_evaluations, x_eps, y_eps);
-                    return expand_p_vector(rp);				// expand,put inplace p to return vector.
+                    auto r = expand_p_vector(rp);				// expand,put inplace p to return vector.
+                    run_with(r);
+                    return r;
                 }
 
                 /** optimize using the dream algorithm, returning the new optimized parameter set*/
@@ -594,6 +693,19 @@ namespace shyft {
                 void reset_states() {
                     model.revert_to_initial_state();
                 }
+
+                /** \brief run the model with parameters p over the whole time-axis
+                 *
+                 * Done at the end of an optimization, so that the parameters and the results of the
+                 * calculated catchments and rivers are those of p, not of the last candidate tried,
+                 * that is run only to the end of the last target.
+                 */
+                void run_with(const vector<double>& p) {
+                    parameter_accessor.set(p);
+                    reset_states();
+                    model.run_cells();
+                }
+
                 /**\brief set the parameter ranges, set min=max=wanted parameter value for those not subject to change during optimization */
                 void set_parameter_ranges(const vector<double>& p_min, const vector<double>& p_max) {
                     parameter_lower_bound = vector_p(p_min);
@@ -601,6 +713,19 @@ namespace shyft {
                 }
 
                 void set_verbose_level(int level) { print_progress_level = level; }
+
+                /**\brief set the number of candidates that optimize_sceua and optimize_dream evaluates concurrently
+                 *
+                 * If n > 1, the optimization is done on n clones of the model, each evaluating one candidate at a time,
+                 * with the cells of each clone run by one thread. The model itself is then not run during the optimization.
+                 * So n should be about the number of cores, and the memory needed is n times the model.
+                 * The default, 1, evaluates on the model, with the cells run by model.ncore threads.
+                 */
+                void set_concurrent_evaluations(size_t n) { n_concurrent_evaluations = n > 0 ? n : 1; }
+                size_t get_concurrent_evaluations() const { return n_concurrent_evaluations; }
+
+                /** the number of concurrent calls to operator()(vector) supported, used by the sceua and dream adapters */
+                size_t concurrency() const { return evaluators ? evaluators->optimizers.size() : 1; }
                 /**\brief calculate the goal_function as used by minbobyqa,
                  *   using the full set of  parameters vectors (as passed to optimize())
                  *   and also ensures that the shyft state/cell/catchment result is consistent
@@ -621,7 +746,7 @@ namespace shyft {
                 friend class calibration_test;// to enable testing of individual methods
                 /** called by bobyqua: */
                 double operator() (const column_vector& p_s) { return run(from_scaled(p_s)); }
-                double operator() (const vector<double>&p_s) { return run(from_scaled(p_s)); }
+                double operator() (const vector<double>&p_s) { return evaluators ? run_concurrent(from_scaled(p_s)) : run(from_scaled(p_s)); }
 
                 /** called by bobyqua:reduced parameter space p */
                 vector<double> to_scaled(const vector<double>& rp) const {
@@ -748,10 +873,74 @@ namespace shyft {
                 *  E.g. we can specify targets that apply to specific catchments, and specified periods/resolutions.
                 */
                 double run(const vector<double>& rp) {
+                    double goal_function_value = goal_function(rp);
+                    add_trace(parameter_accessor, goal_function_value);
+                    return goal_function_value;
+                }
+
+                /** as run, but evaluated on one of the idle evaluators, so it can be called concurrently */
+                double run_concurrent(const vector<double>& rp) {
+                    auto ep = evaluators;
+                    size_t i = ep->acquire();
+                    double goal_function_value;
+                    try {
+                        goal_function_value = ep->optimizers[i]->goal_function(rp);
+                    } catch (...) {
+                        ep->release(i);
+                        throw;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(ep->trace_mx);
+                        add_trace(ep->optimizers[i]->parameter_accessor, goal_function_value);
+                    }
+                    ep->release(i);
+                    return goal_function_value;
+                }
+
+                /** establish n_concurrent_evaluations clones of the model, with the current state, filter and parameters, if more than 1 */
+                void make_evaluators() {
+                    evaluators.reset();
+                    if (n_concurrent_evaluations < 2)
+                        return;
+                    auto ep = std::make_shared<evaluation_pool>();
+                    for (size_t i = 0; i < n_concurrent_evaluations; ++i) {
+                        ep->models.emplace_back(new region_model_t(model));// region_model::clone
+                        ep->models.back()->ncore = 1;// the concurrency is over the candidates, not the cells
+                        ep->optimizers.emplace_back(new optimizer(*ep->models.back()));
+                        auto& o = *ep->optimizers.back();
+                        o.targets = targets;
+                        o.parameter_lower_bound = parameter_lower_bound;
+                        o.parameter_upper_bound = parameter_upper_bound;
+                        o.p_expanded = p_expanded;
+                        o.p_min = p_min;
+                        o.p_max = p_max;
+                        o.n_catchments = n_catchments;
+                        o.n_run_steps = n_run_steps;
+                        o.print_progress_level = print_progress_level;
+                        ep->idle.push_back(i);
+                    }
+                    evaluators = ep;
+                }
+
+                void add_trace(const PA& p, double goal_function_value) {
+                    parameters_trace.push_back(p);// save to the parameters_trace
+                    goal_fn_trace.push_back(goal_function_value);//
+                    if (print_progress_level > 0) {
+                        cout << goal_function_value <<" : ParameterVector(";
+                        for (size_t i = 0; i < p.size(); ++i) {
+                            cout << p.get(i);
+                            if (i < p.size() - 1) cout << ", ";
+                        }
+                        cout << ")" << endl;
+                    }
+                }
+
+                /** the goal function for the reduced parameter vector rp, with the model run accordingly */
+                double goal_function(const vector<double>& rp) {
                     auto p = expand_p_vector(rp);// expand to full vector, then:
                     parameter_accessor.set(p); // Sets global parameters, all cells share a common pointer.
                     reset_states();
-                    model.run_cells();
+                    model.run_cells(0, 0, n_run_steps);
                     double goal_function_value = 0.0;// overall goal-function, intially zero
                     double scale_factor_sum = 0.0; // each target-spec have a weight, -use this to sum up weights
                     vector<pts_t> catchment_d;
@@ -805,16 +994,6 @@ namespace shyft {
                         }
                     }
                     goal_function_value /= scale_factor_sum;
-                    parameters_trace.push_back(parameter_accessor);// save to the parameters_trace
-                    goal_fn_trace.push_back(goal_function_value);//
-                    if (print_progress_level > 0) {
-                        cout << goal_function_value <<" : ParameterVector(";
-                        for (size_t i = 0; i < parameter_accessor.size(); ++i) {
-                            cout << parameter_accessor.get(i);
-                            if (i < parameter_accessor.size() - 1) cout << ", ";
-                        }
-                        cout << ")" << endl;
-                    }
                     return goal_function_value;
                 }
             };
@@ -23,6 +23,10 @@
 
 #include <vector>
 #include <cstring>
+#include <memory>
+#include <algorithm>
+
+#include "work_pool.h"
 
 namespace shyft {
     namespace core {
@@ -30,11 +34,44 @@ namespace shyft {
             using namespace std;
             ///< just temporary simple abstract interface for the target function, later just a callable
             struct ifx {
+                virtual ~ifx() {}
                 virtual double evaluate(const vector<double>& x)=0;
                 double evaluate(size_t n,const double *x) {
                     vector<double> xx(x,x+n);
                     return evaluate(xx);
                 }
+
+                /** the max number of concurrent calls to evaluate that the implementation supports, 1 means not thread-safe */
+                virtual size_t concurrency() const { return 1; }
+
+                /** \brief evaluate fxs[i]=evaluate(xs[i]) for all the xs
+                 *
+                 * Used by the optimizers for points that are independent of each other,
+                 * like the initial population. If concurrency() > 1, up to concurrency()
+                 * evaluations are done concurrently, otherwise the xs are evaluated in order.
+                 */
+                virtual void evaluate_batch(const vector<vector<double>>& xs, vector<double>& fxs) {
+                    fxs.resize(xs.size());
+                    const size_t n_workers = std::min(concurrency(), xs.size());
+                    if (n_workers > 1) {
+                        get_pool(n_workers).parallel_for(xs.size(), n_workers, [this, &xs, &fxs](size_t i0, size_t i1) {
+                            for (size_t i = i0; i < i1; ++i)
+                                fxs[i] = evaluate(xs[i]);
+                        });
+                    } else {
+                        for (size_t i = 0; i < xs.size(); ++i)
+                            fxs[i] = evaluate(xs[i]);
+                    }
+                }
+
+                /** \return the pool used for concurrent evaluations, (re)created so that it has at least n_workers, counting the calling thread */
+                work_pool& get_pool(size_t n_workers) {
+                    if (!pool || pool->size() + 1 < n_workers)
+                        pool = std::make_unique<work_pool>(n_workers > 0 ? n_workers - 1 : 0);
+                    return *pool;
+                }
+              private:
+                std::unique_ptr<work_pool> pool;
             };
 
             /// \brief  __autoalloc__ uses alloca and typecast to allocate an array on stack,
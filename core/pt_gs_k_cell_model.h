@@ -10,6 +10,9 @@
 
 #include "core_serialization.h"
 #include "cell_model.h"
+#include "cell_arena.h"
+#include "float_ts.h"
+#include "response_sums.h"
 #include "pt_gs_k.h"
 
 namespace shyft {
@@ -91,18 +94,21 @@ namespace shyft {
                 void set_end_response(const response_t& r) {end_reponse=r;}
             };
 
-            /** \brief a collector that collects/keep discharge only */
-            struct discharge_collector {
+            /** \brief a collector that collects/keep discharge only
+             * \tparam TS the ts type for the collected series, pts_t, or fpts_t for single precision storage
+             */
+            template <class TS>
+            struct basic_discharge_collector {
                 double cell_area;///< in [m^2]
-                pts_t avg_discharge; ///< Discharge given in [m^3/s] as the average of the timestep
-                pts_t charge_m3s; ///< = precip + glacier - act_evap - avg_discharge [m^3/s] for the timestep
+                TS avg_discharge; ///< Discharge given in [m^3/s] as the average of the timestep
+                TS charge_m3s; ///< = precip + glacier - act_evap - avg_discharge [m^3/s] for the timestep
                 response_t end_response;///<< end_response, at the end of collected
                 bool collect_snow;
-                pts_t snow_sca;
-                pts_t snow_swe;
-                discharge_collector() : cell_area(0.0),collect_snow(false) {}
-                explicit discharge_collector(const double cell_area) : cell_area(cell_area),collect_snow(false) {}
-                discharge_collector(const double cell_area, const timeaxis_t& time_axis)
+                TS snow_sca;
+                TS snow_swe;
+                basic_discharge_collector() : cell_area(0.0),collect_snow(false) {}
+                explicit basic_discharge_collector(const double cell_area) : cell_area(cell_area),collect_snow(false) {}
+                basic_discharge_collector(const double cell_area, const timeaxis_t& time_axis)
                     : cell_area(cell_area),
                       avg_discharge(time_axis, 0.0), charge_m3s(time_axis, 0.0), collect_snow(false),
                       snow_sca(timeaxis_t(time_axis.start(),time_axis.delta(),0),0.0),
@@ -127,6 +133,9 @@ namespace shyft {
                 }
                 void set_end_response(const response_t& response) {end_response=response;}
             };
+            typedef basic_discharge_collector<pts_t> discharge_collector;
+            typedef basic_discharge_collector<fpts_t> discharge_float_collector;///< discharge_collector with single precision series
+
             /**\brief a state null collector
              *
              * Used during calibration/optimization when there is no need for state,
@@ -207,6 +216,9 @@ namespace shyft {
             // typedef the variants we need exported.
             typedef cell<parameter_t, environment_t, state_t, state_collector, all_response_collector> cell_complete_response_t;///< used for usual/explorative runs, where we would like all possible info, result and state
             typedef cell<parameter_t, environment_t, state_t, null_collector, discharge_collector> cell_discharge_response_t; ///<used for operational or calibration runs, only needed info is collected.
+            typedef cell<parameter_t, environment_arena_t, state_t, null_collector, discharge_collector> cell_arena_discharge_response_t; ///< as cell_discharge_response_t, env_ts in a ts_arena shared by the region_model cells
+            typedef cell<parameter_t, environment_t, state_t, null_collector, sum_collector<response_t>> cell_catchment_sum_response_t; ///< for large regions, the discharge is summed directly pr. catchment and river, \ref response_sums
+            typedef cell<parameter_t, environment_float_t, state_t, null_collector, discharge_float_collector> cell_float_discharge_response_t; ///< as cell_discharge_response_t, with env_ts and response series in single precision
 
         }
         //specialize run method for all_response_collector
@@ -259,6 +271,86 @@ namespace shyft {
                 rc);
         }
 
+        //specialize run method for sum_collector
+        template<>
+        inline void cell<pt_gs_k::parameter_t, environment_t, pt_gs_k::state_t,
+                         pt_gs_k::null_collector, sum_collector<pt_gs_k::response_t>>
+            ::run(const timeaxis_t& time_axis, int start_step, int n_steps) {
+            if (parameter.get() == nullptr)
+                throw std::runtime_error("pt_gs_k::run with null parameter attempted");
+            begin_run(time_axis, start_step, n_steps);
+            pt_gs_k::run_pt_gs_k<direct_accessor, pt_gs_k::response_t>(
+                geo,
+                *parameter,
+                time_axis, start_step, n_steps,
+                env_ts.temperature,
+                env_ts.precipitation,
+                env_ts.wind_speed,
+                env_ts.rel_hum,
+                env_ts.radiation,
+                state,
+                sc,
+                rc);
+        }
+
+        //specialize run method for discharge_float_collector, single precision series
+        template<>
+        inline void cell<pt_gs_k::parameter_t, environment_float_t, pt_gs_k::state_t,
+                         pt_gs_k::null_collector, pt_gs_k::discharge_float_collector>
+            ::run(const timeaxis_t& time_axis, int start_step, int n_steps) {
+            if (parameter.get() == nullptr)
+                throw std::runtime_error("pt_gs_k::run with null parameter attempted");
+            begin_run(time_axis, start_step, n_steps);
+            pt_gs_k::run_pt_gs_k<direct_accessor, pt_gs_k::response_t>(
+                geo,
+                *parameter,
+                time_axis, start_step, n_steps,
+                env_ts.temperature,
+                env_ts.precipitation,
+                env_ts.wind_speed,
+                env_ts.rel_hum,
+                env_ts.radiation,
+                state,
+                sc,
+                rc);
+        }
+
+        template<>
+        inline void cell<pt_gs_k::parameter_t, environment_float_t, pt_gs_k::state_t,
+                         pt_gs_k::null_collector, pt_gs_k::discharge_float_collector>
+            ::set_snow_sca_swe_collection(bool on_or_off) {
+            rc.collect_snow=on_or_off;
+        }
+
+        //specialize run method for discharge_collector, env_ts in arena
+        template<>
+        inline void cell<pt_gs_k::parameter_t, environment_arena_t, pt_gs_k::state_t,
+                         pt_gs_k::null_collector, pt_gs_k::discharge_collector>
+            ::run(const timeaxis_t& time_axis, int start_step, int n_steps) {
+            if (parameter.get() == nullptr)
+                throw std::runtime_error("pt_gs_k::run with null parameter attempted");
+            begin_run(time_axis, start_step, n_steps);
+            pt_gs_k::run_pt_gs_k<direct_accessor, pt_gs_k::response_t>(
+                geo,
+                *parameter,
+                time_axis, start_step, n_steps,
+                env_ts.temperature,
+                env_ts.precipitation,
+                env_ts.wind_speed,
+                env_ts.rel_hum,
+                env_ts.radiation,
+                state,
+                sc,
+                rc);
+        }
+
+        template<>
+        inline void cell<pt_gs_k::parameter_t, environment_arena_t, pt_gs_k::state_t,
+                         pt_gs_k::null_collector, pt_gs_k::discharge_collector>
+            ::set_snow_sca_swe_collection(bool on_or_off) {
+            rc.collect_snow=on_or_off;
+        }
+
         template<>
         inline void cell<pt_gs_k::parameter_t, environment_t, pt_gs_k::state_t,
                          pt_gs_k::null_collector, pt_gs_k::discharge_collector>
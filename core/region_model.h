@@ -10,7 +10,9 @@
 #include <limits>
 #include <future>
 #include <utility>
+#include <tuple>
 #include <memory>
+#include <functional>
 #include <stdexcept>
 #include <future>
 #include <mutex>
@@ -26,6 +28,10 @@
 #include "routing.h"
 #include "model_state_tuning.h"
 #include "time_axis.h"
+#include "work_pool.h"
+#include "cell_arena.h"
+#include "response_sums.h"
+#include "interpolation_cache.h"
 /**
  * This file now contains mostly things to provide the PTxxK model,or
  * in general a region model, based on distributed cells where
@@ -225,6 +231,7 @@ namespace shyft {
             std::map<int, parameter_t_> catchment_parameters;///<  for each catchment (with cid) parameter is possible
 
             std::vector<bool> catchment_filter;///<if active (alias .size()>0), only calc if catchment_filter[catchment_id] is true.
+            std::vector<int> river_filter;///< run_cells routes these rivers, and the rivers upstream of them, the others are routed on request
             std::vector<int> cix_to_cid;///< maps internal zero-based catchment index ix to externally supplied catchment id.
             std::map<int,int> cid_to_cix;///< map external catchment id to internal index
 
@@ -248,21 +255,211 @@ namespace shyft {
 
             size_t n_catchments=0;///< optimized//extracted as max(cell.geo.catchment_id())+1 in run interpolate
 
+            std::unique_ptr<work_pool> pool;///< persistent threads for the cell-layer and interpolation, created on demand, not shared with clones
+
+            std::shared_ptr<response_sums> sums;///< catchment and river sums, for cells with sum_collector, not shared with clones
+            std::vector<std::pair<int, std::vector<double>>> river_routes;///< (rid,uhg) of the river slots of sums, after the catchment slots
+
+            /** \brief attach the cells to the response sums, and prepare the sums for a run
+             *
+             * One slot pr. catchment, followed by one slot pr. distinct (river, catchment, cell unit hydrograph),
+             * so that the routing can convolve the sum of the cells sharing the same unit hydrograph.
+             * The river slots are kept pr. catchment, so that with a catchment calculation filter,
+             * the sums of the catchments not calculated are kept, as the results of the usual cells are.
+             */
+            void begin_response_sums(int start_step, int n_steps) {
+                if (!sums)
+                    sums = std::make_shared<response_sums>();
+                const size_t n_cix = cix_to_cid.size();
+                std::map<std::tuple<int, size_t, int, double, double>, size_t> route_slot;
+                river_routes.clear();
+                std::vector<bool> active;
+                if (catchment_filter.size()) {
+                    for (size_t i = 0; i < n_cix; ++i)
+                        active.push_back(is_calculated_by_catchment_ix(i));
+                }
+                const bool routed = has_routing();
+                for (auto& c : *cells) {
+                    size_t river_slot = string::npos;
+                    if (routed && routing::valid_routing_id(c.geo.routing.id)) {
+                        const auto& rp = c.parameter->routing;
+                        int n_uhg = routing::model<C>::cell_uhg_steps(c, time_axis.delta());
+                        auto key = std::make_tuple(int(c.geo.routing.id), c.geo.catchment_ix, n_uhg, rp.alpha, rp.beta);
+                        auto f = route_slot.find(key);
+                        if (f == route_slot.end()) {
+                            f = route_slot.emplace(key, n_cix + river_routes.size()).first;
+                            river_routes.emplace_back(int(c.geo.routing.id), routing::make_uhg_from_gamma(n_uhg, rp.alpha, rp.beta));
+                            if (active.size())
+                                active.push_back(is_calculated_by_catchment_ix(c.geo.catchment_ix));
+                        }
+                        river_slot = f->second;
+                    }
+                    cell_response_sums<C>::attach(c, sums, c.geo.catchment_ix, river_slot);
+                }
+                sums->begin_run(time_axis, n_cix + river_routes.size(), start_step, n_steps, std::move(active));
+            }
+
+            /** \brief routed_flows keeps the output flow of the rivers, as computed by run_routing
+             *
+             * Each river has a signature, the river and cell routing properties that its flow depends on,
+             * apart from the cell results, so that changes to the river network, the cell to river connections
+             * or the routing parameters are detected.
+             */
+            struct routed_flows {
+                timeaxis_t ta;
+                std::vector<int> rid;///< river ids, ascending
+                std::vector<std::vector<double>> signature;///< pr. river, \ref routing_signature
+                std::vector<pts_t> output;///< pr. river, the output flow [m3/s]
+                std::vector<char> pending;///< pr. river, true if it needs to be computed, but was not requested by the river_filter
+            };
+            routed_flows routed;///< the result of the last run_routing, copied to clones (equal cell results)
+
+            /** \brief the cells feeding each river, the O(cells) part of the routing signature
+             *
+             * Rebuilt by run_cells, and by connect_catchment_to_river, so that the signature
+             * of the routed flows is O(rivers + catchments) to check, \ref routing_signature.
+             */
+            struct routing_layout {
+                std::vector<int> rid;///< river ids, ascending
+                std::vector<std::vector<int>> cix;///< pr. river, the catchment indexes of the cells feeding it, ascending
+                std::vector<double> cells_hash;///< pr. river, a hash of the index and routing distance of the cells feeding it
+            };
+            routing_layout layout;///< the cells feeding each river, copied to clones (equal cells)
+
+            /** \return the layout of the current river network and cell routing */
+            routing_layout make_routing_layout() const {
+                routing_layout r;
+                std::map<int, size_t> ix;
+                for (const auto& rv : river_network.rid_map) {
+                    ix[rv.first] = r.rid.size();
+                    r.rid.push_back(rv.first);
+                }
+                r.cix.resize(r.rid.size());
+                std::vector<size_t> h(r.rid.size(), 0);
+                auto mix = [](size_t& x, size_t v) { x ^= v + 0x9e3779b9 + (x << 6) + (x >> 2); };
+                for (size_t i = 0; i < cells->size(); ++i) {
+                    const auto& c = (*cells)[i];
+                    auto f = ix.find(int(c.geo.routing.id));
+                    if (routing::valid_routing_id(c.geo.routing.id) && f != ix.end()) {
+                        auto& x = r.cix[f->second];
+                        if (x.empty() || x.back() != int(c.geo.catchment_ix))
+                            x.push_back(int(c.geo.catchment_ix));
+                        mix(h[f->second], i);
+                        mix(h[f->second], std::hash<double>()(c.geo.routing.distance));
+                    }
+                }
+                for (auto& x : r.cix) {
+                    std::sort(begin(x), end(x));
+                    x.erase(std::unique(begin(x), end(x)), end(x));
+                }
+                r.cells_hash.assign(begin(h), end(h));
+                return r;
+            }
+
+            bool layout_is_current() const {
+                return layout.rid.size() == river_network.rid_map.size()
+                    && std::equal(begin(layout.rid), end(layout.rid), begin(river_network.rid_map), [](int a, const std::pair<const int, routing::river>& b) { return a == b.first; });
+            }
+
+            /** \return the signature of each river, in ascending river id order,
+             * the river properties, the layout hash of its cells, then the routing parameters of each catchment feeding it.
+             * \note changes made directly to the cell geo routing, not by connect_catchment_to_river, are seen by the next run_cells
+             */
+            std::vector<std::vector<double>> routing_signature() const {
+                const routing_layout& l = layout_is_current() ? layout : make_routing_layout();
+                std::vector<std::vector<double>> r;
+                r.reserve(l.rid.size());
+                size_t i = 0;
+                for (const auto& rv : river_network.rid_map) {
+                    const auto& x = rv.second;
+                    r.push_back(std::vector<double>{double(x.downstream.id), x.downstream.distance, x.parameter.velocity, x.parameter.alpha, x.parameter.beta, l.cells_hash[i]});
+                    for (auto cix : l.cix[i]) {
+                        auto f = catchment_parameters.find(cix_to_cid[cix]);
+                        const auto& rp = (f != catchment_parameters.end() ? *f->second : *region_parameter).routing;
+                        r.back().insert(end(r.back()), {double(cix), rp.velocity, rp.alpha, rp.beta});
+                    }
+                    ++i;
+                }
+                return r;
+            }
+
+            /** \return true if the routed flows are for the current time-axis, river network and cell routing properties */
+            bool routed_is_current() const {
+                return routed.output.size() && routed.ta == time_axis && routed.rid.size() == river_network.rid_map.size()
+                    && std::equal(begin(routed.rid), end(routed.rid), begin(river_network.rid_map), [](int a, const std::pair<const int, routing::river>& b) { return a == b.first; })
+                    && routed.signature == routing_signature();
+            }
+
+            /** \return true if river index i of the routed flows is computed, i.e. not pending */
+            bool routed_has(size_t i) const { return routed.pending.empty() || !routed.pending[i]; }
+            bool routed_has_all() const { return std::none_of(begin(routed.pending), end(routed.pending), [](char p) { return p != 0; }); }
+
+            /** \return the routing model, with lateral inflow from the response sums if the cells keeps no discharge */
+            routing::model<C> routing_model() const {
+                routing::model<C> rn(river_network, cells, time_axis);
+                if (cell_response_sums<C>::supported && sums) {
+                    auto lateral = std::make_shared<routing::lateral_inflow_map>();
+                    const size_t n_cix = cix_to_cid.size();
+                    for (size_t i = 0; i < river_routes.size(); ++i)
+                        (*lateral)[river_routes[i].first].push_back(routing::lateral_inflow{river_routes[i].second, sums->ts(response_sums::discharge_m3s, n_cix + i)});
+                    rn.lateral = lateral;
+                }
+                return rn;
+            }
+
+            template <class TSV>
+            void catchment_sums(TSV& cr, response_sums::series s, std::true_type) const {
+                typedef typename TSV::value_type ts_t;
+                cr.clear();
+                cr.reserve(n_catchments);
+                for (size_t i = 0; i < n_catchments; ++i) {
+                    cr.emplace_back(ts_t(time_axis, 0.0));
+                    if (sums && sums->ta == time_axis)
+                        cr.back().add(sums->ts(s, i));
+                }
+            }
+
+            template <class TSV>
+            void catchment_sums(TSV& cr, response_sums::series s, std::false_type) const {
+                typedef typename TSV::value_type ts_t;
+                cr.clear();
+                cr.reserve(n_catchments);
+                for(size_t i=0;i<n_catchments;++i) {
+                    cr.emplace_back(ts_t(time_axis, 0.0));
+                }
+                for(const auto& c: *cells) {
+                    if ( is_calculated_by_catchment_ix(c.geo.catchment_ix))
+                        cr[c.geo.catchment_ix].add(s == response_sums::discharge_m3s ? c.rc.avg_discharge : c.rc.charge_m3s);
+                }
+            }
+
+            /** \return the pool, (re)created so that it has at least n_workers, counting the calling thread */
+            work_pool& get_pool(size_t n_workers) {
+                if (!pool || pool->size() + 1 < n_workers)
+                    pool = std::make_unique<work_pool>(n_workers > 0 ? n_workers - 1 : 0);
+                return *pool;
+            }
+
             void clone(const region_model& c) {
                 // First, clear own content
                 ncore = c.ncore;
                 time_axis = c.time_axis;
                 catchment_filter = c.catchment_filter;
+                river_filter = c.river_filter;
                 n_catchments = c.n_catchments;
 				ip_parameter = c.ip_parameter;
                 region_env = c.region_env;// todo: verify it is deep or shallow copy
+                ip_cache = c.ip_cache;// immutable content, shared
                 catchment_parameters.clear();
                 // Then, clone from c
                 cix_to_cid=c.cix_to_cid;
                 cid_to_cix=c.cid_to_cix;
                 initial_state = c.initial_state;
                 cells = cell_vec_t_(new cell_vec_t(*(c.cells)));
+                env_arena<typename C::env_ts_t>::copy_binding(*c.cells, *cells);// one arena for the copied cells too
                 river_network=c.river_network;
+                routed=c.routed;
+                layout=c.layout;
                 set_region_parameter(*(c.region_parameter));
                 for(const auto& pair:c.catchment_parameters)
                     set_catchment_parameter(pair.first, *(pair.second));
@@ -311,6 +508,7 @@ namespace shyft {
             size_t ncore = 0; ///<< defaults to 4x hardware concurrency, controls number of threads used for cell processing
 			interpolation_parameter ip_parameter;///< the interpolation parameter as passed to interpolate/run_interpolation
             region_env_t region_env;///< the region environment (shallow-copy?) as passed to the interpolation/run_interpolation
+            interpolation_cache ip_cache;///< the interpolation weights/operators, recomputed when cell or source locations, or ip_parameter changes
             std::vector<state_t> initial_state; ///< the initial state, set explicit, or by the first call to .set_states(..) or run_cells()
             routing::river_network river_network;///< the routing river_network, can be empty
             /** \brief compute and return number of catchments inspecting call cells.geo.catchment_id() */
@@ -325,6 +523,7 @@ namespace shyft {
                 if(routing::valid_routing_id(rid)) river_network.check_rid(rid);// verify it exists.
                 for(auto&c:*cells)
                     if(int(c.geo.catchment_id())==cid) c.geo.routing.id=rid;
+                layout = make_routing_layout();
             }
 
             bool has_routing() const {
@@ -356,8 +555,10 @@ namespace shyft {
 			 * \return void
 			 */
 			void initialize_cell_environment(const timeaxis_t& time_axis) {
-				for (auto&c : *cells) {
-					c.init_env_ts(time_axis);
+				if (!env_arena<typename C::env_ts_t>::bind(*cells, time_axis)) { // arena env: one block for all cells
+					for (auto&c : *cells) {
+						c.init_env_ts(time_axis);
+					}
 				}
 				n_catchments = number_of_catchments();// keep this/assume invariant..
 				this->time_axis = time_axis;
@@ -395,6 +596,25 @@ namespace shyft {
 			*/
 
 			bool interpolate(const interpolation_parameter& ip_parameter, const region_env_t& env, bool best_effort=true) {
+				return interpolate_range(ip_parameter, env, 0, 0, best_effort);
+			}
+
+			/** \brief interpolate the supplied region_environment to the cells, for a range of time-steps
+			*
+			* Like interpolate(), but only the time-steps [start_step..start_step+n_steps> of the cell env. series are
+			* (re)computed, the other time-steps are kept as is. This allows a rolling update, e.g. when only
+			* the most recent forecast steps changes, at a cost proportional to n_steps, not the time-axis size.
+			*
+			* \note initialize_cell_environment should be called prior to this, and the cell env. series are not reset
+			*
+			* \param ip_parameter contains wanted parameters for the interpolation
+			* \param env contains the \ref region_environment type
+			* \param start_step the first time-step of the region-model time-axis to interpolate
+			* \param n_steps number of time-steps to interpolate, 0 means to the end of the time-axis
+			* \param best_effort controls if the entire calculation should be aborted in case of one ip-going wrong(leaving nans @ cells)
+			* \return true if everything went ok, false if exceptions, doing best effort
+			*/
+			bool interpolate_range(const interpolation_parameter& ip_parameter, const region_env_t& env, size_t start_step, size_t n_steps, bool best_effort=true) {
 				using namespace shyft::core;
 				using namespace std;
 				namespace idw = shyft::core::inverse_distance;
@@ -444,6 +664,14 @@ namespace shyft {
 				typedef idw::rel_hum_model      <idw_compliant_rel_hum_gts_t, cell_proxy, typename interpolation_parameter::idw_parameter_t, geo_point> idw_relhum_model_t;
 
 				typedef  shyft::time_series::average_accessor<typename region_env_t::temperature_t::ts_t, timeaxis_t> btk_tsa_t;
+				if (n_steps == 0)
+					n_steps = start_step < time_axis.size() ? time_axis.size() - start_step : 0;
+				if (start_step + n_steps > time_axis.size())
+					throw runtime_error("interpolate_range: step range outside the region-model time-axis");
+				for (const auto& c : cell_ps)
+					if (c.cell->env_ts.temperature.size() != time_axis.size())
+						throw runtime_error("interpolate_range: initialize_cell_environment must be called prior to interpolation");
+				const size_t i0 = start_step;
 				this->ip_parameter = ip_parameter;// keep the most recently used ip_parameter
                 this->region_env = env;// this could be a shallow copy
 				// Allocate memory for the source_destinations, put in the reference to the parameters:
@@ -453,74 +681,113 @@ namespace shyft {
 				//  interpolated/distributed signal, e.g. temperature input from arome-data
 
 
-				auto btkx = async(launch::async, [&]() {
+				// the weights/operators are kept in ip_cache, keyed by the locations of sources and cells, and the parameters
+				auto destinations = make_shared<const vector<geo_point>>(geometry_key::points(begin(cell_ps), end(cell_ps)));
+				auto idw_key = [&destinations](const auto& sources, const idw::parameter& p) {
+					return geometry_key{geometry_key::points(begin(sources), end(sources)), destinations, interpolation_cache::idw_key(p)};
+				};
+				int idw_ncore = ncore == 1 ? 1 : -1;// a single threaded model, also interpolates each source single threaded
+
+				auto btkx = [&]() {
 					if (env.temperature != nullptr) {
 						if (env.temperature->size()>1) {
 							if (ip_parameter.use_idw_for_temperature) {
+								auto w = ip_cache.temperature_idw.get(idw_key(*env.temperature, ip_parameter.temperature_idw), [&]() {
+									return idw::build_idw_weights<idw_temperature_model_t, idw_compliant_temperature_gts_t>(time_axis, *env.temperature, ip_parameter.temperature_idw, cell_ps);
+								});
 								idw::run_interpolation<idw_temperature_model_t, idw_compliant_temperature_gts_t>(
-									time_axis, *env.temperature, ip_parameter.temperature_idw, cell_ps,
-									[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.temperature.set(ix, value); }
+									time_axis, i0, n_steps, *env.temperature, ip_parameter.temperature_idw, cell_ps,
+									[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.temperature.set(ix, value); }, idw_ncore, w.get()
 								);
 							} else {
+								auto op = ip_cache.temperature_btk.get(
+									geometry_key{geometry_key::points(begin(*env.temperature), end(*env.temperature)), destinations, interpolation_cache::btk_key(ip_parameter.temperature)},
+									[&]() { return btk::build_btk_operators(begin(*env.temperature), end(*env.temperature), begin(cell_ps), end(cell_ps), ip_parameter.temperature); });
 								btk::btk_interpolation<btk_tsa_t>(
 									begin(*env.temperature), end(*env.temperature), begin(cell_ps), end(cell_ps),
-									time_axis, ip_parameter.temperature
+									time_axis, ip_parameter.temperature, i0, n_steps, *op
 									);
 							}
 						} else {
 							// just one temperature ts. just a a clean copy to destinations
 							btk_tsa_t tsa((*env.temperature)[0].ts, time_axis);
-							typename cell_t::env_ts_t::temperature_ts_t temp_ts(time_axis, 0.0);
-							for (size_t i = 0;i<time_axis.size();++i) {
-								temp_ts.set(i, tsa.value(i));
+							vector<double> temp(n_steps);
+							for (size_t i = 0;i<n_steps;++i) {
+								temp[i] = tsa.value(i0 + i);
 							}
-							for (auto& c : *cells) {
-                                if(is_calculated_by_catchment_ix(c.geo.catchment_ix))
-								c.env_ts.temperature = temp_ts;
+							for (auto& c : cell_ps) {
+								for (size_t i = 0;i<n_steps;++i)
+									c.cell->env_ts.temperature.set(i0 + i, temp[i]);
 							}
 						}
 					}
-				});
+				};
 
-				auto idw_precip = async(launch::async, [&]() {
-					if (env.precipitation != nullptr)
+				auto idw_precip = [&]() {
+					if (env.precipitation != nullptr) {
+						auto w = ip_cache.precipitation.get(idw_key(*env.precipitation, ip_parameter.precipitation), [&]() {
+							return idw::build_idw_weights<idw_precipitation_model_t, idw_compliant_precipitation_gts_t>(time_axis, *env.precipitation, ip_parameter.precipitation, cell_ps);
+						});
 						idw::run_interpolation<idw_precipitation_model_t, idw_compliant_precipitation_gts_t>(
-							time_axis, *env.precipitation, ip_parameter.precipitation, cell_ps,
-							[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.precipitation.set(ix, value); }
-					);
-				});
+							time_axis, i0, n_steps, *env.precipitation, ip_parameter.precipitation, cell_ps,
+							[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.precipitation.set(ix, value); }, idw_ncore, w.get()
+						);
+					}
+				};
 
-				auto idw_radiation = async(launch::async, [&]() {
-					if (env.radiation != nullptr)
+				auto idw_radiation = [&]() {
+					if (env.radiation != nullptr) {
+						auto w = ip_cache.radiation.get(idw_key(*env.radiation, ip_parameter.radiation), [&]() {
+							return idw::build_idw_weights<idw_radiation_model_t, idw_compliant_radiation_gts_t>(time_axis, *env.radiation, ip_parameter.radiation, cell_ps);
+						});
 						idw::run_interpolation<idw_radiation_model_t, idw_compliant_radiation_gts_t>(
-							time_axis, *env.radiation, ip_parameter.radiation, cell_ps,
-							[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.radiation.set(ix, value); }
-					);
-				});
+							time_axis, i0, n_steps, *env.radiation, ip_parameter.radiation, cell_ps,
+							[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.radiation.set(ix, value); }, idw_ncore, w.get()
+						);
+					}
+				};
 
-				auto idw_wind_speed = async(launch::async, [&]() {
-					if (env.wind_speed != nullptr)
+				auto idw_wind_speed = [&]() {
+					if (env.wind_speed != nullptr) {
+						auto w = ip_cache.wind_speed.get(idw_key(*env.wind_speed, ip_parameter.wind_speed), [&]() {
+							return idw::build_idw_weights<idw_windspeed_model_t, idw_compliant_wind_speed_gts_t>(time_axis, *env.wind_speed, ip_parameter.wind_speed, cell_ps);
+						});
 						idw::run_interpolation<idw_windspeed_model_t, idw_compliant_wind_speed_gts_t>(
-							time_axis, *env.wind_speed, ip_parameter.wind_speed, cell_ps,
-							[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.wind_speed.set(ix, value); }
-					);
-				});
+							time_axis, i0, n_steps, *env.wind_speed, ip_parameter.wind_speed, cell_ps,
+							[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.wind_speed.set(ix, value); }, idw_ncore, w.get()
+						);
+					}
+				};
 
-				auto idw_rel_hum = async(launch::async, [&]() {
-					if (env.rel_hum != nullptr)
+				auto idw_rel_hum = [&]() {
+					if (env.rel_hum != nullptr) {
+						auto w = ip_cache.rel_hum.get(idw_key(*env.rel_hum, ip_parameter.rel_hum), [&]() {
+							return idw::build_idw_weights<idw_relhum_model_t, idw_compliant_rel_hum_gts_t>(time_axis, *env.rel_hum, ip_parameter.rel_hum, cell_ps);
+						});
 						idw::run_interpolation<idw_relhum_model_t, idw_compliant_rel_hum_gts_t>(
-							time_axis, *env.rel_hum, ip_parameter.rel_hum, cell_ps,
-							[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.rel_hum.set(ix, value); }
-					);
-				});
-
-                bool btkx_ok=true,precip_ok=true,radiation_ok=true,wind_speed_ok=true,rel_hum_ok=true;
+							time_axis, i0, n_steps, *env.rel_hum, ip_parameter.rel_hum, cell_ps,
+							[](cell_proxy &d, size_t ix, double value) { d.cell->env_ts.rel_hum.set(ix, value); }, idw_ncore, w.get()
+						);
+					}
+				};
+
+				// run the interpolations concurrently on the pool, at most ncore of them, keeping the exception of each
+				std::vector<std::function<void()>> ip_tasks{btkx, idw_precip, idw_radiation, idw_wind_speed, idw_rel_hum};
+				std::vector<exception_ptr> ip_ex(ip_tasks.size());
+				auto run_ip_tasks = [&ip_tasks, &ip_ex](size_t i0, size_t i1) {
+					for (size_t i = i0; i < i1; ++i) {
+						try {ip_tasks[i]();} catch(...) {ip_ex[i]=current_exception();}
+					}
+				};
+				size_t ip_ncore = ncore > 0 ? std::min(ncore, ip_tasks.size()) : ip_tasks.size();
+				if (ip_ncore < 2)
+					run_ip_tasks(0, ip_tasks.size());// single threaded, no pool needed
+				else
+					get_pool(ip_ncore).parallel_for(ip_tasks.size(), ip_ncore, run_ip_tasks);
+                bool btkx_ok=!ip_ex[0],precip_ok=!ip_ex[1],radiation_ok=!ip_ex[2],wind_speed_ok=!ip_ex[3],rel_hum_ok=!ip_ex[4];
                 exception_ptr p_ex;
-				try {btkx.get();} catch(...) {p_ex=current_exception();btkx_ok=false;}
-				try {idw_precip.get();} catch(...) {p_ex=current_exception();precip_ok=false;}
-				try {idw_radiation.get();} catch(...) {p_ex=current_exception();radiation_ok=false;}
-				try {idw_wind_speed.get();} catch(...) {p_ex=current_exception();wind_speed_ok=false;}
-				try {idw_rel_hum.get();} catch(...) {p_ex=current_exception();rel_hum_ok=false;}
+				for (const auto& e : ip_ex)
+				    if (e) p_ex = e;
 				if(!best_effort && p_ex)
 				    rethrow_exception(p_ex);
 				return btkx_ok && precip_ok && radiation_ok && wind_speed_ok && rel_hum_ok;
@@ -566,7 +833,7 @@ namespace shyft {
             *  -# catchment_parameters should be set (and applied to the matching cells)
             * \post :
             *  -# all cells have updated state variables
-            *
+            *  -# the rivers of the river calculation filter, and upstream, are routed, the others when requested, \ref run_routing
             *
             * \param use_ncore if 0 figure out threads using hardware info,
             *   otherwise use supplied value (throws if >100x ncore)
@@ -592,8 +859,12 @@ namespace shyft {
                     throw runtime_error("region_model::run start_step+n_steps must be within time-axis range");
                 if (initial_state.size() != cells->size())
                     get_states(initial_state); // snap the initial state here, unless it's already set by the user
+                if (cell_response_sums<C>::supported)
+                    begin_response_sums(start_step, n_steps);
                 parallel_run(time_axis,start_step,n_steps, begin(*cells), end(*cells),use_ncore);
-                run_routing(start_step,n_steps);
+                if (cell_response_sums<C>::supported)
+                    sums->end_run();
+                run_routing(start_step,n_steps,use_ncore);
             }
 
 			/**\brief state adjustment to achieve wanted/observed flow
@@ -725,18 +996,23 @@ namespace shyft {
                 } else {
                     catchment_filter.clear();
                 }
-
+                river_filter.clear();
             }
 
             /** \brief set/reset the catchment and river based calculation filter.
              * This affects what get simulate/calculated during
              * the run command. Pass an empty list to reset/clear the filter (i.e. no filter).
+             * The catchments feeding the rivers, or the rivers upstream, are calculated, and
+             * run_cells routes those rivers, and the rivers upstream, the other rivers are routed on request.
              *
              * \param catchment_id_list is a catchment id vector
              * \param river_id_list is a river id vector
              */
             void set_calculation_filter(const std::vector<int>& catchment_id_list, const std::vector<int>& river_id_list) {
                 set_catchment_calculation_filter(catchment_id_list);
+                for (auto rid : river_id_list)
+                    river_network.check_rid(rid);
+                river_filter = river_id_list;
                 for (auto rid : river_id_list) {
                     auto catchments_involved = get_catchment_feeding_to_river(rid);
                     for (auto cid : catchments_involved) {
@@ -747,6 +1023,17 @@ namespace shyft {
                 }
             }
 
+            /** \return the catchment ids of the calculation filter, empty if all catchments are calculated */
+            std::vector<int> get_catchment_calculation_filter() const {
+                std::vector<int> r;
+                for (size_t i = 0; i < catchment_filter.size(); ++i)
+                    if (catchment_filter[i]) r.push_back(cix_to_cid[i]);
+                return r;
+            }
+
+            /** \return the river ids of the calculation filter, the rivers routed by run_cells, (with the rivers upstream) */
+            const std::vector<int>& get_river_calculation_filter() const { return river_filter; }
+
             /**compute the unique set of catchments feeding into this river_id, or any river upstream */
             std::set<int> get_catchment_feeding_to_river(int river_id) const {
                 std::set<int> r;
@@ -869,64 +1156,71 @@ namespace shyft {
              * \param cr catchment result vector to be filled in
              * \note the ts type should have proper move/copy etc. semantics
              * \return filled in cr, dimensioned to number of catchments, where the i'th entry correspond to cid using cix_to_cid(i)
+             * \note for cells with sum_collector, the catchment sums collected during run_cells are used, \ref response_sums
              */
             template <class TSV>
             void catchment_discharges( TSV& cr) const {
-                typedef typename TSV::value_type ts_t;
-                cr.clear();
-                cr.reserve(n_catchments);
-                for(size_t i=0;i<n_catchments;++i) {
-                    cr.emplace_back(ts_t(time_axis, 0.0));
-                }
-                for(const auto& c: *cells) {
-                    if ( is_calculated_by_catchment_ix(c.geo.catchment_ix))
-                        cr[c.geo.catchment_ix].add(c.rc.avg_discharge);
-                }
+                catchment_sums(cr, response_sums::discharge_m3s, std::integral_constant<bool, cell_response_sums<C>::supported>());
             }
 
             template <class TSV>
             void catchment_charges(TSV& cr) const {
-                typedef typename TSV::value_type ts_t;
-                cr.clear();
-                cr.reserve(n_catchments);
-                for (size_t i = 0;i < n_catchments;++i) {
-                    cr.emplace_back(ts_t(time_axis, 0.0));
-                }
-                for (const auto& c : *cells) {
-                    if (is_calculated_by_catchment_ix(c.geo.catchment_ix)) {
-                        cr[c.geo.catchment_ix].add(c.rc.charge_m3s);
-                    }
-                }
+                catchment_sums(cr, response_sums::charge_m3s, std::integral_constant<bool, cell_response_sums<C>::supported>());
             }
 
             /**\brief return all discharges at the output of the routing points
              *
              * For all routing nodes,(maybe terminal routing nodes ?)
-             * compute the routed discharge.
+             * compute the routed discharge, in one topological pass, \ref routing::model::all_output_m3s
              * \note if no routing, empty time-series is returned.
              * \return time-series by ascending routing id order where the i'th entry correspond to sorted river idents asc.
              */
             template <class TSV>
             void routing_discharges( TSV& cr) const {
-                //typedef typename TSV::value_type ts_t;
                 cr.clear();
                 if(has_routing()) {
-                    //TODO: iterate over the routing model, return results
-                    routing::model<C> rn(river_network,cells,time_axis);
-                    std::vector<int> rids;
-                    for(auto r:river_network.rid_map)
-                        rids.push_back(r.first);
-                    std::sort(begin(rids),end(rids));// ascending order!
-                    for(auto rid:rids) {
-                        cr.emplace_back(rn.output_m3s(rid));
+                    if (routed_is_current() && routed_has_all()) {
+                        for (const auto& q : routed.output)
+                            cr.emplace_back(q);
+                        return;
                     }
+                    for(auto& q:routing_model().all_output_m3s())
+                        cr.emplace_back(std::move(q));
                 }
-                return cr;
             }
+
+            /** \brief the routed output flow of all rivers, computed in one pass
+             *
+             * Each river is computed once, and the independent parts of the river network
+             * are computed in parallel, so this is the preferred way to get the flow of many rivers.
+             * The flows computed by run_cells are used if still valid, the others are computed and kept, \ref route_pending.
+             * \param use_ncore if 0, use ncore, otherwise the number of concurrent workers
+             * \return river id to routed output flow [m3/s], zero flow if no routing
+             */
+            std::map<int, pts_t> river_output_flows_m3s(size_t use_ncore = 0) {
+                std::map<int, pts_t> r;
+                if (!has_routing()) {
+                    for (const auto& rv : river_network.rid_map)
+                        r.emplace(rv.first, pts_t(time_axis, 0.0, time_series::ts_point_fx::POINT_AVERAGE_VALUE));
+                    return r;
+                }
+                route_pending(use_ncore);
+                for (size_t i = 0; i < routed.rid.size(); ++i)
+                    r.emplace(routed.rid[i], routed.output[i]);
+                return r;
+            }
+
+            /** \return the routed output flow of river rid, from the flows computed by run_cells if still valid, \ref run_routing */
             std::shared_ptr<pts_t> river_output_flow_m3s(int rid) const {
                 auto r= std::make_shared<pts_t>(time_axis,0.0,time_series::ts_point_fx::POINT_AVERAGE_VALUE);
                 if(has_routing()) {
-                    routing::model<C> rn(river_network,cells,time_axis);
+                    if (routed_is_current()) {
+                        river_network.check_rid(rid);
+                        size_t i = std::lower_bound(begin(routed.rid), end(routed.rid), rid) - begin(routed.rid);
+                        if (routed_has(i))
+                            return std::make_shared<pts_t>(routed.output[i]);
+                    }
+                    auto rn = routing_model();
                     r=std::make_shared<pts_t>(rn.output_m3s(rid));
                 }
                 return r;
@@ -934,7 +1228,17 @@ namespace shyft {
             std::shared_ptr<pts_t> river_upstream_inflow_m3s(int rid) const {
                 auto r= std::make_shared<pts_t>(time_axis,0.0,time_series::ts_point_fx::POINT_AVERAGE_VALUE);
                 if(has_routing()) {
-                    routing::model<C> rn(river_network,cells,time_axis);
+                    auto ups = river_network.upstreams_by_id(rid);
+                    auto ix = [this](int u) { return size_t(std::lower_bound(begin(routed.rid), end(routed.rid), u) - begin(routed.rid)); };
+                    if (routed_is_current() && std::all_of(begin(ups), end(ups), [&](int u) { return routed_has(ix(u)); })) {
+                        for (auto u : ups) {
+                            const auto& q = routed.output[ix(u)];
+                            for (size_t t = 0; t < r->size(); ++t)
+                                r->add(t, q.value(t));
+                        }
+                        return r;
+                    }
+                    auto rn = routing_model();
                     r=std::make_shared<pts_t>(rn.upstream_inflow(rid));
                 }
                 return r;
@@ -942,7 +1246,7 @@ namespace shyft {
             std::shared_ptr<pts_t> river_local_inflow_m3s(int rid) const {
                 auto r= std::make_shared<pts_t>(time_axis,0.0,time_series::ts_point_fx::POINT_AVERAGE_VALUE);
                 if(has_routing()) {
-                    routing::model<C> rn(river_network,cells,time_axis);
+                    auto rn = routing_model();
                     r=std::make_shared<pts_t>(rn.local_inflow(rid));
                 }
                 return r;
@@ -964,16 +1268,20 @@ namespace shyft {
                         cell->run(time_axis,start_step,n_steps);
                 }
             }
-            /** \brief uses async to execute the single_run, partitioning the cell range into thread-cell count
+            /** \brief execute the single_run over the cell range, using the work_pool
+             *
+             * The cell range is split among use_ncore workers (the calling thread included),
+             * that run chunks of cells, stealing from each other to balance the load, \ref work_pool.
+             * The pool is kept, and reused for subsequent calls.
              *
-             * \throw runtime_error if thread_cell_count is zero
+             * \throw runtime_error if use_ncore is zero
              * \return when all cells calculated
              * \param time_axis time-axis to use
              * \param start_step of time-axis
              * \param n_steps number of steps to run
              * \param 'beg' the beginning of the cell-range
              * \param 'endc' the end of cell range
-             * \param thread_cell_count number of cells given to each async thread
+             * \param use_ncore number of concurrent workers
              */
             void parallel_run(const timeaxis_t& time_axis, int start_step, int  n_steps, cell_iterator beg, cell_iterator endc,int use_ncore) {
                 size_t len = distance(beg, endc);
@@ -981,57 +1289,86 @@ namespace shyft {
                     return;
                 if(use_ncore == 0)
                     throw runtime_error("parallel_run: use_ncore is zero ");
-                vector<future<void>> calcs;
-                mutex pos_mx;
-                size_t pos = 0;
-                for (int i = 0;i < use_ncore;++i) { // using ncore = logical available core saturates cpu 100%
-                    calcs.emplace_back(
-                        async(launch::async,
-                            [this,&pos,&pos_mx,len,&time_axis,&beg,start_step,n_steps]() {
-                                while (true) {
-                                    size_t ci;
-                                    { lock_guard<decltype(pos_mx)> lock(pos_mx);// get work item here
-                                        if (pos < len)
-                                            ci = pos++;
-                                        else
-                                            break;
-                                    }
-                                    this->single_run(time_axis, start_step, n_steps, beg + ci, beg + ci + 1);// just for one cell
-                                }
-                            }
-                        )
-                    );
-                }
-                for(auto &f:calcs)
-                    f.get();
-                return;
+                get_pool(use_ncore).parallel_for(len, use_ncore,
+                    [this,&time_axis,beg,start_step,n_steps](size_t i0, size_t i1) {
+                        this->single_run(time_axis, start_step, n_steps, beg + i0, beg + i1);
+                    }
+                );
             }
-            void run_routing(int start_step,int n_steps) {
-                // TODO: implement
-                // things to consider:
-                //  a) start_step,n_steps could be a problem due to the time-delay/convolution window.
-                //     so data is not available through the convolution until after window-size.
-                //     possible solutions:
-                //         1) leave it to the user
-                //         2)  always run from start_step=0 ?
-                //         3) as the routing model for the largest delay counted in timesteps, start - longest delay
-                //  b) for convolution, we can base the approach on 'pull', calculate on demand, possibly with memory-cached result time-series
-                //     in that scenario, we would need a 'dirty' bit to be set (initially) and when starting the run-cells step.
-                //         1) optimization, maybe later
-                //  c) the catchment filter, based on cids, could also be extended to routing ids (rids).
-                //     also: if routing, only rids type of filter allowed ?
-                //           if rids, cell to rid is possibly multi-step lookup. Need to make a rids-filter, where members are all reachable
-                //           cells from wanted rids (to be calculated).
-                //         1) leave it to user
-                //         2) make alg. given rid's: compute cid's needed
-                //         3) if river_network available, deny cids based filter, insist on rids ?
-                //
-                //  d) consistency: if cids are used, and routing (and rids) are enabled, auto-extend the cids so that all connected cells(and corresponding cids)
-                //     are calculated (avoid partial calculation of something that goes into a routing network...
-                //     question: how much of this consistency/complexity should we put to the user setting the calculation filter
-                if(!has_routing())
+            /** \brief update the routed flows, after the cells are run, as the last stage of run_cells
+             *
+             * The rivers that needs it are found, that is, rivers fed by cells that was calculated,
+             * (see the calculation filter), rivers with changed signature, \ref routing_signature,
+             * and all rivers downstream of those. The other rivers keeps the flow from the previous run.
+             * The rivers in the river_filter, and upstream, are computed, the other rivers that needs it
+             * are marked as pending, and computed on request, \ref route_pending.
+             * So without a river_filter, no routing is done by run_cells.
+             * The full series is routed, since the convolution carries the start_step..n_steps changes forward in time.
+             * \note cell results changed by other means than run_cells are not detected
+             * \param use_ncore number of concurrent workers
+             */
+            void run_routing(int start_step,int n_steps, size_t use_ncore) {
+                if(!has_routing()) {
+                    routed = routed_flows();
                     return;
+                }
+                layout = make_routing_layout();// cells might be changed in place since last run
+                routed_flows r;
+                r.ta = time_axis;
+                r.rid = layout.rid;
+                r.signature = routing_signature();
+                const size_t n = r.rid.size();
+                const bool keep = routed.ta == time_axis && routed.rid == r.rid && routed.output.size() == n;
+                std::vector<char> dirty(n, keep ? 0 : 1);
+                if (keep) {
+                    r.output = std::move(routed.output);
+                    for (size_t i = 0; i < n; ++i)
+                        if (routed.signature[i] != r.signature[i] || !routed_has(i)) dirty[i] = 1;
+                    for (size_t i = 0; i < n; ++i)
+                        for (auto cix : layout.cix[i])
+                            if (is_calculated_by_catchment_ix(size_t(cix))) dirty[i] = 1;
+                } else {
+                    r.output.resize(n);
+                }
+                std::vector<char> wanted(n, 0);
+                if (river_filter.size()) {
+                    routing::river_graph g(river_network);
+                    for (auto rid : river_filter)
+                        wanted[g.index_of(rid)] = 1;
+                    g.mark_upstreams(wanted);
+                }
+                routed = routed_flows();// in case of exceptions below
+                routing_model().update_output_m3s(r.output, dirty, &get_pool(use_ncore), use_ncore, wanted);
+                if (std::any_of(begin(dirty), end(dirty), [](char d) { return d != 0; }))
+                    r.pending = std::move(dirty);// left out by the river_filter, or not requested
+                routed = std::move(r);
+            }
 
+            /** \brief compute the pending rivers of the routed flows, \ref run_routing, or all of them if not current
+             * \param use_ncore number of concurrent workers, 0 means ncore
+             */
+            void route_pending(size_t use_ncore) {
+                if (use_ncore == 0)
+                    use_ncore = ncore > 0 ? ncore : 4;
+                if (!routed_is_current()) {
+                    routed_flows r;
+                    r.ta = time_axis;
+                    r.rid = layout_is_current() ? layout.rid : make_routing_layout().rid;
+                    r.signature = routing_signature();
+                    r.output.resize(r.rid.size());
+                    routed = std::move(r);
+                    routed.pending.assign(routed.rid.size(), 1);
+                }
+                if (routed_has_all())
+                    return;
+                auto dirty = std::move(routed.pending);
+                routed.pending.clear();
+                try {
+                    routing_model().update_output_m3s(routed.output, dirty, &get_pool(use_ncore), use_ncore);
+                } catch (...) {
+                    routed = routed_flows();
+                    throw;
+                }
             }
         };
 
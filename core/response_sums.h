@@ -0,0 +1,182 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+#include "cell_model.h"
+
+namespace shyft {
+    namespace core {
+
+        /** \brief response_sums keeps the sum of the cell responses pr. slot, where a slot is a catchment, or a river-route
+         *
+         * Used with the sum_collector, each cell adds its response directly to the sums of its slots,
+         * so that the memory needed is n_slots x n_steps, independent of the number of cells.
+         *
+         * During a run, each thread adds to its own partial buffer, covering the steps of the run,
+         * and end_run() reduces the partial buffers into the sums. Thus there is no locking pr. step,
+         * and no sharing of cache-lines between the threads.
+         *
+         * The layout of the sums is [series][slot][t].
+         * \sa sum_collector, cell_response_sums, region_model
+         */
+        struct response_sums {
+            enum series {
+                discharge_m3s = 0,///< average discharge of the time-step [m3/s]
+                charge_m3s = 1,///< precip + glacier - act_evap - avg_discharge [m3/s]
+                n_series = 2
+            };
+            timeaxis_t ta;
+            size_t n_slots{0};
+            std::vector<double> sums;
+
+            response_sums() = default;
+            response_sums(const response_sums&) = delete;
+            response_sums& operator=(const response_sums&) = delete;
+
+            /** \brief prepare for a run covering start_step, n_steps (0 means all steps)
+             *
+             * The sums outside the range are kept, unless time-axis or n_slots changes,
+             * in that case the sums are reset to nan, like ts_init does for the cell collectors.
+             * \param active_slots if not empty, the slots with false are not calculated, and their sums are kept as is
+             */
+            void begin_run(const timeaxis_t& ta_, size_t n_slots_, int start_step, int n_steps, std::vector<bool> active_slots = std::vector<bool>{}) {
+                std::lock_guard<std::mutex> lock(mx);
+                if (ta != ta_ || n_slots != n_slots_ || sums.size() != n_series*n_slots_*ta_.size()) {
+                    ta = ta_;
+                    n_slots = n_slots_;
+                    sums.assign(n_series*n_slots*ta.size(), shyft::nan);
+                }
+                i_begin = n_steps > 0 ? size_t(start_step) : 0;
+                i_end = n_steps > 0 ? size_t(start_step + n_steps) : ta.size();
+                active = std::move(active_slots);
+                partials.clear();
+                run_id = next_run_id();
+            }
+
+            /** \return the partial buffer of the calling thread for the current run, created on first use */
+            double* partial() {
+                struct tl_partial {
+                    std::uint64_t run_id{0};
+                    double* p{nullptr};
+                };
+                static thread_local tl_partial c;
+                if (c.run_id != run_id || c.run_id == 0) {
+                    std::lock_guard<std::mutex> lock(mx);
+                    if (run_id == 0)
+                        throw std::runtime_error("response_sums: collect outside begin_run/end_run");
+                    partials.emplace_back(new std::vector<double>(n_series*n_slots*(i_end - i_begin), 0.0));
+                    c.p = partials.back()->data();
+                    c.run_id = run_id;
+                }
+                return c.p;
+            }
+
+            /** add value x to series s of the slot, at time-step i, to partial buffer p */
+            void add(double* p, series s, size_t slot, size_t i, double x) const {
+                p[(s*n_slots + slot)*(i_end - i_begin) + i - i_begin] += x;
+            }
+
+            /** reduce the partial buffers into the sums of the run range of the active slots, releasing the buffers */
+            void end_run() {
+                std::lock_guard<std::mutex> lock(mx);
+                const size_t n = i_end - i_begin;
+                for (size_t k = 0; k < n_series*n_slots; ++k) {
+                    if (!active.empty() && !active[k%n_slots])
+                        continue;
+                    double* r = sums.data() + k*ta.size() + i_begin;
+                    std::fill(r, r + n, 0.0);
+                    for (const auto& p : partials) {
+                        const double* x = p->data() + k*n;
+                        for (size_t i = 0; i < n; ++i)
+                            r[i] += x[i];
+                    }
+                }
+                partials.clear();
+                run_id = 0;
+            }
+
+            /** \return the sum of series s for the slot, as a point_ts of average values */
+            pts_t ts(series s, size_t slot) const {
+                if (slot >= n_slots)
+                    return pts_t(ta, 0.0, ts_point_fx::POINT_AVERAGE_VALUE);
+                auto b = sums.begin() + (s*n_slots + slot)*ta.size();
+                return pts_t(ta, std::vector<double>(b, b + ta.size()), ts_point_fx::POINT_AVERAGE_VALUE);
+            }
+
+          private:
+            std::mutex mx;///< protects the partials
+            std::vector<std::unique_ptr<std::vector<double>>> partials;///< one pr. thread, covering [i_begin..i_end>
+            size_t i_begin{0};
+            size_t i_end{0};
+            std::vector<bool> active;///< empty, or the slots calculated by the current run
+            std::uint64_t run_id{0};///< unique for each run, 0 when not running
+
+            static std::uint64_t next_run_id() {
+                static std::atomic<std::uint64_t> id{0};
+                return ++id;
+            }
+        };
+
+        /** \brief a response collector that adds discharge and charge to the response_sums of the region_model
+         *
+         * It keeps no time-series, so the memory used is independent of the number of cells,
+         * at the cost of not having the cell-level results.
+         * The slots are assigned by the region_model prior to each run, \ref cell_response_sums.
+         * \tparam R the response type of the method stack, providing total_discharge [mm/h] and charge_m3s
+         */
+        template <class R>
+        struct sum_collector {
+            double cell_area{0.0};///< in [m^2]
+            std::shared_ptr<response_sums> sums;///< shared with the region_model
+            size_t catchment_slot{0};
+            size_t river_slot{std::string::npos};///< npos if the cell is not routed
+            R end_response;///<< end_response, at the end of collected
+
+            void initialize(const timeaxis_t& time_axis, int start_step, int n_steps, double area) {
+                cell_area = area;
+                if (!sums)
+                    throw std::runtime_error("sum_collector: no response_sums attached");
+                p = sums->partial();// begin_run is called from the thread that runs the cell
+            }
+
+            void collect(size_t idx, const R& response) {
+                double q = mmh_to_m3s(response.total_discharge, cell_area);
+                sums->add(p, response_sums::discharge_m3s, catchment_slot, idx, q);
+                sums->add(p, response_sums::charge_m3s, catchment_slot, idx, response.charge_m3s);
+                if (river_slot != std::string::npos)
+                    sums->add(p, response_sums::discharge_m3s, river_slot, idx, q);
+            }
+            void set_end_response(const R& response) { end_response = response; }
+
+          private:
+            double* p{nullptr};///< the partial buffer of the running thread
+        };
+
+        /** \brief cell_response_sums attaches cells with a sum_collector to the response_sums of a region_model
+         *
+         * The default, for other collectors, is not supported, and attach does nothing.
+         */
+        template <class C>
+        struct cell_response_sums {
+            static const bool supported = false;
+            static void attach(C&, const std::shared_ptr<response_sums>&, size_t, size_t) {}
+        };
+
+        template <class P, class E, class S, class SC, class R>
+        struct cell_response_sums<cell<P, E, S, SC, sum_collector<R>>> {
+            static const bool supported = true;
+            static void attach(cell<P, E, S, SC, sum_collector<R>>& c, const std::shared_ptr<response_sums>& sums, size_t catchment_slot, size_t river_slot) {
+                c.rc.sums = sums;
+                c.rc.catchment_slot = catchment_slot;
+                c.rc.river_slot = river_slot;
+            }
+        };
+    }
+}
@@ -13,11 +13,13 @@
 #include <stdexcept>
 #include <future>
 #include <mutex>
+#include <type_traits>
 #include <boost/math/distributions/gamma.hpp>
 
 #include "geo_cell_data.h"
 #include "time_axis.h"
 #include "time_series.h"
+#include "work_pool.h"
 
 namespace shyft {
     namespace core {
@@ -247,6 +249,103 @@ namespace shyft {
                 }
             };
 
+            /** \brief river_graph is the topology of a river_network, as indexes, computed in one pass
+             *
+             * The rivers are ordered so that each river comes after all its upstream rivers,
+             * and grouped by basin, that is the rivers that ends in the same terminal river.
+             * The basins are independent, so they can be routed in parallel.
+             */
+            struct river_graph {
+                std::vector<int> rid;///< river id of index i, ascending
+                std::vector<std::vector<size_t>> upstreams;///< the indexes of the rivers flowing into index i
+                std::vector<size_t> order;///< upstream before downstream, basin by basin
+                std::vector<size_t> basin;///< basin b is order[basin[b]..basin[b+1]>
+
+                river_graph() = default;
+                explicit river_graph(const river_network& rn) {
+                    std::map<int, size_t> ix;
+                    for (const auto& r : rn.rid_map) {
+                        ix[r.first] = rid.size();
+                        rid.push_back(r.first);
+                    }
+                    upstreams.resize(rid.size());
+                    std::vector<size_t> roots;
+                    for (const auto& r : rn.rid_map) {
+                        auto d = ix.find(r.second.downstream.id);
+                        if (valid_routing_id(r.second.downstream.id) && d != ix.end())
+                            upstreams[d->second].push_back(ix[r.first]);
+                        else
+                            roots.push_back(ix[r.first]);
+                    }
+                    for (auto root : roots) {
+                        basin.push_back(order.size());
+                        auto t = subtree(root);
+                        order.insert(end(order), begin(t), end(t));
+                    }
+                    basin.push_back(order.size());
+                }
+                size_t n_basins() const { return basin.size() - 1; }
+
+                /** \return the index of river id rid, \throw runtime_error if it's not in the graph */
+                size_t index_of(int r) const {
+                    auto f = std::lower_bound(begin(rid), end(rid), r);
+                    if (f == end(rid) || *f != r)
+                        throw std::runtime_error(std::string("the supplied river|routing id is not registered/does not exist, id=") + std::to_string(r));
+                    return size_t(f - begin(rid));
+                }
+
+                /** \return i and all its upstreams, upstream first (iterative post-order, so deep networks are ok) */
+                std::vector<size_t> subtree(size_t i) const {
+                    std::vector<size_t> r;
+                    std::vector<std::pair<size_t, size_t>> stack{{i, 0}};
+                    while (stack.size()) {
+                        auto& top = stack.back();
+                        if (top.second < upstreams[top.first].size()) {
+                            size_t u = upstreams[top.first][top.second++];
+                            stack.emplace_back(u, 0);
+                        } else {
+                            r.push_back(top.first);
+                            stack.pop_back();
+                        }
+                    }
+                    return r;
+                }
+
+                /** set the flag of all rivers upstream of a river with the flag set, flags in rid order */
+                void mark_upstreams(std::vector<char>& flags) const {
+                    for (auto k = order.size(); k-- > 0;) {// downstream first, so the flag propagates upstream
+                        size_t i = order[k];
+                        if (flags[i])
+                            for (auto u : upstreams[i]) flags[u] = 1;
+                    }
+                }
+
+                /** set the flag of all rivers downstream of a river with the flag set, flags in rid order */
+                void mark_downstreams(std::vector<char>& flags) const {
+                    for (auto i : order) {// upstream first, so the flag propagates downstream
+                        for (auto u : upstreams[i])
+                            if (flags[u]) flags[i] = 1;
+                    }
+                }
+            };
+
+            /** \brief the lateral inflow into a river from cells with equal cell-to-river routing
+             *
+             * Convolution is linear, so the discharge of the cells that feeds a river through
+             * the same unit hydrograph can be summed first, and convolved once, \ref response_sums.
+             */
+            struct lateral_inflow {
+                std::vector<double> uhg;///< the unit hydrograph, common to the cells of the sum
+                time_series::point_ts<time_axis::fixed_dt> discharge_m3s;///< sum of the cell discharges [m3/s]
+            };
+            typedef std::map<int, std::vector<lateral_inflow>> lateral_inflow_map;///< river id to lateral inflows
+
+            /** \brief true if the cell C keeps its discharge, as C::rc.avg_discharge */
+            template <class C, class = void>
+            struct has_cell_discharge : std::false_type {};
+            template <class C>
+            struct has_cell_discharge<C, decltype(void(std::declval<const C&>().rc.avg_discharge))> : std::true_type {};
+
             /** A routing model
              *
              * Based on modelling the routing using repeated convolution of a unit hydro-graph.
@@ -257,6 +356,7 @@ namespace shyft {
              * \tparam C
              *  Cell type that should provide
              *  -# C::rc.avg_discharge the current core time-series representation, currently point_ts<fixed_dt>..
+             *     or, if the cells keeps no discharge, the lateral inflow sums pr. river must be supplied.
              *
              * \note implementation:
              *    technically we are currently flattening out the ts-expression tree by computing the full
@@ -286,6 +386,7 @@ namespace shyft {
                 std::shared_ptr<river_network> rivers;
                 std::shared_ptr<std::vector<C>> cells; ///< shared with the region_model !
                 time_axis::fixed_dt ta;///< shared with the region_model,  should be the simulation time-axis
+                std::shared_ptr<const lateral_inflow_map> lateral;///< if set, the local inflow is computed from these sums, instead of the cells
 
                 model(const std::shared_ptr<river_network> &rivers,
                       const std::shared_ptr<std::vector<C>>& cells,
@@ -303,6 +404,7 @@ namespace shyft {
                         rivers=c.rivers;
                         cells=c.cells;// shallow
                         ta =c.ta;
+                        lateral=c.lateral;
                     }
                     return *this;
                 }
@@ -310,6 +412,7 @@ namespace shyft {
                     rivers=std::move(c.rivers);
                     cells=std::move(c.cells);
                     ta =std::move(c.ta);
+                    lateral=std::move(c.lateral);
                     return *this;
                 }
 
@@ -322,11 +425,16 @@ namespace shyft {
                 }
 
                 std::vector<double> cell_uhg(const C& c, utctimespan dt) const {
-                    double steps = (c.geo.routing.distance / c.parameter->routing.velocity)/dt;// time = distance / velocity[s] // dt[s]
-                    int n_steps = int(steps + 0.5);
+                    int n_steps = cell_uhg_steps(c, dt);
                     return make_uhg_from_gamma(n_steps, c.parameter->routing.alpha, c.parameter->routing.beta);//std::vector<double>{0.1,0.5,0.2,0.1,0.05,0.030,0.020};
                 }
 
+                /** number of time-steps of the cell to river unit hydrograph */
+                static int cell_uhg_steps(const C& c, utctimespan dt) {
+                    double steps = (c.geo.routing.distance / c.parameter->routing.velocity)/dt;// time = distance / velocity[s] // dt[s]
+                    return int(steps + 0.5);
+                }
+
                 /** compute the cell_output, taking the cell-route to routing river into consideration
                  *
                  */
@@ -336,50 +444,185 @@ namespace shyft {
                 }
 
 
+                typedef std::map<int, std::vector<const C*>> cell_groups_t;///< river id to the cells that feeds it, in cell order
+
+                /** \return the cells grouped by the river they feed, one pass over the cells, empty if lateral inflow is used */
+                cell_groups_t cell_groups() const {
+                    cell_groups_t g;
+                    if (!lateral && cells) {
+                        for (const auto& c : *cells)
+                            if (valid_routing_id(c.geo.routing.id))
+                                g[c.geo.routing.id].push_back(&c);
+                    }
+                    return g;
+                }
+
                 /** compute the local lateral inflow from connected shyft-cells into given river-id
                  *
                  */
                 rts_t local_inflow(int node_id) const {
+                    return local_inflow(node_id, cell_groups());
+                }
+
+                /** local inflow into given river-id, using the cell groups \ref cell_groups */
+                rts_t local_inflow(int node_id, const cell_groups_t& g) const {
+                    if (lateral)
+                        return lateral_local_inflow(node_id);
+                    auto f = g.find(node_id);
+                    if (f == g.end())
+                        return cell_local_inflow(std::vector<const C*>(), has_cell_discharge<C>());
+                    return cell_local_inflow(f->second, has_cell_discharge<C>());
+                }
+
+                /** local inflow as the sum of the convolved lateral inflows into the river */
+                rts_t lateral_local_inflow(int node_id) const {
+                    rts_t r(ta,0.0,time_series::POINT_AVERAGE_VALUE);
+                    auto f = lateral->find(node_id);
+                    if (f == lateral->end())
+                        return r;
+                    for (const auto& li : f->second) {
+                        auto node_output_m3s = time_series::convolve_w_ts<rts_t>(li.discharge_m3s, li.uhg, time_series::convolve_policy::USE_ZERO).values();
+                        for (size_t t = 0;t < r.size();++t)
+                            r.add(t, node_output_m3s[t]);
+                    }
+                    return r;
+                }
+
+                rts_t cell_local_inflow(const std::vector<const C*>& cs, std::false_type) const {
+                    throw std::runtime_error("routing::model: the cells keeps no discharge, and no lateral inflow is supplied");
+                }
+
+                rts_t cell_local_inflow(const std::vector<const C*>& cs, std::true_type) const {
                     rts_t r(ta,0.0,time_series::POINT_AVERAGE_VALUE);// default null to null ts.
-                    for (const auto& c : *cells) {
-                        if (c.geo.routing.id == node_id) {
-                            auto node_output_m3s (cell_output_m3s(c));
-                            for (size_t t = 0;t < r.size();++t)
-                                r.add(t, node_output_m3s.value(t));
-                        }
+                    for (const C* c : cs) {
+                        auto node_output_m3s = cell_output_m3s(*c).values();
+                        for (size_t t = 0;t < r.size();++t)
+                            r.add(t, node_output_m3s[t]);
                     }
                     return r;
                 }
 
                 /** Aggregate the upstream inflow that flows into this cell
-                 * Notice that this is a recursive function that will go upstream
-                 * and collect *all* upstream flow
+                 * Each upstream river is computed once, in topological order, \ref route
                  */
                 rts_t upstream_inflow(int node_id) const {
-                    rts_t r(ta, 0.0, time_series::POINT_AVERAGE_VALUE);
-                    auto upstream_ids=rivers->upstreams_by_id(node_id);
-                    for(auto upstream_id:upstream_ids) {
-                        auto flow_m3s= output_m3s(upstream_id);
-                        for (size_t t = 0;t < ta.size();++t)
-                            r.add(t, flow_m3s.value(t));
-
-                    }
-                    return r;
+                    river_graph g(*rivers);
+                    size_t i = g.index_of(node_id);
+                    std::vector<rts_t> out(g.rid.size());
+                    auto order = g.subtree(i);
+                    order.pop_back();// i itself is not needed
+                    route(g, order, cell_groups(), out);
+                    return upstream_sum(g, i, out);
                 }
 
-                /** Utilizing the local_inflow and upstream_inflow function,
+                /** Utilizing the local_inflow and upstream_inflow,
                  * calculate the output_m3s leaving the specified river.
-                 * This is a walk in the park, since we can just use
-                 * already existing (possibly recursive) functions to do the work.
+                 * The upstream rivers are computed once, in topological order, \ref route
                  */
                 rts_t output_m3s(int node_id) const {
+                    river_graph g(*rivers);
+                    size_t i = g.index_of(node_id);
+                    std::vector<rts_t> out(g.rid.size());
+                    route(g, g.subtree(i), cell_groups(), out);
+                    return out[i];
+                }
+
+                /** \brief the output of all rivers, computed in one topological pass
+                 *
+                 * The cells are grouped by river once, and each river output is computed once,
+                 * and used by the downstream river.
+                 * \param pool the work_pool to use, or nullptr to compute in the calling thread
+                 * \param n_workers max number of concurrent workers, including the calling thread
+                 * \return the output [m3/s] of each river, in ascending river id order, as river_graph::rid
+                 * \sa update_output_m3s
+                 */
+                std::vector<rts_t> all_output_m3s(work_pool* pool = nullptr, size_t n_workers = 1) const {
+                    const size_t n = rivers->rid_map.size();
+                    std::vector<rts_t> out(n);
+                    std::vector<char> dirty(n, 1);
+                    update_output_m3s(out, dirty, pool, n_workers);
+                    return out;
+                }
+
+                /** \brief update the output of the dirty rivers, and all rivers downstream of them
+                 *
+                 * The outputs of the other rivers are kept, and used as the upstream inflow where needed,
+                 * so that if only some cells are changed, only the rivers they feed, and downstream, are computed.
+                 * The local inflows are independent, and are computed in parallel, then the
+                 * basins, that are independent, are routed in parallel, using the pool if supplied.
+                 * \param out the output [m3/s] of each river, in ascending river id order, as river_graph::rid
+                 * \param dirty flag pr. river, in the same order, true if the river needs to be computed.
+                 *        On return, the flag is set for the rivers that needs to be computed, but are not wanted.
+                 * \param pool the work_pool to use, or nullptr to compute in the calling thread
+                 * \param n_workers max number of concurrent workers, including the calling thread
+                 * \param wanted if not empty, flag pr. river, only the wanted rivers are computed,
+                 *        the wanted rivers must include all rivers upstream of them, \ref river_graph::mark_upstreams
+                 * \return the number of rivers computed
+                 */
+                size_t update_output_m3s(std::vector<rts_t>& out, std::vector<char>& dirty, work_pool* pool = nullptr, size_t n_workers = 1,
+                                         const std::vector<char>& wanted = std::vector<char>()) const {
+                    river_graph g(*rivers);
+                    const size_t n = g.rid.size();
+                    if (out.size() != n || dirty.size() != n || (wanted.size() && wanted.size() != n))
+                        throw std::runtime_error("routing::model: the output, dirty and wanted flags must have one entry pr. river");
+                    g.mark_downstreams(dirty);
+                    std::vector<size_t> todo;
+                    std::vector<char> compute(n, 0);
+                    for (size_t i = 0; i < n; ++i) {
+                        if (dirty[i] && (wanted.empty() || wanted[i])) {
+                            todo.push_back(i);
+                            compute[i] = 1;
+                            dirty[i] = 0;
+                        }
+                    }
+                    if (todo.empty())
+                        return 0;
+                    auto groups = cell_groups();
+                    std::vector<rts_t> local(n);
+                    auto parallel_for = [pool, n_workers](size_t m, std::function<void(size_t, size_t)> fx) {
+                        if (pool) pool->parallel_for(m, n_workers, fx);
+                        else fx(0, m);
+                    };
+                    parallel_for(todo.size(), [&](size_t i0, size_t i1) {
+                        for (size_t j = i0; j < i1; ++j)
+                            local[todo[j]] = local_inflow(g.rid[todo[j]], groups);
+                    });
+                    parallel_for(g.n_basins(), [&](size_t b0, size_t b1) {
+                        for (size_t k = g.basin[b0]; k < g.basin[b1]; ++k) {
+                            size_t i = g.order[k];
+                            if (!compute[i])
+                                continue;
+                            out[i] = routed_output(g.rid[i], local[i] + upstream_sum(g, i, out));
+                            local[i] = rts_t();// release memory as we go
+                        }
+                    });
+                    return todo.size();
+                }
+
+              private:
+                /** \return the sum of the outputs of the rivers flowing into river index i */
+                rts_t upstream_sum(const river_graph& g, size_t i, const std::vector<rts_t>& out) const {
+                    rts_t r(ta, 0.0, time_series::POINT_AVERAGE_VALUE);
+                    for (auto u : g.upstreams[i])
+                        for (size_t t = 0; t < ta.size(); ++t)
+                            r.add(t, out[u].value(t));
+                    return r;
+                }
+
+                /** compute out[i] for the river indexes in order, that must have the upstreams first */
+                void route(const river_graph& g, const std::vector<size_t>& order, const cell_groups_t& groups, std::vector<rts_t>& out) const {
+                    for (auto i : order)
+                        out[i] = routed_output(g.rid[i], local_inflow(g.rid[i], groups) + upstream_sum(g, i, out));
+                }
+
+                /** the output of the river, that is the convolution of the sum of its inflows by the river uhg */
+                template <class TS>
+                rts_t routed_output(int node_id, const TS& sum_input_m3s) const {
                     utctimespan dt = ta.delta(); // for now need to pick up delta from the sources
                     std::vector<double> uhg_weights = rivers->river_by_id(node_id).uhg(dt);
-                    auto sum_input_m3s = local_inflow(node_id)+ upstream_inflow(node_id);
-                    auto response = time_series::convolve_w_ts<decltype(sum_input_m3s)>(sum_input_m3s, uhg_weights, time_series::convolve_policy::USE_ZERO);
-                    return rts_t(ta, ts_values(response), time_series::POINT_AVERAGE_VALUE); // flatten values
+                    auto response = time_series::convolve_w_ts<TS>(sum_input_m3s, uhg_weights, time_series::convolve_policy::USE_ZERO);
+                    return rts_t(ta, response.values(), time_series::POINT_AVERAGE_VALUE); // flatten values
                 }
-
             };
 
             /** make_uhg_from_gamma a simple function to create a uhg (unit hydro graph) weight vector
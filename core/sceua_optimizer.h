@@ -55,17 +55,21 @@ namespace shyft {
             /** \brief The sceua implements the Shuffle Complex Evolution University of Arizona variant of
              *  sce published by Duan et. al (1993)
              *
+             *  The initial population is evaluated with ifx::evaluate_batch, and if fx.concurrency() > 1,
+             *  the p complexes of each shuffle are evolved concurrently (evaluate is then called from several threads).
+             *  Each complex then uses its own random generator, seeded from the main generator, so that the result
+             *  is deterministic, but different from the serial evolution.
              */
             class sceua  {
-                #ifdef WIN32
-				mutable std::mt19937 generator;
+#ifdef WIN32
+                typedef std::mt19937 rng_t;
 #else
-                mutable default_random_engine generator;
+                typedef default_random_engine rng_t;
 #endif
-				mutable uniform_real_distribution<double> distribution;//(0.0,1.0)
+                mutable rng_t generator;
 
             public:
-                sceua():distribution(0.0,1.0) {}
+                sceua() {}
                 OptimizerState find_min(
                     const size_t n,			///< Number of active parameters
                     const double x_min[],	///< Lower limit of all n parameters
@@ -95,13 +99,14 @@ namespace shyft {
                     double x[],					///< x[n]  is all the parameter vector required by the model.
                                                 ///< The actual length of this vector is not required in this subroutine.
                     size_t& evaluations,		///< evaluations is a counter for how many times the model is called.
-                    size_t complexno			///< For diagnostics: The number of this complex.
+                    size_t complexno,			///< For diagnostics: The number of this complex.
+                    rng_t& rng					///< The random generator used for this complex.
                     )
                     const;
 
-                void mutate(double *x_alternatives[], double x_new[], size_t na, size_t nprm) const;
-                void random_generate_x(size_t n, double x_new[], const double x_min[], const double x_max[]) const;
-                double random01() const { return distribution(generator); }
+                void mutate(double *x_alternatives[], double x_new[], size_t na, size_t nprm, rng_t& rng) const;
+                void random_generate_x(size_t n, double x_new[], const double x_min[], const double x_max[], rng_t& rng) const;
+                static double random01(rng_t& rng) { return uniform_real_distribution<double>(0.0, 1.0)(rng); }
             };
         }
     }
@@ -15,6 +15,7 @@
 
 #include "utctime_utilities.h"
 #include "time_series_common.h"
+#include "time_series_convolve.h"
 #include "time_axis.h"
 #include "glacier_melt.h" // to get the glacier melt function
 #include "unit_conversion.h"
@@ -880,16 +881,6 @@ namespace shyft{
         };
 
 
-        /** The convolve_policy determines how the convolve_w_ts functions deals with the
-        *  initial boundary condition, i.e. when trying to convolve with values before
-        *  the first value, value(0)
-        * \sa convolve_w_ts
-        */
-        enum convolve_policy:int8_t {
-            USE_FIRST, ///< ts.value(0) is used for all values before value(0): 'mass preserving'
-            USE_ZERO, ///< fill in zero for all values before value(0):shape preserving
-            USE_NAN ///< nan filled in for the first length of the filter
-        };
         /** \brief convolve_w convolves a time-series with weights w
         *
         * The resulting time-series value(i) is the result of convolution (ts*w)|w.size()
@@ -964,6 +955,16 @@ namespace shyft{
             double operator()(utctime t) const {
                 return value(ts.index_of(t));
             }
+            /** all the values, as value(i), but computed in one pass, \ref convolve::convolve_w */
+            std::vector<double> values() const {
+                const size_t n = ts.size();
+                std::vector<double> x; x.reserve(n);
+                for (size_t i = 0;i < n;++i)
+                    x.push_back(ts.value(i));
+                std::vector<double> r(n);
+                convolve::convolve_w(x.data(), n, w.data(), w.size(), policy, r.data());
+                return r;
+            }
             x_serialize_decl();
         };
 
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <limits>
+
+namespace shyft {namespace time_series {
+
+/** The convolve_policy determines how the convolve_w_ts functions deals with the
+*  initial boundary condition, i.e. when trying to convolve with values before
+*  the first value, value(0)
+* \sa convolve_w_ts
+*/
+enum convolve_policy:int8_t {
+    USE_FIRST, ///< ts.value(0) is used for all values before value(0): 'mass preserving'
+    USE_ZERO, ///< fill in zero for all values before value(0):shape preserving
+    USE_NAN ///< nan filled in for the first length of the filter
+};
+
+namespace convolve {
+
+/** \brief direct convolution r[i] = sum w[k]*x[i-k], k in [0..m>, for i in [0..n>
+ *
+ * The values before x[0] are given by the policy.
+ * The result is computed in blocks of the output, with the weights in the outer loop,
+ * so that the inner loop is a contiguous multiply-add that the compiler vectorizes,
+ * and each block of r stays in cache for all the weights.
+ * For each r[i], the terms are added in ascending k order, so the result is exactly equal
+ * to the point by point evaluation of convolve_w_ts::value(i).
+ */
+inline void direct(const double* x, size_t n, const double* w, size_t m, convolve_policy policy, double* r) {
+    const size_t block = 1024;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (size_t i0 = 0; i0 < n; i0 += block) {
+        const size_t i1 = std::min(n, i0 + block);
+        std::fill(r + i0, r + i1, 0.0);
+        for (size_t k = 0; k < m; ++k) {
+            const double wk = w[k];
+            size_t i = i0;
+            if (i < k) {// the start-condition zone, i-k < 0
+                const size_t ie = std::min(i1, k);
+                const double b = policy == convolve_policy::USE_FIRST ? wk*x[0] : (policy == convolve_policy::USE_ZERO ? 0.0 : nan);
+                for (; i < ie; ++i)
+                    r[i] += b;
+            }
+            for (; i < i1; ++i)
+                r[i] += wk*x[i - k];
+        }
+    }
+}
+
+/** \brief radix-2 fft of size n, a power of two, with precomputed twiddle factors and permutation */
+struct fft_plan {
+    size_t n;
+    std::vector<std::complex<double>> tw;///< exp(-2 pi i k/n), k in [0..n/2>
+    std::vector<size_t> rev;///< bit reversal permutation
+
+    explicit fft_plan(size_t n) : n(n), tw(n/2), rev(n, 0) {
+        const double pi = 3.14159265358979323846;
+        for (size_t k = 0; k < n/2; ++k)
+            tw[k] = std::complex<double>(std::cos(2*pi*k/n), -std::sin(2*pi*k/n));
+        for (size_t i = 1, j = 0; i < n; ++i) {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+            rev[i] = j;
+        }
+    }
+
+    /** in place transform of a, a.size()==n, the inverse includes the 1/n scaling */
+    void transform(std::vector<std::complex<double>>& a, bool inverse) const {
+        for (size_t i = 1; i < n; ++i)
+            if (i < rev[i])
+                std::swap(a[i], a[rev[i]]);
+        for (size_t len = 2; len <= n; len <<= 1) {
+            const size_t half = len/2, step = n/len;
+            for (size_t i = 0; i < n; i += len) {
+                for (size_t k = 0; k < half; ++k) {
+                    const auto t = inverse ? std::conj(tw[k*step]) : tw[k*step];
+                    const auto u = a[i + k];
+                    const auto v = a[i + k + half]*t;
+                    a[i + k] = u + v;
+                    a[i + k + half] = u - v;
+                }
+            }
+        }
+        if (inverse) {
+            const double s = 1.0/double(n);
+            for (auto& x : a)
+                x *= s;
+        }
+    }
+};
+
+/** \brief fft based convolution, same result as direct, within floating point tolerance
+ *
+ * The x is extended to the left with the m-1 values given by the policy,
+ * and convolved block by block using overlap-add, with a transform size of about 8 x m.
+ * Since w is real, two real blocks are convolved at once, as the real and imaginary part of one complex block.
+ * Requires all x to be finite, since a nan would spread to the whole block.
+ */
+inline void fft(const double* x, size_t n, const double* w, size_t m, convolve_policy policy, double* r) {
+    size_t N = 1;
+    while (N < 8*m)
+        N <<= 1;
+    const size_t L = N - m + 1;// input block length, so that the block result fits in N
+    const fft_plan plan(N);
+    std::vector<std::complex<double>> W(N, 0.0);
+    for (size_t k = 0; k < m; ++k)
+        W[k] = w[k];
+    plan.transform(W, false);
+    const size_t n_ext = n + m - 1;// x extended to the left with m-1 values
+    const double b = policy == convolve_policy::USE_FIRST ? x[0] : 0.0;
+    auto x_ext = [x, b, m](size_t i) { return i + 1 < m ? b : x[i + 1 - m]; };
+    std::vector<double> y(n_ext + N, 0.0);// the full convolution of x_ext
+    std::vector<std::complex<double>> z(N);
+    for (size_t j0 = 0; j0 < n_ext; j0 += 2*L) {
+        const size_t j1 = j0 + L;// start of the second block, in the imaginary part
+        for (size_t i = 0; i < N; ++i) {
+            const double re = i < L && j0 + i < n_ext ? x_ext(j0 + i) : 0.0;
+            const double im = i < L && j1 + i < n_ext ? x_ext(j1 + i) : 0.0;
+            z[i] = std::complex<double>(re, im);
+        }
+        plan.transform(z, false);
+        for (size_t i = 0; i < N; ++i)
+            z[i] *= W[i];
+        plan.transform(z, true);
+        for (size_t i = 0; i < N && j0 + i < y.size(); ++i)
+            y[j0 + i] += z[i].real();
+        for (size_t i = 0; i < N && j1 + i < y.size(); ++i)
+            y[j1 + i] += z[i].imag();
+    }
+    for (size_t i = 0; i < n; ++i)
+        r[i] = y[m - 1 + i];
+    if (policy == convolve_policy::USE_NAN)
+        std::fill(r, r + std::min(n, m - 1), std::numeric_limits<double>::quiet_NaN());
+}
+
+/** min. number of weights where the fft is used, below, the direct convolution is faster */
+const size_t fft_min_weights = 256;
+
+/** \brief convolve x with w into r, r[i] = sum w[k]*x[i-k], k in [0..m>
+ *
+ * Uses the fft for long weight vectors, and series that are long compared to the weights,
+ * if all x are finite, otherwise the direct convolution.
+ * \param x the n values to convolve
+ * \param w the m weights
+ * \param policy for the values before x[0]
+ * \param r the n results
+ */
+inline void convolve_w(const double* x, size_t n, const double* w, size_t m, convolve_policy policy, double* r) {
+    if (n == 0)
+        return;
+    if (m >= fft_min_weights && n >= 4*m && std::all_of(x, x + n, [](double v) { return std::isfinite(v); })) {
+        fft(x, n, w, m, policy, r);
+    } else {
+        direct(x, n, w, m, policy, r);
+    }
+}
+
+}}}
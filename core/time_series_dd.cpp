@@ -1,5 +1,6 @@
 #include <dlib/statistics.h>
 #include <memory>
+#include <unordered_map>
 #include "time_series_dd.h"
 #include "time_series_merge.h"
 #include "time_series_qm.h"
@@ -116,45 +117,6 @@ namespace shyft{
 			return do_op(lhs(t), op, rhs(t));// this might cost a 2xbin-search if not the underlying ts have smart incremental search (at the cost of thread safety)
 		}
 
-		static vector<double> ts_op_ts_values(const vector<double>& l, iop_t op, const vector<double>& r) {
-			vector<double> x; x.reserve(l.size());
-			switch (op) {
-			case OP_ADD:for (size_t i = 0; i < r.size(); ++i) x.emplace_back(l[i] + r[i]); return x;
-			case OP_SUB:for (size_t i = 0; i < r.size(); ++i) x.emplace_back(l[i] - r[i]); return x;
-			case OP_MUL:for (size_t i = 0; i < r.size(); ++i) x.emplace_back(l[i] * r[i]); return x;
-			case OP_DIV:for (size_t i = 0; i < r.size(); ++i) x.emplace_back(l[i] / r[i]); return x;
-			case OP_MAX:for (size_t i = 0; i < r.size(); ++i) x.emplace_back(std::max(l[i], r[i])); return x;
-			case OP_MIN:for (size_t i = 0; i < r.size(); ++i) x.emplace_back(std::min(l[i], r[i])); return x;
-			default: break;
-			}
-			throw runtime_error("Unsupported operation " + to_string(int(op)));
-		}
-
-		static void lhs_in_place_ts_op_ts_values(vector<double>& l, iop_t op, const vector<double>& r) {
-			switch (op) {
-			case OP_ADD:for (size_t i = 0; i < r.size(); ++i) l[i] += r[i]; return;
-			case OP_SUB:for (size_t i = 0; i < r.size(); ++i) l[i] -= r[i]; return;
-			case OP_MUL:for (size_t i = 0; i < r.size(); ++i) l[i] *= r[i]; return;
-			case OP_DIV:for (size_t i = 0; i < r.size(); ++i) l[i] /= r[i]; return;
-			case OP_MAX:for (size_t i = 0; i < r.size(); ++i) l[i] = std::max(l[i], r[i]); return;
-			case OP_MIN:for (size_t i = 0; i < r.size(); ++i) l[i] = std::min(l[i], r[i]); return;
-			default: break;
-			}
-			throw runtime_error("Unsupported operation " + to_string(int(op)));
-		}
-		static void rhs_in_place_ts_op_ts_values(const vector<double>& l, iop_t op, vector<double>& r) {
-			switch (op) {
-			case OP_ADD:for (size_t i = 0; i < r.size(); ++i) r[i] += l[i]; return;
-			case OP_SUB:for (size_t i = 0; i < r.size(); ++i) r[i] = l[i] - r[i]; return;
-			case OP_MUL:for (size_t i = 0; i < r.size(); ++i) r[i] *= l[i]; return;
-			case OP_DIV:for (size_t i = 0; i < r.size(); ++i) r[i] = l[i] / r[i]; return;
-			case OP_MAX:for (size_t i = 0; i < r.size(); ++i) r[i] = std::max(l[i], r[i]); return;
-			case OP_MIN:for (size_t i = 0; i < r.size(); ++i) r[i] = std::min(l[i], r[i]); return;
-			default: break;
-			}
-			throw runtime_error("Unsupported operation " + to_string(int(op)));
-		}
-
 		static inline const vector<double>* terminal_values(const shared_ptr<ipoint_ts>& ts) {
 			if (dynamic_pointer_cast<aref_ts>(ts))
 				return &dynamic_pointer_cast<aref_ts>(ts)->core_ts().v;
@@ -168,37 +130,164 @@ namespace shyft{
 
 		}
 
+		/** fused evaluation of aligned bin-op expression trees
+		*
+		*  Evaluating a + b*c - 2.0 node by node through .values() materializes
+		*  one full vector for each node, so the computation streams the whole
+		*  time-axis through memory once per operation.
+		*
+		*  Instead, we compile the aligned part of the expression (all bin-ops where lhs and rhs share
+		*  the same time-axis) into a small postfix program, and run it block by block,
+		*  where each block (fused_block_size) fits in L1/L2 cache. The leaves are either
+		*  terminal values (referenced, not copied), or any other expression node, that is
+		*  evaluated once using its own .values().
+		*  The final operation of each block writes directly into the result vector.
+		*  The kernels are plain loops over contiguous doubles, written so that the compiler can vectorize them.
+		*/
+		static const size_t fused_block_size = 1024;
+
+		struct fused_program {
+			enum code_t :int8_t { LOAD, TS_OP_TS, TS_OP_SCALAR, SCALAR_OP_TS };
+			struct instr {
+				code_t code;
+				iop_t op;
+				const double* src;///< LOAD: start of the values
+				double scalar;///< TS_OP_SCALAR,SCALAR_OP_TS: the scalar
+			};
+			vector<instr> code;
+			vector<vector<double>> owned;///< values of non-fuseable sub-expressions, evaluated once
+			size_t n = 0;///< the common size of all nodes in the program
+			size_t depth = 0;
+			size_t max_depth = 0;
+
+			explicit fused_program(size_t n) :n(n) {}
+
+			void load(const double* src) {
+				code.push_back(instr{ LOAD,OP_NONE,src,0.0 });
+				max_depth = std::max(max_depth, ++depth);
+			}
+			void emit(code_t c, iop_t op, double scalar = 0.0) {
+				code.push_back(instr{ c,op,nullptr,scalar });
+				if (c == TS_OP_TS) --depth;
+			}
+
+			/** compile a sub-expression, leaves that can not be fused are evaluated and kept in owned */
+			void compile(const apoint_ts& ats) {
+				if (!compile_op(ats.ts.get())) {
+					const vector<double>* v{ terminal_values(ats) };
+					if (!v) {
+						owned.emplace_back(ats.values());
+						v = &owned.back();
+					}
+					if (v->size() != n)
+						throw runtime_error("fused evaluation: inconsistent size of aligned time-series");
+					load(v->data());
+				}
+			}
+
+			/** try compile ts as a bin-op node, \return false if ts is not a fuseable bin-op */
+			bool compile_op(const ipoint_ts* ts) {
+				if (auto b = dynamic_cast<const abin_op_ts*>(ts)) {
+					if (!(b->lhs.time_axis() == b->rhs.time_axis()))
+						return false;
+					compile(b->lhs); compile(b->rhs);
+					emit(TS_OP_TS, b->op);
+					return true;
+				}
+				if (auto b = dynamic_cast<const abin_op_ts_scalar*>(ts)) {
+					b->bind_check();
+					compile(b->lhs);
+					emit(TS_OP_SCALAR, b->op, b->rhs);
+					return true;
+				}
+				if (auto b = dynamic_cast<const abin_op_scalar_ts*>(ts)) {
+					b->bind_check();
+					compile(b->rhs);
+					emit(SCALAR_OP_TS, b->op, b->lhs);
+					return true;
+				}
+				return false;
+			}
+
+			static void ts_op_ts(double* r, const double* a, iop_t op, const double* b, size_t m) {
+				switch (op) {
+				case OP_ADD:for (size_t i = 0; i < m; ++i) r[i] = a[i] + b[i]; return;
+				case OP_SUB:for (size_t i = 0; i < m; ++i) r[i] = a[i] - b[i]; return;
+				case OP_MUL:for (size_t i = 0; i < m; ++i) r[i] = a[i] * b[i]; return;
+				case OP_DIV:for (size_t i = 0; i < m; ++i) r[i] = a[i] / b[i]; return;
+				case OP_MAX:for (size_t i = 0; i < m; ++i) r[i] = std::max(a[i], b[i]); return;
+				case OP_MIN:for (size_t i = 0; i < m; ++i) r[i] = std::min(a[i], b[i]); return;
+				default: break;
+				}
+				throw runtime_error("Unsupported operation " + to_string(int(op)));
+			}
+			static void ts_op_scalar(double* r, const double* a, iop_t op, double b, size_t m) {
+				switch (op) {
+				case OP_ADD:for (size_t i = 0; i < m; ++i) r[i] = a[i] + b; return;
+				case OP_SUB:for (size_t i = 0; i < m; ++i) r[i] = a[i] - b; return;
+				case OP_MUL:for (size_t i = 0; i < m; ++i) r[i] = a[i] * b; return;
+				case OP_DIV:for (size_t i = 0; i < m; ++i) r[i] = a[i] / b; return;
+				case OP_MAX:for (size_t i = 0; i < m; ++i) r[i] = std::max(a[i], b); return;
+				case OP_MIN:for (size_t i = 0; i < m; ++i) r[i] = std::min(a[i], b); return;
+				default: break;
+				}
+				throw runtime_error("Unsupported operation " + to_string(int(op)));
+			}
+			static void scalar_op_ts(double* r, double a, iop_t op, const double* b, size_t m) {
+				switch (op) {
+				case OP_ADD:for (size_t i = 0; i < m; ++i) r[i] = a + b[i]; return;
+				case OP_SUB:for (size_t i = 0; i < m; ++i) r[i] = a - b[i]; return;
+				case OP_MUL:for (size_t i = 0; i < m; ++i) r[i] = a * b[i]; return;
+				case OP_DIV:for (size_t i = 0; i < m; ++i) r[i] = a / b[i]; return;
+				case OP_MAX:for (size_t i = 0; i < m; ++i) r[i] = std::max(b[i], a); return;// keep arg order(nan-semantics) as before
+				case OP_MIN:for (size_t i = 0; i < m; ++i) r[i] = std::min(b[i], a); return;
+				default: break;
+				}
+				throw runtime_error("Unsupported operation " + to_string(int(op)));
+			}
+
+			/** run the program, block by block, the last instruction writes into the result */
+			vector<double> run() const {
+				vector<double> r(n);
+				vector<double> regs(max_depth*fused_block_size);
+				vector<const double*> sp(max_depth + 1);
+				for (size_t i0 = 0; i0 < n; i0 += fused_block_size) {
+					const size_t m = std::min(fused_block_size, n - i0);
+					size_t s = 0;
+					for (size_t k = 0; k < code.size(); ++k) {
+						const auto& c = code[k];
+						if (c.code == LOAD) {
+							sp[s++] = c.src + i0;
+							continue;
+						}
+						if (c.code == TS_OP_TS) --s;
+						double* out = k + 1 == code.size() ? r.data() + i0 : regs.data() + (s - 1)*fused_block_size;
+						switch (c.code) {
+						case TS_OP_TS: ts_op_ts(out, sp[s - 1], c.op, sp[s], m); break;
+						case TS_OP_SCALAR: ts_op_scalar(out, sp[s - 1], c.op, c.scalar, m); break;
+						case SCALAR_OP_TS: scalar_op_ts(out, c.scalar, c.op, sp[s - 1], m); break;
+						default: break;
+						}
+						sp[s - 1] = out;
+					}
+				}
+				return r;
+			}
+		};
+
 		/** implementation of apoint_ts op apoint_ts
 		*
-		*  Try to optimize the evaluation by considering
-		*  equal time-axis.
-		*  Then also check  rhs and lhs.
-		*  If one is a terminal-value (concrete point ts)
-		*  then just reference the values, otherwise get the computed values.
+		*  If time-axis are aligned, use the fused evaluation
+		*  of this node and all aligned bin-op nodes below it.
 		*
 		* If time-axis not aligned, just compute value-by-value.
 		*
 		*/
 		std::vector<double> abin_op_ts::values() const {
 			if (lhs.time_axis() == rhs.time_axis()) {
-				const vector<double>* lhs_v{ terminal_values(lhs) };
-				const vector<double>* rhs_v{ terminal_values(rhs) };
-				if (lhs_v && rhs_v) {
-					return ts_op_ts_values(*lhs_v, op, *rhs_v);
-				} else if (lhs_v) {
-					auto r{ rhs.values() };
-					rhs_in_place_ts_op_ts_values(*lhs_v, op, r);
-					return r;
-				} else if (rhs_v) {
-					auto l{ lhs.values() };
-					lhs_in_place_ts_op_ts_values(l, op, *rhs_v);
-					return l;
-				} else {
-					auto l{ lhs.values() };
-					auto r{ rhs.values() };
-					lhs_in_place_ts_op_ts_values(l, op, r);
-					return l;
-				}
+				fused_program p(lhs.size());
+				p.compile_op(this);
+				return p.run();
 			} else {
 				std::vector<double> r; r.reserve(time_axis().size());
 				for (size_t i = 0; i < time_axis().size(); ++i) {
@@ -525,6 +614,189 @@ namespace shyft{
 			return true;
 		}
 
+		/** helper for evaluate_common_subexpressions
+		*
+		* First pass: hash-cons all nodes of the expressions into a vector of unique nodes(ids),
+		* ids are assigned children first, so increasing id is a topological order.
+		* Second pass: build new nodes from the unique ones, where a node used more than once
+		* is replaced by a concrete gpoint_ts placeholder (with correct time-axis), to be filled
+		* with the values of the node after the build.
+		* Only nodes with a shared node below are rebuilt, all others are kept as is.
+		*/
+		struct ts_cse_dag {
+			enum node_tag :int8_t { OPAQUE, BIN_OP_TS, BIN_OP_TS_SCALAR, BIN_OP_SCALAR_TS, ABS, AVERAGE, INTEGRAL, ACCUMULATE, TIME_SHIFT };
+
+			struct node_key {
+				node_tag tag = OPAQUE;
+				iop_t op = OP_NONE;
+				double scalar = 0.0;
+				ts_point_fx fx = POINT_AVERAGE_VALUE;///< the point interpretation of bin-op nodes, it could be set explicitly
+				utctimespan dt = 0;
+				const gta_t* ta = nullptr;///< the time-axis parameter of average,integral,accumulate
+				const ipoint_ts* opaque = nullptr;///< the identity of an opaque node
+				size_t c1 = string::npos, c2 = string::npos;///< ids of the children
+
+				bool operator==(const node_key& o) const {
+					return tag == o.tag && op == o.op && scalar == o.scalar && fx == o.fx && dt == o.dt && opaque == o.opaque && c1 == o.c1 && c2 == o.c2
+						&& (ta == o.ta || (ta && o.ta && *ta == *o.ta));
+				}
+			};
+
+			struct node_key_hash {
+				size_t operator()(const node_key& k) const {
+					size_t h = std::hash<int>()((int(k.tag) * 16 + int(k.op)) * 4 + int(k.fx));
+					auto mix = [&h](size_t x) { h ^= x + 0x9e3779b9 + (h << 6) + (h >> 2); };
+					mix(std::hash<double>()(k.scalar));
+					mix(std::hash<utctimespan>()(k.dt));
+					mix(std::hash<const void*>()(k.opaque));
+					mix(k.c1); mix(k.c2);
+					if (k.ta) { mix(k.ta->size()); mix(std::hash<utctime>()(k.ta->total_period().start)); }
+					return h;
+				}
+			};
+
+			struct node {
+				node_key key;
+				shared_ptr<ipoint_ts> ts;///< the first seen node with this key
+				size_t uses = 0;
+				size_t level = 0;///< number of shared nodes on the longest path below(including) this node
+				bool rebuild = false;///< there is a shared node below, so this node is rebuilt on top of the placeholder
+			};
+
+			vector<node> nodes;
+			std::unordered_map<node_key, size_t, node_key_hash> key_ix;
+			std::unordered_map<const ipoint_ts*, size_t> ptr_ix;
+
+			bool shared(size_t i) const { return nodes[i].uses > 1 && nodes[i].key.tag != OPAQUE; }
+
+			size_t id_of(const shared_ptr<ipoint_ts>& ts) {
+				auto f = ptr_ix.find(ts.get());
+				if (f != end(ptr_ix))
+					return f->second;
+				node_key k;
+				if (auto b = dynamic_cast<const abin_op_ts*>(ts.get())) {
+					k.tag = BIN_OP_TS; k.op = b->op; k.fx = b->fx_policy; k.c1 = id_of(b->lhs.ts); k.c2 = id_of(b->rhs.ts);
+				} else if (auto b = dynamic_cast<const abin_op_ts_scalar*>(ts.get())) {
+					k.tag = BIN_OP_TS_SCALAR; k.op = b->op; k.fx = b->fx_policy; k.c1 = id_of(b->lhs.ts); k.scalar = b->rhs;
+				} else if (auto b = dynamic_cast<const abin_op_scalar_ts*>(ts.get())) {
+					k.tag = BIN_OP_SCALAR_TS; k.op = b->op; k.fx = b->fx_policy; k.c1 = id_of(b->rhs.ts); k.scalar = b->lhs;
+				} else if (auto b = dynamic_cast<const abs_ts*>(ts.get())) {
+					k.tag = ABS; k.c1 = id_of(b->ts);
+				} else if (auto b = dynamic_cast<const average_ts*>(ts.get())) {
+					k.tag = AVERAGE; k.c1 = id_of(b->ts); k.ta = &b->ta;
+				} else if (auto b = dynamic_cast<const integral_ts*>(ts.get())) {
+					k.tag = INTEGRAL; k.c1 = id_of(b->ts); k.ta = &b->ta;
+				} else if (auto b = dynamic_cast<const accumulate_ts*>(ts.get())) {
+					k.tag = ACCUMULATE; k.c1 = id_of(b->ts); k.ta = &b->ta;
+				} else if (auto b = dynamic_cast<const time_shift_ts*>(ts.get())) {
+					k.tag = TIME_SHIFT; k.c1 = id_of(b->ts); k.dt = b->dt;
+				} else {
+					k.opaque = ts.get();// terminals, and node types we do not look into
+				}
+				size_t id;
+				auto fk = key_ix.find(k);
+				if (fk != end(key_ix)) {
+					id = fk->second;
+				} else {
+					id = nodes.size();
+					nodes.push_back(node{ k,ts,0,0,false });
+					key_ix[k] = id;
+					if (k.c1 != string::npos) ++nodes[k.c1].uses;
+					if (k.c2 != string::npos) ++nodes[k.c2].uses;
+				}
+				ptr_ix[ts.get()] = id;
+				return id;
+			}
+
+			vector<shared_ptr<ipoint_ts>> built;
+			vector<shared_ptr<gpoint_ts>> placeholder;
+
+			shared_ptr<ipoint_ts> build(size_t i) {
+				if (placeholder[i])
+					return placeholder[i];
+				if (built[i])
+					return built[i];
+				const auto& n = nodes[i];
+				const auto& k = n.key;
+				shared_ptr<ipoint_ts> r;
+				auto c1 = n.rebuild && k.c1 != string::npos ? apoint_ts(build(k.c1)) : apoint_ts();
+				switch (n.rebuild ? k.tag : OPAQUE) {// nothing shared below, keep it as is
+				case BIN_OP_TS: r = make_shared<abin_op_ts>(c1, k.op, apoint_ts(build(k.c2))); r->set_point_interpretation(k.fx); break;
+				case BIN_OP_TS_SCALAR: r = make_shared<abin_op_ts_scalar>(c1, k.op, k.scalar); r->set_point_interpretation(k.fx); break;
+				case BIN_OP_SCALAR_TS: r = make_shared<abin_op_scalar_ts>(k.scalar, k.op, c1); r->set_point_interpretation(k.fx); break;
+				case ABS: r = make_shared<abs_ts>(c1); break;
+				case AVERAGE: r = make_shared<average_ts>(*k.ta, c1); break;
+				case INTEGRAL: r = make_shared<integral_ts>(*k.ta, c1); break;
+				case ACCUMULATE: r = make_shared<accumulate_ts>(*k.ta, c1); break;
+				case TIME_SHIFT: r = make_shared<time_shift_ts>(c1, k.dt); break;
+				case OPAQUE: r = n.ts; break;
+				}
+				if (shared(i)) {
+					placeholder[i] = make_shared<gpoint_ts>(r->time_axis(), shyft::nan, r->point_interpretation());
+					built[i] = r;// keep the real node, the placeholder is what the parents see
+					return placeholder[i];
+				}
+				return built[i] = r;
+			}
+
+			vector<apoint_ts> evaluate(const vector<apoint_ts>& tsv) {
+				vector<size_t> roots; roots.reserve(tsv.size());
+				for (const auto& ats : tsv) {
+					roots.push_back(id_of(ats.sts()));
+					++nodes[roots.back()].uses;
+				}
+				size_t max_level = 0;
+				for (size_t i = 0; i < nodes.size(); ++i) {// children first, so levels propagate upwards
+					const auto& k = nodes[i].key;
+					size_t l = 0;
+					for (auto c : { k.c1, k.c2 }) {
+						if (c == string::npos) continue;
+						l = std::max(l, nodes[c].level);
+						if (shared(c) || nodes[c].rebuild)
+							nodes[i].rebuild = true;
+					}
+					nodes[i].level = l + (shared(i) ? 1 : 0);
+					max_level = std::max(max_level, nodes[i].level);
+				}
+				built.resize(nodes.size());
+				placeholder.resize(nodes.size());
+				vector<apoint_ts> r; r.reserve(tsv.size());
+				for (auto i : roots)
+					r.emplace_back(build(i));
+				for (size_t level = 1; level <= max_level; ++level) {// evaluate shared nodes, bottom up, level by level
+					vector<size_t> ix;
+					for (size_t i = 0; i < nodes.size(); ++i)
+						if (placeholder[i] && nodes[i].level == level)
+							ix.push_back(i);
+					auto eval_range = [this, &ix](size_t i0, size_t n) {
+						for (size_t j = i0; j < i0 + n; ++j)
+							placeholder[ix[j]]->rep.v = built[ix[j]]->values();
+					};
+					size_t n_threads = std::max(2u, thread::hardware_concurrency());
+					size_t ps = 1 + ix.size() / n_threads;
+					vector<future<void>> calcs;
+					for (size_t p = 0; p < ix.size();) {
+						size_t np = p + ps <= ix.size() ? ps : ix.size() - p;
+						calcs.push_back(std::async(std::launch::async, eval_range, p, np));
+						p += np;
+					}
+					for (auto& f : calcs) f.get();
+				}
+				return r;
+			}
+		};
+
+		std::vector<apoint_ts> evaluate_common_subexpressions(const std::vector<apoint_ts>& tsv) {
+			for (const auto& ats : tsv)
+				if (ats.needs_bind())
+					return tsv;
+			return ts_cse_dag().evaluate(tsv);
+		}
+
+		std::vector<apoint_ts> evaluate_common_subexpressions(const ats_vector& tsv) {
+			return evaluate_common_subexpressions(static_cast<const std::vector<apoint_ts>&>(tsv));
+		}
+
 		std::vector<apoint_ts> percentiles(const std::vector<apoint_ts>& tsv1, const gta_t& ta, const vector<int>& percentile_list) {
 			std::vector<apoint_ts> r; r.reserve(percentile_list.size());
 			auto tsvx = deflate_ts_vector<gts_t>(tsv1);
@@ -586,33 +858,9 @@ namespace shyft{
 
 		std::vector<double> abin_op_scalar_ts::values() const {
 			bind_check();
-			const vector<double> *rhs_v{ terminal_values(rhs) };
-			if (rhs_v) {
-				const auto& r_v = *rhs_v;
-				std::vector<double> r; r.reserve(r_v.size());
-				auto l = lhs;
-				switch (op) {
-				case OP_ADD:for (const auto&v : r_v) r.emplace_back(v + l); return r;
-				case OP_SUB:for (const auto&v : r_v) r.emplace_back(l - v); return r;
-				case OP_MUL:for (const auto&v : r_v) r.emplace_back(l*v); return r;
-				case OP_DIV:for (const auto&v : r_v) r.emplace_back(l / v); return r;
-				case OP_MAX:for (const auto&v : r_v) r.emplace_back(std::max(v, l)); return r;
-				case OP_MIN:for (const auto&v : r_v) r.emplace_back(std::min(v, l)); return r;
-				default: throw runtime_error("Unsupported operation " + to_string(int(op)));
-				}
-			} else {
-				std::vector<double> r(rhs.values());
-				auto l = lhs;
-				switch (op) {
-				case OP_ADD:for (size_t i = 0; i < r.size(); ++i) r[i] += l; return r;
-				case OP_SUB:for (size_t i = 0; i < r.size(); ++i) r[i] = l - r[i]; return r;
-				case OP_MUL:for (size_t i = 0; i < r.size(); ++i) r[i] *= l; return r;
-				case OP_DIV:for (size_t i = 0; i < r.size(); ++i) r[i] = l / r[i]; return r;
-				case OP_MAX:for (size_t i = 0; i < r.size(); ++i) r[i] = std::max(r[i], l); return r;
-				case OP_MIN:for (size_t i = 0; i < r.size(); ++i) r[i] = std::min(r[i], l); return r;
-				default: throw runtime_error("Unsupported operation " + to_string(int(op)));
-				}
-			}
+			fused_program p(rhs.size());
+			p.compile_op(this);
+			return p.run();
 		}
 
 		double abin_op_ts_scalar::value_at(utctime t) const {
@@ -625,32 +873,9 @@ namespace shyft{
 		}
 		std::vector<double> abin_op_ts_scalar::values() const {
 			bind_check();
-			const vector<double>* lhs_v{ terminal_values(lhs) };
-			if (lhs_v) { // avoid a copy, but does not help much..
-				std::vector<double> r; r.reserve(lhs_v->size());
-				auto rv = rhs;
-				switch (op) {
-				case OP_ADD:for (const auto&lv : *lhs_v) r.emplace_back(lv + rv); return r;
-				case OP_SUB:for (const auto&lv : *lhs_v) r.emplace_back(lv - rv); return r;
-				case OP_MUL:for (const auto&lv : *lhs_v) r.emplace_back(lv*rv); return r;
-				case OP_DIV:for (const auto&lv : *lhs_v) r.emplace_back(lv / rv); return r;
-				case OP_MAX:for (const auto&lv : *lhs_v) r.emplace_back(std::max(lv, rv)); return r;
-				case OP_MIN:for (const auto&lv : *lhs_v) r.emplace_back(std::min(lv, rv)); return r;
-				default: throw runtime_error("Unsupported operation " + to_string(int(op)));
-				}
-			} else {
-				std::vector<double> l(lhs.values());
-				auto r = rhs;
-				switch (op) {
-				case OP_ADD:for (size_t i = 0; i < l.size(); ++i) l[i] += r; return l;
-				case OP_SUB:for (size_t i = 0; i < l.size(); ++i) l[i] -= r; return l;
-				case OP_MUL:for (size_t i = 0; i < l.size(); ++i) l[i] *= r; return l;
-				case OP_DIV:for (size_t i = 0; i < l.size(); ++i) l[i] /= r; return l;
-				case OP_MAX:for (size_t i = 0; i < l.size(); ++i) l[i] = std::max(l[i], r); return l;
-				case OP_MIN:for (size_t i = 0; i < l.size(); ++i) l[i] = std::min(l[i], r); return l;
-				default: throw runtime_error("Unsupported operation " + to_string(int(op)));
-				}
-			}
+			fused_program p(lhs.size());
+			p.compile_op(this);
+			return p.run();
 		}
 
 		apoint_ts time_shift(const apoint_ts& ts, utctimespan dt) {
@@ -776,12 +776,7 @@ namespace shyft {
             virtual utctime time(size_t i) const { return ts_impl.time(i); }
             virtual double value(size_t i) const { return ts_impl.value(i); }
             virtual double value_at(utctime t) const { return value(index_of(t)); }
-            virtual vector<double> values() const {
-                vector<double> r;r.reserve(size());
-                for (size_t i = 0;i<size();++i)
-                    r.push_back(ts_impl.value(i));
-                return r;
-            }
+            virtual vector<double> values() const { return ts_impl.values(); }
             virtual bool needs_bind() const { return ts_impl.needs_bind();}
             virtual void do_bind() {ts_impl.do_bind();}
             x_serialize_decl();
@@ -1147,6 +1142,10 @@ namespace shyft {
          * The \ref ts_point_fx is computed based on rhs,lhs. But can be overridden
          * by the user.
          *
+         * When lhs and rhs have equal time-axis, values() evaluates this node and all aligned
+         * bin-op nodes below it in one fused, cache-blocked pass, writing directly into the result,
+         * instead of materializing one vector for each node. Otherwise it falls back to value by value.
+         *
          */
         struct abin_op_ts:ipoint_ts {
 
@@ -1334,15 +1333,40 @@ namespace shyft {
             extend_ts_split_policy split_policy, extend_ts_fill_policy fill_policy,
             utctime split_at, double fill_value );
 
+        /** \brief common sub-expression elimination for a vector of expressions
+         *
+         * Builds a DAG of the expressions by hash-consing the nodes (node type, operation/parameters,
+         * and identity of the children), so that equal sub-expressions, like average(a*b,ta) used in
+         * several of the expressions, are represented by one node.
+         * Each node that is used more than once is then evaluated exactly once (in parallel, bottom up),
+         * and referenced as a concrete point ts by the expressions using it.
+         *
+         * The bin-ops, abs, average, integral, accumulate and time_shift nodes are merged on structure,
+         * other node types are only merged if they are the same object.
+         *
+         * \note the passed expressions are not modified, the returned expressions are new nodes
+         *       sharing the terminals with the passed expressions.
+         * \param tsv vector of bound expressions, if any is unbound, a copy of tsv is returned
+         * \return equivalent expressions, where common sub-expressions are evaluated
+         */
+        std::vector<apoint_ts> evaluate_common_subexpressions(const std::vector<apoint_ts>& tsv);
+        std::vector<apoint_ts> evaluate_common_subexpressions(const ats_vector& tsv);
+
+        /** for any other ts-type than apoint_ts, there is nothing to share */
+        template <class TsV>
+        inline const TsV& evaluate_common_subexpressions(const TsV& tsv) { return tsv; }
+
         /** Given a vector of expressions, deflate(evaluate) the expressions and return the
          * equivalent concrete point-time-series of the expressions in the
          * preferred destination type Ts
          * Useful for the dtss,
-         * evaluates the expressions in parallell
+         * evaluates the expressions in parallell,
+         * common sub-expressions are evaluated only once, \ref evaluate_common_subexpressions
          */
         template <class Ts,class TsV>
         std::vector<Ts>
-        deflate_ts_vector(TsV &&tsv1) {
+        deflate_ts_vector(TsV &&tsv0) {
+            const auto& tsv1 = evaluate_common_subexpressions(tsv0);
             std::vector<Ts> tsv2(tsv1.size());
 
             auto deflate_range=[&tsv1,&tsv2](size_t i0,size_t n) {
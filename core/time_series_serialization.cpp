@@ -247,6 +247,8 @@ void shyft::dtss::cache_stats::serialize(Arcive& ar, const unsigned int file_ver
 		& core_nvp("point_count", point_count)
 		& core_nvp("fragment_count", fragment_count)
 		;
+	if (file_version > 0)
+		ar & core_nvp("byte_count", byte_count);
 }
 
 /* api time-series serialization (dyn-dispatch) */
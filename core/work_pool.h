@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <algorithm>
+
+namespace shyft {
+    namespace core {
+        using std::size_t;
+
+        /** \brief a persistent pool of threads for data-parallel loops, like the cell-layer of the region_model
+         *
+         * The threads are created once, and reused for each parallel_for,
+         * so that repeated short runs (calibration, one-step forecasts) do not pay for thread creation.
+         *
+         * parallel_for(n,n_workers,fx) splits [0..n> into one contiguous range pr. worker, the calling
+         * thread being one of them. Each worker takes chunks from the front of its own range,
+         * starting with a quarter of what is left, so chunks shrink as the range drains(guided scheduling).
+         * When its own range is empty, the worker steals the back half of the largest remaining range
+         * of the other workers. Thus workers with expensive items(e.g. cells with glacier, or a lot of snow)
+         * are relieved by the others, while the synchronization is pr. chunk, not pr. item.
+         *
+         * \note one parallel_for at a time, concurrent callers are serialized,
+         *       and nested calls from within fx are executed serially by the calling worker.
+         */
+        class work_pool {
+          public:
+            /** create the pool, with n_threads in addition to the calling thread */
+            explicit work_pool(size_t n_threads) {
+                for (size_t i = 0; i < n_threads; ++i)
+                    threads.emplace_back([this, i]() { thread_loop(i + 1); });
+            }
+            ~work_pool() {
+                {
+                    std::lock_guard<std::mutex> lock(mx);
+                    stop = true;
+                }
+                cv_work.notify_all();
+                for (auto& t : threads)
+                    t.join();
+            }
+            work_pool(const work_pool&) = delete;
+            work_pool& operator=(const work_pool&) = delete;
+
+            /** number of threads in the pool, the calling thread not included */
+            size_t size() const { return threads.size(); }
+
+            /** \brief call fx(i0,i1) for disjoint ranges covering [0..n>, using up to n_workers threads
+             *
+             * \param n the number of items
+             * \param n_workers max number of concurrent workers, including the calling thread, limited to size()+1
+             * \param fx callable as fx(size_t i0,size_t i1), processing items [i0..i1>
+             * \throw the first exception thrown by fx, after all workers are done. Remaining items are skipped.
+             */
+            template <class F>
+            void parallel_for(size_t n, size_t n_workers, F&& fx) {
+                if (n == 0)
+                    return;
+                n_workers = std::min(std::min(n_workers, threads.size() + 1), n);
+                if (n_workers <= 1 || is_worker()) {
+                    fx(size_t(0), n);
+                    return;
+                }
+                std::lock_guard<std::mutex> run_lock(run_mx);
+                std::unique_ptr<range[]> ranges(new range[n_workers]);
+                for (size_t w = 0; w < n_workers; ++w) {
+                    ranges[w].begin = n*w/n_workers;
+                    ranges[w].end = n*(w + 1)/n_workers;
+                }
+                std::atomic<bool> failed{false};
+                std::exception_ptr ex;
+                std::mutex ex_mx;
+                std::function<void(size_t)> worker = [&](size_t w) {
+                    size_t i0, i1;
+                    while (!failed.load(std::memory_order_relaxed) && take(ranges.get(), n_workers, w, i0, i1)) {
+                        try {
+                            fx(i0, i1);
+                        } catch (...) {
+                            std::lock_guard<std::mutex> lock(ex_mx);
+                            if (!ex)
+                                ex = std::current_exception();
+                            failed = true;
+                        }
+                    }
+                };
+                {
+                    std::lock_guard<std::mutex> lock(mx);
+                    job = &worker;
+                    job_workers = n_workers;
+                    pending = n_workers - 1;
+                    ++generation;
+                }
+                cv_work.notify_all();
+                is_worker() = true;
+                worker(0);
+                is_worker() = false;
+                {
+                    std::unique_lock<std::mutex> lock(mx);
+                    cv_done.wait(lock, [this]() { return pending == 0; });
+                    job = nullptr;
+                }
+                if (ex)
+                    std::rethrow_exception(ex);
+            }
+
+          private:
+            struct range {
+                std::mutex mx;
+                size_t begin{0};
+                size_t end{0};
+            };
+
+            std::vector<std::thread> threads;
+            std::mutex run_mx;///< serializes parallel_for
+            std::mutex mx;///< protects the job posting below
+            std::condition_variable cv_work;
+            std::condition_variable cv_done;
+            bool stop{false};
+            size_t generation{0};
+            const std::function<void(size_t)>* job{nullptr};
+            size_t job_workers{0};
+            size_t pending{0};
+
+            static bool& is_worker() {
+                static thread_local bool w = false;
+                return w;
+            }
+
+            /** take the next chunk from the own range, or steal half of the largest other range */
+            static bool take(range* ranges, size_t n_workers, size_t w, size_t& i0, size_t& i1) {
+                auto& own = ranges[w];
+                while (true) {
+                    {
+                        std::lock_guard<std::mutex> lock(own.mx);
+                        size_t rem = own.end - own.begin;
+                        if (rem) {
+                            i0 = own.begin;
+                            i1 = i0 + std::max<size_t>(1, rem/4);
+                            own.begin = i1;
+                            return true;
+                        }
+                    }
+                    size_t v = n_workers, v_rem = 0;
+                    for (size_t j = 0; j < n_workers; ++j) {
+                        if (j == w)
+                            continue;
+                        std::lock_guard<std::mutex> lock(ranges[j].mx);
+                        size_t rem = ranges[j].end - ranges[j].begin;
+                        if (rem > v_rem) {
+                            v = j;
+                            v_rem = rem;
+                        }
+                    }
+                    if (v == n_workers)
+                        return false;// all done, or being done
+                    size_t s0, s1;
+                    {
+                        std::lock_guard<std::mutex> lock(ranges[v].mx);
+                        size_t rem = ranges[v].end - ranges[v].begin;
+                        if (rem == 0)
+                            continue;// drained meanwhile, look again
+                        s1 = ranges[v].end;
+                        s0 = s1 - (rem + 1)/2;
+                        ranges[v].end = s0;
+                    }
+                    std::lock_guard<std::mutex> lock(own.mx);
+                    own.begin = s0;
+                    own.end = s1;
+                }
+            }
+
+            void thread_loop(size_t w) {
+                is_worker() = true;
+                size_t seen = 0;
+                while (true) {
+                    std::unique_lock<std::mutex> lock(mx);
+                    cv_work.wait(lock, [this, &seen]() { return stop || generation != seen; });
+                    if (stop)
+                        return;
+                    seen = generation;
+                    if (w >= job_workers)
+                        continue;// not needed for this job
+                    auto j = job;
+                    lock.unlock();
+                    (*j)(w);
+                    lock.lock();
+                    if (--pending == 0)
+                        cv_done.notify_all();
+                }
+            }
+        };
+    }
+}
@@ -35,8 +35,21 @@ PTGSKOptModel.create_full_model_clone = lambda self: create_full_model_clone(sel
 PTGSKOptModel.create_full_model_clone.__doc__ = create_full_model_clone.__doc__
 
 
+PTGSKOptFloatModel.cell_t = PTGSKCellOptFloat
+PTGSKOptFloatModel.parameter_t = PTGSKParameter
+PTGSKOptFloatModel.state_t = PTGSKState
+PTGSKOptFloatModel.state_with_id_t = PTGSKStateWithId
+PTGSKOptFloatModel.state = property(lambda self:PTGSKCellOptFloatStateHandler(self.get_cells()))
+PTGSKOptFloatModel.statistics = property(lambda self:PTGSKCellOptFloatStatistics(self.get_cells()))
+PTGSKOptFloatModel.full_model_t = PTGSKModel
+PTGSKModel.create_opt_float_model_clone = lambda self: create_opt_float_model_clone(self)
+PTGSKModel.create_opt_float_model_clone.__doc__ = create_opt_float_model_clone.__doc__
+PTGSKOptFloatModel.create_full_model_clone = lambda self: create_full_model_clone_from_float(self)
+PTGSKOptFloatModel.create_full_model_clone.__doc__ = create_full_model_clone_from_float.__doc__
+
 PTGSKCellAll.vector_t = PTGSKCellAllVector
 PTGSKCellOpt.vector_t = PTGSKCellOptVector
+PTGSKCellOptFloat.vector_t = PTGSKCellOptFloatVector
 PTGSKState.vector_t = PTGSKStateVector
 
 #decorate StateWithId for serialization support
@@ -207,6 +207,14 @@ class RegionModel(unittest.TestCase):
         sum_discharge_opt_value = opt_model.statistics.discharge_value(cids, 0)
         self.assertAlmostEqual(sum_discharge_opt_value, sum_discharge_value, 3)  # verify the opt_model clone gives same value
         self.assertGreaterEqual(sum_discharge_value, 130.0)
+        float_model = model2.create_opt_float_model_clone()  # single precision env and response series, same results within float precision
+        self.assertIsInstance(float_model, pt_gs_k.PTGSKOptFloatModel)
+        float_model.run_cells()
+        self.assertAlmostEqual(float_model.statistics.discharge_value(cids, 0), sum_discharge_value, 2)
+        full_model = float_model.create_full_model_clone()  # and back to a full model
+        self.assertIsInstance(full_model, pt_gs_k.PTGSKModel)
+        full_model.run_cells()
+        self.assertAlmostEqual(full_model.statistics.discharge_value(cids, 0), sum_discharge_value, 2)
         opt_model.region_env.temperature[0].ts.set(0, 23.2)  # verify that region-env is different (no aliasing, a true copy is required)
         self.assertFalse(abs(model.region_env.temperature[0].ts.value(0) - opt_model.region_env.temperature[0].ts.value(0)) > 0.5)
 
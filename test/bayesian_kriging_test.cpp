@@ -272,6 +272,82 @@ TEST_CASE("test_interpolation") {
 	}
 }
 
+TEST_CASE("test_chol_delete") {
+    // the downdated factor should equal the factor of K without the removed rows/columns
+    const arma::uword n = 7;
+    arma::mat K(n, n);
+    for (arma::uword i = 0; i < n; ++i)
+        for (arma::uword j = 0; j < n; ++j)
+            K.at(i, j) = std::exp(-std::fabs(double(i) - double(j))/3.0) + (i == j ? 0.5 : 0.0);
+    arma::mat R;
+    TS_ASSERT(arma::chol(R, K));
+    utils::chol_delete(R, 5);
+    utils::chol_delete(R, 2);
+    utils::chol_delete(R, 0);
+    std::vector<arma::uword> keep{1, 3, 4, 6};
+    arma::uvec idx(keep);
+    arma::mat K_r = K.submat(idx, idx);
+    arma::mat K_d = R.t()*R;
+    FAST_REQUIRE_EQ(R.n_rows, 4u);
+    for (arma::uword i = 0; i < 4; ++i) {
+        for (arma::uword j = 0; j < 4; ++j) {
+            TS_ASSERT_DELTA(K_d.at(i, j), K_r.at(i, j), 1e-12);
+            if (i > j) TS_ASSERT_DELTA(R.at(i, j), 0.0, 1e-15);
+        }
+    }
+}
+
+TEST_CASE("test_interpolation_missing_sources") {
+    // varying, and recurring, patterns of missing sources should give the same result as
+    // interpolating each time-step with only the valid sources
+    Parameter params;
+    SourceList sources;
+    DestinationList destinations;
+    using namespace shyft::time_series;
+    using namespace shyfttest;
+    const size_t n_s = 5;
+    const size_t n_d = 6;
+    const size_t n_times = 40;
+    const utctime dt = 3600;
+    vector<utctime> times;
+    for (size_t i = 0; i < n_times; ++i)
+        times.emplace_back(dt*i);
+    const time_axis::point_dt time_axis(times);
+    build_sources_and_dests(n_s, n_s, n_d, n_d, n_times, dt, time_axis, false, sources, destinations, true);
+    // punch holes in the sources, a few patterns of missing sources that recurs, and some with many missing
+    vector<utctime> s_times(times);
+    s_times.emplace_back(shyft::core::max_utctime);
+    time_axis::point_dt s_ta(s_times);
+    SourceList gappy;
+    for (size_t s = 0; s < sources.size(); ++s) {
+        vector<double> v;
+        for (size_t t = 0; t < n_times; ++t) {
+            double x = sources[s].temperatures().value(t) + 0.1*((s*7 + t*3)%11);
+            const size_t pattern = t%8;
+            bool missing = (pattern == 1 && s == 3) || (pattern == 2 && (s == 0 || s == 24)) || (pattern == 3 && s%2 == 1)
+                || (pattern == 5 && s > 4) || (pattern == 6 && s == 3) || (t == 37 && s == 12);
+            v.emplace_back(missing ? shyft::nan : x);
+        }
+        gappy.emplace_back(sources[s].mid_point(), xpts_t(s_ta, v));
+    }
+    typedef average_accessor<shyfttest::xpts_t, time_axis::point_dt> tsa_t;
+    btk_interpolation<tsa_t>(begin(gappy), end(gappy), begin(destinations), end(destinations), time_axis, params);
+    for (size_t t = 0; t < time_axis.size(); ++t) {
+        const time_axis::point_dt ta_t(vector<utctime>{times[t]}, times[t + 1]);
+        SourceList valid;
+        for (const auto& s : gappy) {
+            if (std::isfinite(tsa_t(s.temperatures(), ta_t).value(0)))
+                valid.emplace_back(s);
+        }
+        DestinationList expected;
+        for (const auto& d : destinations)
+            expected.emplace_back(d.mid_point(), ta_t);
+        btk_interpolation<tsa_t>(begin(valid), end(valid), begin(expected), end(expected), ta_t, params);
+        for (size_t i = 0; i < destinations.size(); ++i)
+            TS_ASSERT_DELTA(destinations[i].temperatures[t], expected[i].temperatures[0], 1e-8);
+    }
+}
+
 TEST_CASE("test_performance") {
     Parameter params;
     SourceList sources;
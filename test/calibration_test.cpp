@@ -295,6 +295,30 @@ namespace shyfttest {
 
 } //  shyfttest
 
+namespace shyft { namespace core { namespace model_calibration {
+    /** access to the internals of the optimizer, a friend of it */
+    class calibration_test {
+      public:
+        /** \return the goal function of p as evaluated by an optimization, with its calculation filter and step range */
+        template <class O, class PA>
+        static double optimization_goal_function(O& o, const PA& p, std::vector<int>& catchments, std::vector<int>& rivers, int& n_run_steps) {
+            typename O::optimization_scope scope(o);
+            o.prepare_optimize();
+            catchments = o.model.get_catchment_calculation_filter();
+            rivers = o.model.get_river_calculation_filter();
+            n_run_steps = o.n_run_steps;
+            o.p_expanded = o.p_vector(p);
+            return o.goal_function(o.reduce_p_vector(o.p_expanded));
+        }
+        /** call fx within the optimization scope of o */
+        template <class O, class F>
+        static void in_optimization_scope(O& o, F&& fx) {
+            typename O::optimization_scope scope(o);
+            fx();
+        }
+    };
+}}}
+
 TEST_SUITE("calibration") {
 TEST_CASE("test_dummy") {
     std::vector<double> target = {-5.0,1.0,1.0,1.0};
@@ -547,5 +571,131 @@ TEST_CASE("rmse_goal_function") {
 
 }
 
+TEST_CASE("optimizer_targets_subset") {
+    // targets that end before the end of the time-axis, and cover a subset of the catchments and rivers,
+    // are evaluated on that subset and step range only, the model filter is restored afterwards,
+    // and the model is left with the results of the optimized parameters for the whole time-axis
+    using namespace shyft::core::model_calibration;
+    typedef pt_gs_k::cell_discharge_response_t cell_t;
+    typedef geo_point_ts<catchment_t> gpts_t;
+    typedef region_environment<gpts_t, gpts_t, gpts_t, gpts_t, gpts_t> env_t;
+    typedef region_model<cell_t, env_t> model_t;
+    typedef target_specification<catchment_t> tspec_t;
+    calendar cal;
+    ta::fixed_dt time_axis(cal.time(2016, 1, 1), deltahours(3), 8*20);
+    ta::fixed_dt ta_src(time_axis.start(), time_axis.delta(), time_axis.size() + 1);
+    catchment_t temp(ta_src, 0.0), prec(ta_src, 0.0), rad(ta_src, 0.0), rhum(ta_src, 0.7), wind(ta_src, 2.0);
+    for (size_t i = 0; i < ta_src.size(); ++i) {
+        temp.set(i, 5.0*std::sin(0.05*i) + 3.0);
+        prec.set(i, (i/8)%4 == 0 ? 4.0 : 0.0);
+        rad.set(i, std::max(0.0, 200.0*std::sin(0.8*i)));
+    }
+    env_t env;
+    env.temperature = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{geo_point(0.0, 0.0, 100.0), temp}, gpts_t{geo_point(10000.0, 0.0, 800.0), temp}});
+    env.precipitation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{geo_point(0.0, 0.0, 100.0), prec}});
+    env.radiation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{geo_point(0.0, 0.0, 100.0), rad}});
+    env.rel_hum = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{geo_point(0.0, 0.0, 100.0), rhum}});
+    env.wind_speed = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{geo_point(0.0, 0.0, 100.0), wind}});
+    vector<geo_cell_data> gcd;
+    for (size_t i = 0; i < 30; ++i) {
+        gcd.emplace_back(geo_point(500.0*i, 500.0*(i%3), 100.0 + 30.0*i), 1000.0*1000.0, int(i%3));
+        gcd.back().routing.distance = 3*3600.0*(i%4);
+    }
+    pt_gs_k::parameter_t p;
+    model_t m(gcd, p);
+    routing::river_network rn;// 2 -> 1 <- 3
+    rn.add(routing::river(1, routing_info(0)));
+    rn.add(routing::river(2, routing_info(1, 7200.0)));
+    rn.add(routing::river(3, routing_info(1, 3600.0)));
+    m.river_network = rn;
+    m.connect_catchment_to_river(0, 2);
+    m.connect_catchment_to_river(1, 3);
+    m.connect_catchment_to_river(2, 1);
+    interpolation_parameter ip;
+    ip.use_idw_for_temperature = true;
+    m.run_interpolation(ip, time_axis, env);
+    m.run_cells();// the initial state is the state prior to this run
+
+    // the targets, catchment 0, and river 3, that is fed by catchment 1, for the first 100 steps
+    const size_t n_target = 100;
+    ta::fixed_dt ta_target(time_axis.start(), time_axis.delta(), n_target);
+    vector<catchment_t> q;
+    m.catchment_discharges(q);
+    auto q_r3 = *m.river_output_flow_m3s(3);
+    catchment_t t_c0(ta_target, 0.0, POINT_AVERAGE_VALUE), t_r3(ta_target, 0.0, POINT_AVERAGE_VALUE);
+    for (size_t i = 0; i < n_target; ++i) {
+        t_c0.set(i, q[m.cix_from_cid(0)].value(i));
+        t_r3.set(i, q_r3.value(i));
+    }
+    vector<tspec_t> targets{tspec_t(t_c0, vector<int>{0}, 1.0), tspec_t(t_r3, 3, 1.0)};
+    pt_gs_k::parameter_t lo = p, hi = p, p0 = p;
+    lo.kirchner.c1 = -4.0; hi.kirchner.c1 = -1.0; p0.kirchner.c1 = -3.0;
+    lo.kirchner.c2 = 0.5; hi.kirchner.c2 = 1.2; p0.kirchner.c2 = 0.8;
+    model_calibration::optimizer<model_t, pt_gs_k::parameter_t, catchment_t> o(m);
+    o.set_target_specification(targets, lo, hi);
+
+    // the goal function evaluated on the subset equals that of a full unfiltered run
+    vector<int> cf, rf;
+    int n_run_steps = 0;
+    double gf = calibration_test::optimization_goal_function(o, p0, cf, rf, n_run_steps);
+    FAST_CHECK_EQ(cf, vector<int>{0, 1});
+    FAST_CHECK_EQ(rf, vector<int>{3});
+    FAST_CHECK_EQ(n_run_steps, int(n_target));
+    FAST_CHECK_EQ(m.get_catchment_calculation_filter().size(), 0u);
+    FAST_CHECK_EQ(m.get_river_calculation_filter().size(), 0u);
+    FAST_CHECK_GT(gf, 0.0);
+    FAST_CHECK_EQ(o.calculate_goal_function(p0), doctest::Approx(gf).epsilon(1e-10));
+    o.set_target_specification(vector<tspec_t>{targets[0]}, lo, hi);// no routed targets, so no rivers are routed by the runs
+    calibration_test::optimization_goal_function(o, p0, cf, rf, n_run_steps);
+    FAST_CHECK_EQ(cf, vector<int>{0});
+    FAST_CHECK_EQ(rf.size(), 0u);
+    o.set_target_specification(targets, lo, hi);
+
+    // the filter can not be restored if the river is removed meanwhile, then it is cleared
+    m.set_calculation_filter(vector<int>{}, vector<int>{3});
+    calibration_test::in_optimization_scope(o, [&m]() { m.river_network.remove_by_id(3); });
+    FAST_CHECK_EQ(m.get_catchment_calculation_filter().size(), 0u);
+    FAST_CHECK_EQ(m.get_river_calculation_filter().size(), 0u);
+    m.river_network = rn;
+
+    // the optimizers restore the filter, and run the model with the result over the whole time-axis
+    auto check_optimized = [&](const pt_gs_k::parameter_t& r) {
+        FAST_CHECK_EQ(m.get_catchment_calculation_filter().size(), 0u);
+        FAST_CHECK_EQ(m.get_river_calculation_filter().size(), 0u);
+        vector<catchment_t> q_opt;
+        m.catchment_discharges(q_opt);
+        auto q_opt_r3 = *m.river_output_flow_m3s(3);
+        o.calculate_goal_function(r);// a full run with r
+        vector<catchment_t> q_ref;
+        m.catchment_discharges(q_ref);
+        auto q_ref_r3 = *m.river_output_flow_m3s(3);
+        for (size_t i = 0; i < time_axis.size(); ++i) {
+            FAST_CHECK_EQ(q_opt[m.cix_from_cid(0)].value(i), doctest::Approx(q_ref[m.cix_from_cid(0)].value(i)));
+            FAST_CHECK_EQ(q_opt_r3.value(i), doctest::Approx(q_ref_r3.value(i)));
+        }
+    };
+    check_optimized(o.optimize(p0, 200, 0.1, 1e-5));
+    check_optimized(o.optimize_sceua(p0, 200, 0.0001, 1e-5));// dream does not stop on this small model, its throw paths are checked below
+    o.set_concurrent_evaluations(2);
+    check_optimized(o.optimize_sceua(p0, 200, 0.0001, 1e-5));
+    o.set_concurrent_evaluations(1);
+
+    // the filter is restored when the optimization throws
+    m.set_calculation_filter(vector<int>{2}, vector<int>{});
+    auto check_filter = [&m]() {
+        FAST_CHECK_EQ(m.get_catchment_calculation_filter(), vector<int>{2});
+        FAST_CHECK_EQ(m.get_river_calculation_filter().size(), 0u);
+    };
+    o.set_target_specification(vector<tspec_t>{targets[0], tspec_t(t_r3, 4, 1.0)}, lo, hi);// there is no river 4
+    CHECK_THROWS_AS(o.optimize(p0, 200, 0.1, 1e-5), runtime_error);
+    check_filter();
+    CHECK_THROWS_AS(o.optimize_sceua(p0, 200, 0.0001, 1e-5), runtime_error);
+    check_filter();
+    CHECK_THROWS_AS(o.optimize_dream(p0, 200), runtime_error);
+    check_filter();
+    o.set_target_specification(targets, p0, p0);// nothing to optimize, dream throws within the optimization
+    CHECK_THROWS_AS(o.optimize_dream(p0, 200), runtime_error);
+    check_filter();
+}
 
 }
@@ -3,6 +3,8 @@
 #include "core/dtss.h"
 #include "core/dtss_cache.h"
 #include "core/dtss_client.h"
+#include "core/dtss_wire.h"
+#include "core/core_archive.h"
 
 #include "core/utctime_utilities.h"
 #include "core/time_axis.h"
@@ -11,8 +13,10 @@
 
 
 #include <future>
+#include <atomic>
 #include <mutex>
 #include <regex>
+#include <sstream>
 #include <boost/filesystem.hpp>
 #include <cstdint>
 #ifdef _WIN32
@@ -208,6 +212,155 @@ TEST_CASE("dtss_ts_cache") {
     FAST_CHECK_EQ(s.id_count, 0);
 
 }
+TEST_CASE("dtss_sharded_cache") {
+    using std::vector;
+    using std::string;
+    using shyft::core::utctime;
+    using shyft::dtss::cache_stats;
+    using shyft::time_series::dd::apoint_ts;
+    using shyft::time_series::dd::gta_t;
+    using shyft::dtss::apoint_ts_frag;
+    using sharded_cache=shyft::dtss::sharded_cache<apoint_ts_frag,apoint_ts>;
+    const auto stair_case=shyft::time_series::POINT_AVERAGE_VALUE;
+
+    CHECK_THROWS_AS(sharded_cache(10,0),std::runtime_error);
+    sharded_cache c(1000,8);
+    FAST_CHECK_EQ(c.get_shard_count(),8);
+    FAST_CHECK_EQ(c.get_capacity(),1000);
+    c.set_capacity(1001);// not a multiple of the shard count
+    FAST_CHECK_EQ(c.get_capacity(),1001);
+    c.set_capacity(1000);
+    c.set_byte_capacity(1001);
+    FAST_CHECK_EQ(c.get_byte_capacity(),1001);
+    c.set_byte_capacity(0);
+    utctime t0{5};
+    utctimespan dt{1};
+    size_t n{3};
+    gta_t mta{t0,dt,n};
+    vector<string> ids;
+    vector<apoint_ts> tss;
+    size_t n_ts=50;
+    for(size_t i=0;i<n_ts;++i) {
+        ids.push_back("shyft://c/"+to_string(i));
+        tss.emplace_back(mta,double(i),stair_case);
+    }
+    c.add(ids,tss);
+    auto s=c.get_cache_stats();// stats are summed over shards
+    FAST_CHECK_EQ(s.id_count,n_ts);
+    FAST_CHECK_EQ(s.point_count,n_ts*n);
+    apoint_ts x;
+    FAST_REQUIRE_EQ(true,c.try_get(ids[7],mta.total_period(),x));
+    FAST_CHECK_EQ(x.value(0),7.0);
+    auto ids2=ids;ids2.push_back("not there");
+    auto mts=c.get(ids2,mta.total_period());
+    FAST_REQUIRE_EQ(n_ts,mts.size());
+    for(size_t i=0;i<n_ts;++i)
+        FAST_CHECK_EQ(mts[ids[i]].value(0),double(i));
+    s=c.get_cache_stats();
+    FAST_CHECK_EQ(s.hits,n_ts+1);
+    FAST_CHECK_EQ(s.misses,1);
+    c.remove(ids[7]);
+    FAST_CHECK_EQ(false,c.try_get(ids[7],mta.total_period(),x));
+    c.remove(ids2);
+    s=c.get_cache_stats();
+    FAST_CHECK_EQ(s.id_count,0);
+    c.clear_cache_stats();
+    s=c.get_cache_stats();
+    FAST_CHECK_EQ(s.hits,0);
+    FAST_CHECK_EQ(s.misses,0);
+}
+
+TEST_CASE("dtss_sharded_cache_speed") {
+    // concurrent clients hitting the cache, one shard(equal to single lock cache) vs. many shards
+    using std::vector;
+    using std::string;
+    using shyft::time_series::dd::apoint_ts;
+    using shyft::time_series::dd::gta_t;
+    using shyft::dtss::apoint_ts_frag;
+    using sharded_cache=shyft::dtss::sharded_cache<apoint_ts_frag,apoint_ts>;
+    const auto stair_case=shyft::time_series::POINT_AVERAGE_VALUE;
+    gta_t ta{0,3600,24};
+    size_t n_ts=1000;
+    vector<string> ids;
+    vector<apoint_ts> tss;
+    for(size_t i=0;i<n_ts;++i) {
+        ids.push_back("shyft://c/"+to_string(i));
+        tss.emplace_back(ta,double(i),stair_case);
+    }
+    size_t n_requests=2000;
+    size_t max_threads=std::max(2u,std::thread::hardware_concurrency());
+    for(size_t n_shards:{size_t(1),size_t(16)}) {
+        sharded_cache c(2*n_ts,n_shards);// headroom, since ids are not perfectly evenly hashed to shards
+        c.add(ids,tss);
+        for(size_t n_threads=1;n_threads<=max_threads;n_threads*=2) {
+            c.clear_cache_stats();
+            auto t0=timing::now();
+            vector<std::future<void>> clients;
+            for(size_t t=0;t<n_threads;++t) {
+                clients.emplace_back(std::async(std::launch::async,[&c,&ids,&ta,t,n_requests,n_ts]() {
+                    apoint_ts x;
+                    for(size_t r=0;r<n_requests;++r) {
+                        auto const& id=ids[(t*7919+r*31)%n_ts];
+                        if(!c.try_get(id,ta.total_period(),x))
+                            throw std::runtime_error("expected cache hit");
+                        if(r%16==0) c.add(id,x);// some writers as well
+                    }
+                }));
+            }
+            for(auto& f:clients) f.get();
+            auto us=double(elapsed_us(t0,timing::now()));
+            FAST_CHECK_EQ(c.get_cache_stats().hits,n_threads*n_requests);
+            if(getenv("SHYFT_VERBOSE"))
+                cout<<"shards="<<n_shards<<", threads="<<n_threads<<", mreq/s="<<double(n_threads*n_requests)/us<<"\n";
+        }
+    }
+}
+TEST_CASE("dtss_cache_byte_budget") {
+    using std::vector;
+    using std::string;
+    using shyft::time_series::dd::apoint_ts;
+    using shyft::time_series::dd::gta_t;
+    using shyft::dtss::apoint_ts_frag;
+    using shyft::dtss::cache_policy;
+    using dtss_cache=shyft::dtss::cache<apoint_ts_frag,apoint_ts>;
+    const auto stair_case=shyft::time_series::POINT_AVERAGE_VALUE;
+    apoint_ts small{gta_t{0,1,3},1.0,stair_case};// 3 points ~ 24 bytes
+    apoint_ts big{gta_t{0,1,20},2.0,stair_case};// 20 points ~ 160 bytes
+    apoint_ts x;
+    for(auto policy:{cache_policy::lru,cache_policy::gdsf}) {
+        dtss_cache c(100);
+        c.set_policy(policy);
+        FAST_CHECK_EQ(c.get_byte_capacity(),0);
+        c.add("s1",small);
+        c.add("big",big);
+        FAST_CHECK_EQ(c.get_cache_stats().byte_count,184);
+        c.set_byte_capacity(200);
+        c.add("s2",small);// 208 bytes, one must go
+        auto s=c.get_cache_stats();
+        FAST_CHECK_EQ(s.id_count,2);
+        FAST_CHECK_LE(s.byte_count,200);
+        FAST_CHECK_EQ(true,c.try_get("s2",small.total_period(),x));
+        if(policy==cache_policy::lru) {// lru evicts the oldest
+            FAST_CHECK_EQ(false,c.try_get("s1",small.total_period(),x));
+            FAST_CHECK_EQ(true,c.try_get("big",big.total_period(),x));
+            FAST_CHECK_EQ(c.get_cache_stats().byte_count,184);
+        } else {// gdsf evicts the large infrequent item
+            FAST_CHECK_EQ(true,c.try_get("s1",small.total_period(),x));
+            FAST_CHECK_EQ(false,c.try_get("big",big.total_period(),x));
+            FAST_CHECK_EQ(c.get_cache_stats().byte_count,48);
+        }
+        c.remove("s2");
+        FAST_CHECK_EQ(c.get_cache_stats().byte_count,policy==cache_policy::lru?160:24);
+        c.add("s3",apoint_ts{gta_t{10,1,3},1.0,stair_case});
+        c.add("s3",apoint_ts{gta_t{13,1,3},1.0,stair_case});// merge into 6 points, 48 bytes
+        c.set_capacity(1);// id-count eviction also by policy
+        s=c.get_cache_stats();
+        FAST_CHECK_EQ(s.id_count,1);
+        FAST_CHECK_EQ(s.byte_count,policy==cache_policy::lru?48:24);// lru keeps newest, gdsf keeps small hit s1
+        c.flush();
+        FAST_CHECK_EQ(c.get_cache_stats().byte_count,0);
+    }
+}
 TEST_CASE("dtss_mini_frag") {
     using std::vector;
     using std::string;
@@ -304,6 +457,57 @@ TEST_CASE("dtss_mini_frag") {
 
 }
 
+TEST_CASE("dtss_compact_wire") {
+    using namespace shyft::dtss;
+    using shyft::time_series::dd::ats_vector;
+    auto osl = std::make_shared<calendar>("Europe/Oslo");
+    ats_vector tsv;
+    tsv.push_back(apoint_ts(gta_t(0, 3600, 5), vector<double>{1, 2, 3, 4, 5}, time_series::POINT_AVERAGE_VALUE));
+    tsv.push_back(apoint_ts(gta_t(vector<utctime>{0, 10, 30}, 50), vector<double>{1, 2, 3}, time_series::POINT_INSTANT_VALUE));
+    tsv.push_back(apoint_ts(gta_t(osl, 0, deltahours(24), 3), 2.0, time_series::POINT_AVERAGE_VALUE));// archive fallback
+    tsv.push_back(apoint_ts());
+    tsv.push_back(apoint_ts(gta_t(), vector<double>{}, time_series::POINT_AVERAGE_VALUE));
+    for (int32_t wire_format : {0, wire::version}) {
+        std::ostringstream out;
+        wire::write_reply(tsv, wire_format, out);
+        std::istringstream in(out.str());
+        auto r = wire::read_reply(wire_format, in);
+        FAST_REQUIRE_EQ(r.size(), tsv.size());
+        for (size_t i = 0; i < tsv.size(); ++i) {
+            FAST_REQUIRE_EQ(bool(r[i].ts), bool(tsv[i].ts));
+            if (!tsv[i].ts) continue;
+            FAST_CHECK_UNARY(r[i].time_axis() == tsv[i].time_axis());
+            FAST_CHECK_EQ(r[i].point_interpretation(), tsv[i].point_interpretation());
+            FAST_CHECK_UNARY(r[i].values() == tsv[i].values());
+        }
+    }
+    std::istringstream bad(string("\x07\0\0\0", 4));// unsupported version
+    CHECK_THROWS_AS(wire::read_ts_vector(bad), std::runtime_error);
+    // truncated or corrupt streams throws, without allocating the claimed lengths
+    std::ostringstream out;
+    wire::write_ts_vector(tsv, out);
+    const string good = out.str();
+    for (size_t n : {size_t(2), size_t(11), good.size()/2, good.size() - 1}) {
+        std::istringstream truncated(good.substr(0, n));
+        CHECK_THROWS(wire::read_ts_vector(truncated));// the archive ts throws boost archive_exception
+    }
+    auto corrupt = [&good](size_t pos, int64_t n) {
+        string c = good;
+        std::memcpy(&c[pos], &n, sizeof(n));
+        std::istringstream in(c);
+        return wire::read_ts_vector(in);
+    };
+    const size_t n_ts_pos = sizeof(int32_t);
+    const size_t n_v_pos = n_ts_pos + sizeof(int64_t) + 3 + 3*sizeof(int64_t);// of the first, fixed, ts
+    const size_t n_t_pos = n_v_pos + sizeof(int64_t) + 5*sizeof(double) + 3;// of the second, point, ts
+    CHECK_THROWS_AS(corrupt(n_ts_pos, -1), std::runtime_error);
+    CHECK_THROWS_AS(corrupt(n_ts_pos, std::numeric_limits<int64_t>::max()), std::runtime_error);
+    CHECK_THROWS_AS(corrupt(n_v_pos, std::numeric_limits<int64_t>::max()/16), std::runtime_error);
+    CHECK_THROWS_AS(corrupt(n_t_pos, std::numeric_limits<int64_t>::max()/16), std::runtime_error);
+    FAST_CHECK_EQ(corrupt(n_v_pos, 5).size(), tsv.size());// the right positions
+    FAST_CHECK_EQ(corrupt(n_t_pos, 3).size(), tsv.size());
+}
+
 TEST_CASE("dlib_server_basics") {
     dlog.set_level(dlib::LALL);
     dlib::set_all_logging_output_streams(std::cout);
@@ -407,6 +611,184 @@ TEST_CASE("dlib_server_basics") {
     dlog << dlib::LINFO << "done";
 }
 
+TEST_CASE("dtss_pipelined") {
+    using namespace shyft::dtss;
+    calendar utc;
+    auto t = utc.time(2016, 1, 1);
+    auto dt = deltahours(1);
+    int n = 240;
+    time_axis::fixed_dt ta(t, dt, n);
+    std::atomic<int> n_calls{0};
+    read_call_back_t cb = [ta,&n_calls](id_vector_t ts_ids, core::utcperiod p)->ts_vector_t {
+        ++n_calls;
+        ts_vector_t r; r.reserve(ts_ids.size());
+        for (size_t i = 0; i < ts_ids.size(); ++i) {
+            if (ts_ids[i] == "fail://x")
+                throw std::runtime_error("test exception");
+            r.emplace_back(ta, double(std::stoi(ts_ids[i].substr(7))));// "test://<value>"
+        }
+        return r;
+    };
+    server our_server(cb);
+    our_server.pipeline_workers = 4;
+    our_server.set_listening_ip("127.0.0.1");
+    int port_no = 20000;
+    our_server.set_listening_port(port_no);
+    our_server.start_async();
+    {
+        client dtss(string("localhost:") + to_string(port_no));
+        size_t n_rq = 50;
+        vector<ts_vector_t> rqs;
+        for (size_t i = 0; i < n_rq; ++i) {
+            ts_vector_t tsv;
+            tsv.push_back(2.0*apoint_ts(string("test://") + to_string(i)));
+            tsv.push_back(apoint_ts(string("test://") + to_string(i+1))+1.0);
+            rqs.push_back(tsv);
+        }
+        auto r = dtss.evaluate_pipelined(rqs, ta.total_period(), false, false);
+        FAST_REQUIRE_EQ(r.size(), n_rq);
+        for (size_t i = 0; i < n_rq; ++i) {// replies arrive out of order, but are returned by position
+            FAST_REQUIRE_EQ(r[i].size(), 2);
+            FAST_CHECK_EQ(r[i][0].value(0), doctest::Approx(2.0*i));
+            FAST_CHECK_EQ(r[i][1].value(n-1), doctest::Approx(i+2.0));
+        }
+        FAST_CHECK_EQ(n_calls.load(), int(n_rq));
+        // one failing request is reported, and the connection remains usable
+        ts_vector_t bad; bad.push_back(apoint_ts(string("fail://x")));
+        rqs[n_rq/2] = bad;
+        CHECK_THROWS_AS(dtss.evaluate_pipelined(rqs, ta.total_period(), false, false), std::runtime_error);
+        auto r2 = dtss.evaluate(rqs[0], ta.total_period(), false, false);// mix with plain requests
+        FAST_CHECK_EQ(r2[0].value(0), doctest::Approx(0.0));
+        FAST_CHECK_EQ(dtss.evaluate_pipelined(vector<ts_vector_t>{}, ta.total_period(), false, false).size(), 0);
+        dtss.close();
+    }
+    our_server.clear();
+}
+
+TEST_CASE("dtss_pipelined_in_memory") {
+    // drives the server connection handler with in-memory streams, pipelined and plain requests mixed
+    using namespace shyft::dtss;
+    time_axis::generic_dt ta(0, deltahours(1), 24);
+    read_call_back_t cb = [ta](id_vector_t ts_ids, core::utcperiod p)->ts_vector_t {
+        ts_vector_t r;
+        for (const auto& id : ts_ids) {
+            if (id == "fail://x")
+                throw std::runtime_error("test exception");
+            r.emplace_back(ta, double(std::stoi(id.substr(7))), time_series::POINT_AVERAGE_VALUE);// "test://<value>"
+        }
+        return r;
+    };
+    server our_server(cb);
+    our_server.pipeline_workers = 4;
+    int n_rq = 20;
+    int i_fail = 7;
+    auto evaluate_rq = [&ta](const string& id) {
+        std::ostringstream rq;
+        ts_vector_t tsv; tsv.push_back(2.0*apoint_ts(id));
+        msg::write_type(message_type::EVALUATE_TS_VECTOR, rq);
+        core_oarchive oa(rq, core_arch_flags);
+        oa << ta.total_period() << tsv << false << false;
+        return rq.str();
+    };
+    std::ostringstream rqs;
+    for (int i = 0; i < n_rq; ++i) {
+        msg::write_pipelined(int64_t(i), evaluate_rq(i == i_fail ? string("fail://x") : string("test://") + to_string(i)), rqs);
+        if (i == n_rq/2)
+            rqs << evaluate_rq("test://100");// a plain request, while pipelined requests are in flight
+    }
+    msg::write_type(message_type::CACHE_STATS, rqs);
+    std::istringstream in(rqs.str());
+    std::ostringstream out;
+    our_server.on_connect(in, out, "", "", 0, 0, 0);// returns when all replies are written
+
+    std::istringstream rps(out.str());
+    int n_ok = 0, n_fail = 0, n_plain = 0;
+    vector<char> seen(n_rq, 0);
+    while (rps.peek() != EOF) {
+        auto msg_type = msg::read_type(rps);
+        if (msg_type == message_type::EVALUATE_TS_VECTOR) {// plain replies are complete frames, not interleaved with pipelined
+            ts_vector_t r;
+            core_iarchive ia(rps, core_arch_flags);
+            ia >> r;
+            FAST_CHECK_EQ(r[0].value(0), doctest::Approx(200.0));
+            ++n_plain;
+        } else if (msg_type == message_type::CACHE_STATS) {
+            cache_stats cs;
+            core_iarchive ia(rps, core_arch_flags);
+            ia >> cs;
+            ++n_plain;
+        } else {
+            FAST_REQUIRE_EQ(int(msg_type), int(message_type::PIPELINED));
+            int64_t request_id;
+            std::istringstream rp(msg::read_pipelined(request_id, rps));
+            FAST_REQUIRE_UNARY(request_id >= 0 && request_id < n_rq);
+            seen[request_id] = 1;
+            if (msg::read_type(rp) == message_type::SERVER_EXCEPTION) {
+                FAST_CHECK_EQ(request_id, i_fail);
+                ++n_fail;
+                continue;
+            }
+            ts_vector_t r;
+            core_iarchive ia(rp, core_arch_flags);
+            ia >> r;
+            FAST_CHECK_EQ(r[0].value(0), doctest::Approx(2.0*request_id));
+            ++n_ok;
+        }
+    }
+    FAST_CHECK_EQ(n_ok, n_rq - 1);
+    FAST_CHECK_EQ(n_fail, 1);
+    FAST_CHECK_EQ(n_plain, 2);
+    FAST_CHECK_EQ(std::count(begin(seen), end(seen), 1), n_rq);
+}
+
+TEST_CASE("dtss_chunked_evaluate") {
+    using namespace shyft::dtss;
+    calendar utc;
+    auto t = utc.time(2016, 1, 1);
+    auto dt = deltahours(1);
+    int n = 240;
+    time_axis::fixed_dt ta(t, dt, n);
+    read_call_back_t cb = [ta](id_vector_t ts_ids, core::utcperiod p)->ts_vector_t {
+        ts_vector_t r; r.reserve(ts_ids.size());
+        for (size_t i = 0; i < ts_ids.size(); ++i)
+            r.emplace_back(ta, double(std::stoi(ts_ids[i].substr(7))));// "test://<value>"
+        return r;
+    };
+    server our_server(cb);
+    our_server.set_listening_ip("127.0.0.1");
+    int port_no = 20000;
+    our_server.set_listening_port(port_no);
+    our_server.start_async();
+    {
+        client dtss(string("localhost:") + to_string(port_no));
+        size_t n_ts = 103;
+        ts_vector_t tsv;
+        for (size_t i = 0; i < n_ts; ++i)
+            tsv.push_back(3.0*apoint_ts(string("test://") + to_string(i)));
+        for (bool compress : {true, false}) {
+            dtss.compress_expressions = compress;
+            vector<size_t> chunk_starts;
+            ts_vector_t r(n_ts);
+            dtss.evaluate_chunked(tsv, ta.total_period(), false, false, 10,
+                [&r, &chunk_starts](size_t i0, const ts_vector_t& chunk) {
+                    chunk_starts.push_back(i0);
+                    for (size_t i = 0; i < chunk.size(); ++i)
+                        r[i0 + i] = chunk[i];
+                }
+            );
+            FAST_CHECK_EQ(chunk_starts.size(), 11);
+            for (size_t i = 0; i < n_ts; ++i)
+                FAST_CHECK_EQ(r[i].value(0), doctest::Approx(3.0*i));
+        }
+        ts_vector_t bad; bad.push_back(apoint_ts(string("test://x")));// stoi throws server side
+        CHECK_THROWS_AS(dtss.evaluate_chunked(bad, ta.total_period(), false, false, 10, [](size_t, const ts_vector_t&) {}), std::runtime_error);
+        auto r2 = dtss.evaluate(tsv, ta.total_period(), false, false);// connection still in sync
+        FAST_CHECK_EQ(r2.size(), n_ts);
+        dtss.close();
+    }
+    our_server.clear();
+}
+
 TEST_CASE("dlib_multi_server_basics") {
     dlog.set_level(dlib::LALL);
     dlib::set_all_logging_output_streams(std::cout);
@@ -695,6 +1077,91 @@ TEST_CASE("dtss_store_basics") {
             db.remove(fn);
         }
 
+        TEST_SECTION("store_compressed") {
+            ts_db zdb(tmpdir.string());
+            zdb.compress_values = true;
+            gts_t of(gta_t(fta), 10.0, time_series::ts_point_fx::POINT_AVERAGE_VALUE);
+            gts_t oc(gta_t(cta2), 10.0, time_series::ts_point_fx::POINT_AVERAGE_VALUE);
+            gts_t op(gta_t(pta), 10.0, time_series::ts_point_fx::POINT_INSTANT_VALUE);
+            for (std::size_t i = 0; i < n; ++i) {
+                of.set(i, double(i)); oc.set(i, i%3 ? shyft::nan : 2.0*i); op.set(i, std::sin(0.1*i));
+            }
+            std::size_t nz = 3*ts_db::compressed_block_n + 17;// several blocks, last one partial
+            gts_t oz(gta_t(t, dt, nz), shyft::nan, time_series::ts_point_fx::POINT_AVERAGE_VALUE);
+            for (std::size_t i = 0; i < nz; ++i)
+                if (i < 1000 || i > 5000) oz.set(i, std::round(10.0*std::sin(0.001*i))/10.0);
+            vector<pair<string, gts_t>> tss{ {"z/f.db",of},{"z/c.db",oc},{"z/p.db",op},{"z/z.db",oz} };
+            for (const auto& x : tss) {
+                zdb.save(x.first, x.second);
+                auto r = zdb.read(x.first, utcperiod{});
+                FAST_CHECK_EQ(r.point_interpretation(), x.second.point_interpretation());
+                FAST_CHECK_EQ(r.time_axis(), x.second.time_axis());
+                FAST_REQUIRE_EQ(r.v.size(), x.second.v.size());
+                for (std::size_t i = 0; i < r.v.size(); ++i) // bit-exact, including nan
+                    FAST_CHECK_EQ(0, std::memcmp(&r.v[i], &x.second.v[i], sizeof(double)));
+                // period read decompress only the needed blocks, and must equal a raw read
+                ts_db rdb(tmpdir.string());
+                rdb.save(x.first + ".raw", x.second);
+                std::size_t m = x.second.size();
+                utcperiod rp{ x.second.time(2) + dt/2, x.second.time(m - 3) + dt/2 };
+                auto r2 = zdb.read(x.first, rp);
+                auto e2 = rdb.read(x.first + ".raw", rp);
+                FAST_CHECK_EQ(r2.time_axis(), e2.time_axis());
+                FAST_CHECK_EQ(r2.v.size(), e2.v.size());
+                FAST_CHECK_EQ(0, std::memcmp(r2.v.data(), e2.v.data(), sizeof(double)*e2.v.size()));
+                if (x.first == "z/z.db") {
+                    FAST_CHECK_LT(fs::file_size(tmpdir/x.first)*4, fs::file_size(tmpdir/(x.first + ".raw")));
+                    utcperiod rp2{ x.second.time(nz - 20), x.second.time(nz - 1) };// in the last block only
+                    auto r3 = zdb.read(x.first, rp2);
+                    auto e3 = rdb.read(x.first + ".raw", rp2);
+                    FAST_CHECK_EQ(0, std::memcmp(r3.v.data(), e3.v.data(), sizeof(double)*e3.v.size()));
+                }
+                // merge write into compressed file, compare with the raw merge: tail, head, inside, gap after and gap before
+                auto mk_merge = [&x, dt](std::int64_t k, std::size_t len) {
+                    const auto& ta = x.second.ta;
+                    gta_t mta;
+                    if (ta.gt == gta_t::FIXED) {
+                        mta = gta_t(ta.f.t + k*ta.f.dt, ta.f.dt, len);
+                    } else if (ta.gt == gta_t::CALENDAR) {
+                        mta = gta_t(ta.c.cal, ta.c.cal->add(ta.c.t, ta.c.dt, k), ta.c.dt, len);
+                    } else {
+                        vector<utctime> tp;
+                        for (std::size_t i = 0; i < len; ++i)
+                            tp.push_back(ta.p.t.front() + (k + std::int64_t(i))*dt);
+                        mta = gta_t(tp, tp.back() + dt);
+                    }
+                    gts_t r(mta, 0.0, x.second.point_interpretation());
+                    for (std::size_t i = 0; i < len; ++i)
+                        r.set(i, 42.0 + i);
+                    return r;
+                };
+                const std::int64_t mi = std::int64_t(m);
+                for (auto km : vector<pair<std::int64_t, std::size_t>>{ {mi/2, m}, {-mi/3, m/2}, {mi/4, m/4}, {3*mi/2 + 5, 10}, {-mi/2 - 15, 10} }) {
+                    auto xm = mk_merge(km.first, km.second);
+                    zdb.save(x.first, xm, false);
+                    rdb.save(x.first + ".raw", xm, false);
+                    auto r4 = zdb.read(x.first, utcperiod{});
+                    auto e4 = rdb.read(x.first + ".raw", utcperiod{});
+                    FAST_CHECK_EQ(r4.time_axis(), e4.time_axis());
+                    FAST_REQUIRE_EQ(r4.v.size(), e4.v.size());
+                    FAST_CHECK_EQ(0, std::memcmp(r4.v.data(), e4.v.data(), sizeof(double)*e4.v.size()));
+                }
+                // raw files are readable by a compressing db, and merge turns them compressed
+                auto xm = mk_merge(mi/2, m);
+                rdb.save(x.first + ".raw2", rdb.read(x.first + ".raw", utcperiod{}));
+                rdb.save(x.first + ".raw2", xm, false);
+                zdb.save(x.first + ".raw", xm, false);
+                auto r5 = zdb.read(x.first + ".raw", utcperiod{});
+                auto e5 = rdb.read(x.first + ".raw2", utcperiod{});
+                FAST_CHECK_EQ(r5.time_axis(), e5.time_axis());
+                FAST_CHECK_EQ(0, std::memcmp(r5.v.data(), e5.v.data(), sizeof(double)*e5.v.size()));
+                FAST_CHECK_LT(fs::file_size(tmpdir/(x.first + ".raw")), fs::file_size(tmpdir/(x.first + ".raw2")));
+                zdb.remove(x.first);
+                rdb.remove(x.first + ".raw");
+                rdb.remove(x.first + ".raw2");
+            }
+        }
+
         TEST_SECTION("dtss_db_speed") {
 			int n_ts = 120;
 			vector<gts_t> tsv; tsv.reserve(n_ts);
@@ -739,6 +1206,99 @@ TEST_CASE("dtss_store_basics") {
         fs::remove_all(tmpdir);
 #endif
 
+}
+TEST_CASE("dtss_db_catalog") {
+    using namespace shyft::dtss;
+    using shyft::time_series::dd::gts_t;
+    auto tmpdir = (fs::temp_directory_path()/"ts.db.catalog.test");
+    fs::remove_all(tmpdir);
+    calendar utc;
+    utctime t = utc.time(2016, 1, 1);
+    utctimespan dt = deltahours(1);
+    size_t n = 24;
+    gts_t o(gta_t(t, dt, n), 1.0, time_series::ts_point_fx::POINT_AVERAGE_VALUE);
+    auto names=[](const vector<ts_info>& r) {
+        vector<string> x;
+        for (const auto& i : r) x.push_back(i.name);
+        sort(x.begin(), x.end());
+        return x;
+    };
+    FAST_CHECK_EQ(ts_db_catalog::literal_prefix("a/b/.*"), string(""));
+    FAST_CHECK_EQ(ts_db_catalog::literal_prefix("^a/b/.*"), string("a/b/"));
+    FAST_CHECK_EQ(ts_db_catalog::literal_prefix("^a/bc?/"), string("a/b"));
+    FAST_CHECK_EQ(ts_db_catalog::literal_prefix("^a/b|^c"), string(""));
+    {
+        ts_db db(tmpdir.string());
+        FAST_CHECK_EQ(db.find(".*").size(), 0u);
+        for (auto fn : {"a/1.db", "a/2.db", "b/1.db"})
+            db.save(fn, o);
+        FAST_CHECK_EQ(names(db.find("^a/")), vector<string>{"a/1.db", "a/2.db"});
+        FAST_CHECK_EQ(names(db.find("^A/")), vector<string>{"a/1.db", "a/2.db"});// same case-insensitive semantics as before
+        FAST_CHECK_EQ(names(db.find("1\\.db")), vector<string>{"a/1.db", "b/1.db"});
+        auto r = db.find("^b/1\\.db");
+        FAST_REQUIRE_EQ(r.size(), 1u);
+        FAST_CHECK_EQ(r[0].data_period, o.total_period());
+        FAST_CHECK_EQ(r[0].point_fx, o.point_interpretation());
+        // merge extends the data period in the catalog
+        gts_t e(gta_t(t + n*dt, dt, n), 2.0, time_series::ts_point_fx::POINT_AVERAGE_VALUE);
+        db.save("b/1.db", e, false);
+        r = db.find("^b/1\\.db");
+        FAST_REQUIRE_EQ(r.size(), 1u);
+        FAST_CHECK_EQ(r[0].data_period, utcperiod(t, t + 2*n*dt));
+        db.remove("a/2.db");
+        FAST_CHECK_EQ(names(db.find("^a/")), vector<string>{"a/1.db"});
+
+        // another instance on the same container loads the catalog, and they follow each others changes
+        ts_db db2(tmpdir.string());
+        FAST_CHECK_EQ(names(db2.find(".*")), vector<string>{"a/1.db", "b/1.db"});
+        db2.save("c/1.db", o);
+        FAST_CHECK_EQ(names(db.find("^c/")), vector<string>{"c/1.db"});
+        db.remove("c/1.db");
+        FAST_CHECK_EQ(db2.find("^c/").size(), 0u);
+
+        // a compaction by one instance replaces the catalog file, the appends of the other are not lost
+        db.rebuild_catalog();
+        db2.save("d/1.db", o);
+        FAST_CHECK_EQ(names(db.find("^d/")), vector<string>{"d/1.db"});
+        ts_db db3(tmpdir.string());
+        FAST_CHECK_EQ(names(db3.find(".*")), vector<string>{"a/1.db", "b/1.db", "d/1.db"});
+        db.remove("d/1.db");
+    }
+    { // files added bypassing ts_db are found after rebuild_catalog
+        ts_db db(tmpdir.string());
+        fs::copy_file(tmpdir/"a"/"1.db", tmpdir/"a"/"3.db");
+        FAST_CHECK_EQ(db.find("^a/").size(), 1u);
+        db.rebuild_catalog();
+        FAST_CHECK_EQ(names(db.find("^a/")), vector<string>{"a/1.db", "a/3.db"});
+        // a lost catalog is rebuilt
+        fs::remove(tmpdir/ts_db_catalog::file_name());
+        FAST_CHECK_EQ(names(db.find(".*")), vector<string>{"a/1.db", "a/3.db", "b/1.db"});
+    }
+    { // a partially written last record, e.g. from a crash, is ignored on load, and dropped by the next write
+        auto cfn = (tmpdir/ts_db_catalog::file_name()).string();
+        auto sz = fs::file_size(cfn);
+        std::FILE* fh = std::fopen(cfn.c_str(), "ab");
+        std::fwrite("\1\7", 1, 2, fh);
+        std::fclose(fh);
+        ts_db db(tmpdir.string());
+        FAST_CHECK_EQ(fs::file_size(cfn), sz + 2);// opening the container does not touch the catalog
+        FAST_CHECK_EQ(db.find(".*").size(), 3u);
+        db.save("e/1.db", o);
+        ts_db db2(tmpdir.string());
+        FAST_CHECK_EQ(names(db2.find(".*")), vector<string>{"a/1.db", "a/3.db", "b/1.db", "e/1.db"});
+    }
+#ifndef _WIN32
+    if (::geteuid() != 0) { // a read-only container is searched by a scan, kept in memory (root ignores the permissions)
+        fs::remove(tmpdir/ts_db_catalog::file_name());
+        fs::permissions(tmpdir, fs::owner_read | fs::owner_exe);
+        ts_db db(tmpdir.string());
+        FAST_CHECK_EQ(names(db.find(".*")), vector<string>{"a/1.db", "a/3.db", "b/1.db", "e/1.db"});
+        FAST_CHECK_EQ(names(db.find("^a/")), vector<string>{"a/1.db", "a/3.db"});
+        FAST_CHECK_UNARY(!fs::exists(tmpdir/ts_db_catalog::file_name()));
+        fs::permissions(tmpdir, fs::owner_all);
+    }
+#endif
+    fs::remove_all(tmpdir);
 }
 TEST_CASE("shyft_url") {
     using namespace shyft::dtss;
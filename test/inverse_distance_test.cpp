@@ -369,6 +369,63 @@ TEST_CASE("test_handling_different_sources_pr_timesteps") {
 	double expected_v = (v1 + v2) / (w1 + w2);
 	TS_ASSERT_EQUALS(count_if(begin(d), end(d), [expected_v](const MCell&d) { return fabs(d.v - expected_v) < 1e-7; }), nx*ny);
 }
+TEST_CASE("test_sparse_weights_equal_brute_force") {
+	// many sources, with nan values, max_distance smaller than the region, and more steps than one block:
+	// the result should be equal to a brute force evaluation over all sources for each step
+	typedef precipitation_model<PointTimeSerieSource, PointTimeSerieCell, Parameter, geo_point> precipitation_model_t;
+	ta::fixed_dt ta(3600L*24L*365L*44L, 3600L, 150);
+	vector<PointTimeSerieSource> s;
+	for (size_t i = 0; i < 60; ++i) {
+		point_ts<ta::fixed_dt> pts(ta, 0.0);
+		for (size_t t = 0; t < ta.size(); ++t)
+			pts.set(t, (t + i)%13 == 0 ? shyft::nan : 5.0 + std::sin(0.1*t + i));
+		s.emplace_back(geo_point(37.0*((i*7919)%467), 41.0*((i*104729)%421), 100.0 + 10.0*(i%50)), pts);
+	}
+	auto d = PointTimeSerieCell::make_cell_grid(ta, 18, 17);
+	for (size_t j = 0; j < d.size(); ++j)
+		d[j].gp.z = 50.0 + 7.0*(j%90);
+	Parameter p(5000.0, 5);
+	auto brute_force = [&](auto model, const PointTimeSerieCell& c, size_t t, bool source_based) {
+		typedef decltype(model) M;
+		vector<pair<double, size_t>> sw;
+		const double min_weight = 1.0/M::distance_measure(geo_point(0.0), geo_point(p.max_distance), p.distance_measure_factor, p.zscale);
+		for (size_t i = 0; i < s.size(); ++i) {
+			double w = std::min(1.0, 1.0/M::distance_measure(c.mid_point(), s[i].mid_point(), p.distance_measure_factor, p.zscale));
+			if (w >= min_weight) sw.emplace_back(w, i);
+		}
+		sort(begin(sw), end(sw), [](const pair<double, size_t>& a, const pair<double, size_t>& b) { return a.first > b.first; });
+		if (sw.size() > p.max_members) sw.resize(p.max_members);
+		typename M::scale_computer gc(p);
+		for (const auto& x : sw)
+			if (source_based && std::isfinite(s[x.second].value(t))) gc.add(s[x.second], t);
+		double scale = gc.compute(), swv = 0.0, sw_sum = 0.0;
+		for (const auto& x : sw) {
+			double v = s[x.second].value(t);
+			if (std::isfinite(v)) { swv += x.first*M::transform(v, scale, s[x.second], c); sw_sum += x.first; }
+		}
+		return swv/sw_sum;
+	};
+	run_interpolation<TestTemperatureModel_1>(begin(s), end(s), begin(d), end(d), idw_timeaxis<ta::fixed_dt>(ta), p,
+		[](PointTimeSerieCell& d, size_t ix, double v) { d.set_value(ix, v); });
+	size_t n_nan = 0;
+	for (const auto& c : d) {
+		for (size_t t = 0; t < ta.size(); ++t) {
+			double e = brute_force(TestTemperatureModel_1(), c, t, true);
+			if (std::isfinite(e)) TS_ASSERT_DELTA(c.pts.value(t), e, 1e-9);
+			else { TS_ASSERT(!std::isfinite(c.pts.value(t))); ++n_nan; }
+		}
+	}
+	TS_ASSERT(n_nan < d.size()*ta.size()/2);// most cells have sources within reach
+	run_interpolation<precipitation_model_t>(begin(s), end(s), begin(d), end(d), idw_timeaxis<ta::fixed_dt>(ta), p,
+		[](PointTimeSerieCell& d, size_t ix, double v) { d.set_value(ix, v); });
+	for (const auto& c : d) {
+		for (size_t t = 0; t < ta.size(); ++t) {
+			double e = brute_force(precipitation_model_t(), c, t, false);
+			if (std::isfinite(e)) TS_ASSERT_DELTA(c.pts.value(t), e, 1e-9);
+			else TS_ASSERT(!std::isfinite(c.pts.value(t)));
+		}
+	}
+}
 TEST_CASE("interpolation_ts_nan_outside_defined_period") {
     using namespace shyft;
     utctime Tstart = calendar().time(2000, 1, 1);
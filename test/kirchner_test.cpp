@@ -2,12 +2,37 @@
 #include "mocks.h"
 #include "core/kirchner.h"
 
+using namespace shyft::core::kirchner;
+using namespace shyft::core;
+
 namespace shyfttest {
     const double EPS = 1.0e-6;
 
+    /** a year of synthetic hourly forcing, with dry spells, followed by heavy rain */
+    inline void kirchner_forcing(vector<double>& prec, vector<double>& evap) {
+        const size_t n = 24*365;
+        prec.resize(n);
+        evap.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            prec[i] = (i/24)%9 < 2 ? 1.0 + 4.0*std::fabs(std::sin(0.37*i)) : ((i/24)%31 == 7 ? 25.0 : 0.0);
+            evap[i] = std::max(0.0, 0.3*std::sin(2*3.1415926*(i%24)/24.0));
+        }
+    }
+    /** step the kirchner model through the forcing, \return elapsed ms */
+    inline double kirchner_run(const parameter& p, double abs_err, double rel_err, const vector<double>& prec, const vector<double>& evap, vector<double>& q_avg) {
+        calculator<kirchner::trapezoidal_average, parameter> k(abs_err, rel_err, p);
+        double q = 1.0;
+        q_avg.resize(prec.size());
+        const std::clock_t start = std::clock();
+        for (size_t i = 0; i < prec.size(); ++i)
+            k.step(0, deltahours(1), q, q_avg[i], prec[i], evap[i]);
+        return 1000.0*(std::clock() - start)/double(CLOCKS_PER_SEC);
+    }
+    /** catchment parameters from our test/demo regions */
+    inline vector<parameter> kirchner_catchments() {
+        return vector<parameter>{parameter{}, parameter{-2.810, 0.377, -0.050}, parameter{-2.55, 0.8, -0.01}, parameter{-3.5, 1.2, -0.15}};
+    }
 }
-using namespace shyft::core::kirchner;
-using namespace shyft::core;
 
 TEST_SUITE("kirchner") {
 TEST_CASE("test_single_solve") {
@@ -112,4 +137,71 @@ TEST_CASE("test_composite_average_loads") {
     }
 }
 
+
+TEST_CASE("test_fixed_step_solver") {
+    // accuracy of the fixed step solver, relative to a tight tolerance adaptive reference
+    using namespace shyft::core;
+    using namespace shyfttest;
+    { // steady state is kept
+        parameter p;
+        p.solver = fixed_step;
+        calculator<kirchner::trapezoidal_average, parameter> k(p);
+        double q = 3.0, q_avg = 0.0;
+        k.step(0, deltahours(3), q, q_avg, 3.5, 0.5);
+        FAST_CHECK_EQ(q, doctest::Approx(3.0));
+        FAST_CHECK_EQ(q_avg, doctest::Approx(3.0));
+    }
+    vector<double> prec, evap;
+    kirchner_forcing(prec, evap);
+    auto err = [](const vector<double>& x, const vector<double>& x_ref, double& max_rel, double& vol_rel) {
+        double v_ref = 0.0, v = 0.0;
+        max_rel = 0.0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            v_ref += x_ref[i];
+            v += x[i];
+            max_rel = std::max(max_rel, std::fabs(x[i] - x_ref[i])/std::max(x_ref[i], 0.01));
+        }
+        vol_rel = std::fabs(v - v_ref)/v_ref;
+    };
+    for (const auto& c : kirchner_catchments()) {
+        vector<double> q_ref, q_fixed, q_fixed_2;
+        kirchner_run(c, 1e-11, 1e-11, prec, evap, q_ref);
+        auto cf = c;
+        cf.solver = fixed_step;
+        kirchner_run(cf, 0, 0, prec, evap, q_fixed);// default steps_pr_hour
+        cf.steps_pr_hour = 2;
+        kirchner_run(cf, 0, 0, prec, evap, q_fixed_2);
+        double f_max, f_vol, f2_max, f2_vol;
+        err(q_fixed, q_ref, f_max, f_vol);
+        err(q_fixed_2, q_ref, f2_max, f2_vol);
+        FAST_CHECK_LT(f_max, 0.045);
+        FAST_CHECK_LT(f_vol, 0.001);
+        FAST_CHECK_LT(f2_max, 0.4);// worst case is the onset of heavy rain on a dry catchment
+        FAST_CHECK_LT(f2_vol, 0.002);
+    }
+}
+
+TEST_CASE("test_fixed_step_solver_speed") {
+    // speed of the solvers, stepping a year of hourly forcing
+    using namespace shyft::core;
+    using namespace shyfttest;
+    if (!getenv("SHYFT_FULL_TEST")) {
+        std::cout << "Please define SHYFT_FULL_TEST, export SHYFT_FULL_TEST=TRUE; to enable the kirchner solver speed test" << std::endl;
+        return;
+    }
+    vector<double> prec, evap;
+    kirchner_forcing(prec, evap);
+    for (const auto& c : kirchner_catchments()) {
+        vector<double> q_adaptive, q_fixed, q_fixed_2;
+        double ms_adaptive = kirchner_run(c, 1.0e-7, 1.0e-8, prec, evap, q_adaptive);
+        auto cf = c;
+        cf.solver = fixed_step;
+        double ms_fixed = kirchner_run(cf, 0, 0, prec, evap, q_fixed);
+        cf.steps_pr_hour = 2;
+        double ms_fixed_2 = kirchner_run(cf, 0, 0, prec, evap, q_fixed_2);
+        std::cout << "kirchner c1=" << c.c1 << ",c2=" << c.c2 << ",c3=" << c.c3
+                  << ": adaptive " << ms_adaptive << " ms, fixed_step " << ms_fixed << " ms, fixed_step(2 pr. hour) " << ms_fixed_2 << " ms" << std::endl;
+    }
+}
+
 }
@@ -225,5 +225,570 @@ TEST_CASE("test_region_vs_catchment_parameters") {
 
 
 }
+TEST_CASE("cell_arena") {
+    // a region model with arena env. cells, compared to the same model using the usual cells
+    using cell_t = pt_gs_k::cell_discharge_response_t;
+    using arena_cell_t = pt_gs_k::cell_arena_discharge_response_t;
+    typedef sc::geo_point_ts<pts_t> gpts_t;
+    typedef sc::region_environment<gpts_t, gpts_t, gpts_t, gpts_t, gpts_t> env_t;
+    sc::calendar cal;
+    ta_t ta(cal.time(2016, 1, 1), sc::deltahours(3), 8*30);
+    ta_t ta_src(ta.start(), ta.delta(), ta.size() + 1);// covering the last step of ta
+    pts_t temp(ta_src, 0.0), prec(ta_src, 0.0), rad(ta_src, 0.0), rhum(ta_src, 0.7), wind(ta_src, 2.0);
+    for (size_t i = 0; i < ta_src.size(); ++i) {
+        temp.set(i, 5.0*std::sin(0.05*i));
+        prec.set(i, (i/8)%4 == 0 ? 2.0 : 0.0);
+        rad.set(i, std::max(0.0, 200.0*std::sin(0.8*i)));
+    }
+    env_t env;
+    env.temperature = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), temp}, gpts_t{sc::geo_point(10000.0, 0.0, 800.0), temp}});
+    env.precipitation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), prec}});
+    env.radiation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rad}});
+    env.rel_hum = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rhum}});
+    env.wind_speed = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), wind}});
+
+    vector<sc::geo_cell_data> gcd;
+    for (size_t i = 0; i < 20; ++i)
+        gcd.emplace_back(sc::geo_point(500.0*i, 500.0*(i%3), 100.0 + 30.0*i), 1000.0*1000.0, int(i%2));
+    pt_gs_k::parameter_t p;
+    sc::region_model<cell_t, env_t> m(gcd, p);
+    sc::region_model<arena_cell_t, env_t> ma(gcd, p);
+    sc::interpolation_parameter ip;
+    ip.use_idw_for_temperature = true;
+    m.run_interpolation(ip, ta, env);
+    ma.run_interpolation(ip, ta, env);
+    auto& cells = *ma.get_cells();
+    const size_t n = ta.size();
+    for (size_t i = 1; i < cells.size(); ++i) { // one block pr. variable, adjacent rows
+        FAST_CHECK_EQ(cells[i].env_ts.temperature.data(), cells[i - 1].env_ts.temperature.data() + n);
+        FAST_CHECK_EQ(cells[i].env_ts.wind_speed.data(), cells[i - 1].env_ts.wind_speed.data() + n);
+        FAST_CHECK_EQ(cells[i].env_ts.temperature.get_arena(), cells[0].env_ts.rel_hum.get_arena());
+    }
+    auto arena = cells[0].env_ts.temperature.get_arena();
+    ma.run_interpolation(ip, ta, env); // same time-axis, reuses the arena
+    FAST_CHECK_EQ(cells[0].env_ts.temperature.get_arena(), arena);
+    m.run_cells();
+    ma.run_cells();
+    for (size_t c = 0; c < cells.size(); ++c) {
+        const auto& a = (*m.get_cells())[c];
+        const auto& b = cells[c];
+        for (size_t i = 0; i < n; ++i) {
+            FAST_CHECK_EQ(b.env_ts.temperature.value(i), doctest::Approx(a.env_ts.temperature.value(i)));
+            FAST_CHECK_EQ(b.env_ts.radiation.value(i), doctest::Approx(a.env_ts.radiation.value(i)));
+            FAST_CHECK_EQ(b.rc.avg_discharge.value(i), doctest::Approx(a.rc.avg_discharge.value(i)));
+        }
+    }
+    SUBCASE("copy_is_deep") {
+        sc::region_model<arena_cell_t, env_t> mc(ma);
+        auto& cc = (*mc.get_cells())[3];
+        FAST_CHECK_NE(cc.env_ts.temperature.data(), cells[3].env_ts.temperature.data());
+        cc.env_ts.temperature.set(0, 100.0);
+        FAST_CHECK_NE(cells[3].env_ts.temperature.value(0), doctest::Approx(100.0));
+        const auto& mcells = *mc.get_cells();// the copy has its own arena, with the same layout
+        auto ca = cc.env_ts.temperature.get_arena();
+        FAST_CHECK_NE(ca, arena);
+        for (size_t i = 1; i < mcells.size(); ++i) {
+            FAST_CHECK_EQ(mcells[i].env_ts.temperature.data(), mcells[i - 1].env_ts.temperature.data() + n);
+            FAST_CHECK_EQ(mcells[i].env_ts.wind_speed.get_arena(), ca);
+            FAST_CHECK_EQ(mcells[i].env_ts.rel_hum.value(5), cells[i].env_ts.rel_hum.value(5));
+        }
+        mc.run_interpolation(ip, ta, env);// and reuses it
+        FAST_CHECK_EQ(cc.env_ts.temperature.get_arena(), ca);
+        FAST_CHECK_EQ(cc.env_ts.temperature.value(0), doctest::Approx(cells[3].env_ts.temperature.value(0)));
+    }
+}
+
+TEST_CASE("float_cells") {
+    // a region model with single precision env. and response series, compared to the same model in double precision
+    using cell_t = pt_gs_k::cell_discharge_response_t;
+    using float_cell_t = pt_gs_k::cell_float_discharge_response_t;
+    typedef sc::geo_point_ts<pts_t> gpts_t;
+    typedef sc::region_environment<gpts_t, gpts_t, gpts_t, gpts_t, gpts_t> env_t;
+    sc::calendar cal;
+    ta_t ta(cal.time(2016, 1, 1), sc::deltahours(3), 8*30);
+    ta_t ta_src(ta.start(), ta.delta(), ta.size() + 1);// covering the last step of ta
+    pts_t temp(ta_src, 0.0), prec(ta_src, 0.0), rad(ta_src, 0.0), rhum(ta_src, 0.7), wind(ta_src, 2.0);
+    for (size_t i = 0; i < ta_src.size(); ++i) {
+        temp.set(i, 5.0*std::sin(0.05*i));
+        prec.set(i, (i/8)%4 == 0 ? 2.0 : 0.0);
+        rad.set(i, std::max(0.0, 200.0*std::sin(0.8*i)));
+    }
+    env_t env;
+    env.temperature = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), temp}, gpts_t{sc::geo_point(10000.0, 0.0, 800.0), temp}});
+    env.precipitation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), prec}});
+    env.radiation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rad}});
+    env.rel_hum = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rhum}});
+    env.wind_speed = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), wind}});
+
+    vector<sc::geo_cell_data> gcd;
+    for (size_t i = 0; i < 20; ++i)
+        gcd.emplace_back(sc::geo_point(500.0*i, 500.0*(i%3), 100.0 + 30.0*i), 1000.0*1000.0, int(i%2));
+    pt_gs_k::parameter_t p;
+    sc::region_model<cell_t, env_t> m(gcd, p);
+    sc::region_model<float_cell_t, env_t> mf(gcd, p);
+    sc::interpolation_parameter ip;
+    ip.use_idw_for_temperature = true;
+    m.run_interpolation(ip, ta, env);
+    mf.run_interpolation(ip, ta, env);
+    m.run_cells();
+    mf.run_cells();
+    const auto& cells = *mf.get_cells();
+    const size_t n = ta.size();
+    FAST_CHECK_EQ(cells[0].env_ts.temperature.v.size(), n);
+    FAST_CHECK_EQ(cells[0].rc.avg_discharge.v.size(), n);
+    for (size_t c = 0; c < cells.size(); ++c) {
+        const auto& a = (*m.get_cells())[c];
+        const auto& b = cells[c];
+        for (size_t i = 0; i < n; ++i) {
+            FAST_CHECK_EQ(b.env_ts.temperature.value(i), doctest::Approx(a.env_ts.temperature.value(i)).epsilon(1e-6));
+            FAST_CHECK_EQ(b.rc.avg_discharge.value(i), doctest::Approx(a.rc.avg_discharge.value(i)).epsilon(1e-4));
+        }
+    }
+    vector<pts_t> q, qf;
+    m.catchment_discharges(q);
+    mf.catchment_discharges(qf);
+    FAST_REQUIRE_EQ(qf.size(), q.size());
+    auto qf_sum = sc::cell_statistics::sum_catchment_feature(cells, vector<int>{}, [](const float_cell_t& c) { return c.rc.avg_discharge; });
+    for (size_t i = 0; i < n; ++i) {
+        FAST_CHECK_EQ(qf[0].value(i), doctest::Approx(q[0].value(i)).epsilon(1e-4));
+        FAST_CHECK_EQ(qf_sum->value(i), doctest::Approx(q[0].value(i) + q[1].value(i)).epsilon(1e-4));
+    }
 }
 
+TEST_CASE("interpolate_range") {
+    // interpolation of step ranges into the existing cell env. series equals the full interpolation
+    using cell_t = pt_gs_k::cell_discharge_response_t;
+    typedef sc::geo_point_ts<pts_t> gpts_t;
+    typedef sc::region_environment<gpts_t, gpts_t, gpts_t, gpts_t, gpts_t> env_t;
+    sc::calendar cal;
+    ta_t ta(cal.time(2016, 1, 1), sc::deltahours(3), 8*30);
+    ta_t ta_src(ta.start(), ta.delta(), ta.size() + 1);// covering the last step of ta
+    pts_t temp(ta_src, 0.0), temp_hi(ta_src, 0.0), prec(ta_src, 0.0), rad(ta_src, 0.0), rhum(ta_src, 0.7), wind(ta_src, 2.0);
+    for (size_t i = 0; i < ta_src.size(); ++i) {
+        temp.set(i, 5.0*std::sin(0.05*i));
+        temp_hi.set(i, 5.0*std::sin(0.05*i) - 4.0);
+        prec.set(i, (i/8)%4 == 0 ? 2.0 : 0.0);
+        rad.set(i, std::max(0.0, 200.0*std::sin(0.8*i)));
+    }
+    env_t env;
+    env.temperature = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), temp}, gpts_t{sc::geo_point(10000.0, 0.0, 800.0), temp_hi}});
+    env.precipitation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), prec}, gpts_t{sc::geo_point(8000.0, 2000.0, 600.0), prec}});
+    env.radiation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rad}});
+    env.rel_hum = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rhum}});
+    env.wind_speed = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), wind}});
+
+    vector<sc::geo_cell_data> gcd;
+    for (size_t i = 0; i < 20; ++i)
+        gcd.emplace_back(sc::geo_point(500.0*i, 500.0*(i%3), 100.0 + 30.0*i), 1000.0*1000.0, int(i%2));
+    pt_gs_k::parameter_t p;
+    sc::region_model<cell_t, env_t> m(gcd, p);
+    sc::region_model<cell_t, env_t> mr(gcd, p);
+    const size_t n = ta.size();
+    auto check_equal = [&](size_t i_begin) {
+        for (size_t c = 0; c < m.get_cells()->size(); ++c) {
+            const auto& a = (*m.get_cells())[c].env_ts;
+            const auto& b = (*mr.get_cells())[c].env_ts;
+            for (size_t i = i_begin; i < n; ++i) {
+                FAST_CHECK_EQ(b.temperature.value(i), doctest::Approx(a.temperature.value(i)));
+                FAST_CHECK_EQ(b.precipitation.value(i), doctest::Approx(a.precipitation.value(i)));
+                FAST_CHECK_EQ(b.radiation.value(i), doctest::Approx(a.radiation.value(i)));
+                FAST_CHECK_EQ(b.rel_hum.value(i), doctest::Approx(a.rel_hum.value(i)));
+                FAST_CHECK_EQ(b.wind_speed.value(i), doctest::Approx(a.wind_speed.value(i)));
+            }
+        }
+    };
+    for (bool use_idw : {true, false}) {
+        sc::interpolation_parameter ip;
+        ip.use_idw_for_temperature = use_idw;
+        m.run_interpolation(ip, ta, env);
+        mr.initialize_cell_environment(ta);
+        FAST_CHECK_UNARY(mr.interpolate_range(ip, env, 0, 100));
+        FAST_CHECK_UNARY(std::isnan((*mr.get_cells())[0].env_ts.temperature.value(100)));// not yet interpolated
+        FAST_CHECK_UNARY(mr.interpolate_range(ip, env, 100, 0));// to the end
+        check_equal(0);
+        // a rolling update: the source points change from 200, so the averages change from step 199(linear between points)
+        auto env_r = env;
+        env_r.temperature = make_shared<vector<gpts_t>>(*env.temperature);
+        for (auto& s : *env_r.temperature)
+            for (size_t i = 200; i < ta_src.size(); ++i)
+                s.ts.set(i, s.ts.value(i) + 3.0);
+        const double t198 = (*mr.get_cells())[3].env_ts.temperature.value(198);
+        FAST_CHECK_UNARY(mr.interpolate_range(ip, env_r, 199, n - 199));
+        m.run_interpolation(ip, ta, env_r);
+        check_equal(0);
+        FAST_CHECK_EQ((*mr.get_cells())[3].env_ts.temperature.value(198), doctest::Approx(t198));
+        CHECK_THROWS_AS(mr.interpolate_range(ip, env, n - 10, 20), std::runtime_error);
+    }
+}
+
+TEST_CASE("interpolation_cache") {
+    // repeated interpolation with the same locations reuses the weights/operators, and equals a fresh interpolation
+    using cell_t = pt_gs_k::cell_discharge_response_t;
+    typedef sc::geo_point_ts<pts_t> gpts_t;
+    typedef sc::region_environment<gpts_t, gpts_t, gpts_t, gpts_t, gpts_t> env_t;
+    sc::calendar cal;
+    ta_t ta(cal.time(2016, 1, 1), sc::deltahours(3), 8*10);
+    ta_t ta_src(ta.start(), ta.delta(), ta.size() + 1);
+    auto make_env = [&](double offset, double x_prec) {
+        pts_t temp(ta_src, 0.0), prec(ta_src, 0.0), rad(ta_src, 100.0), rhum(ta_src, 0.7), wind(ta_src, 2.0);
+        for (size_t i = 0; i < ta_src.size(); ++i) {
+            temp.set(i, offset + 5.0*std::sin(0.05*i));
+            prec.set(i, offset + ((i/8)%4 == 0 ? 2.0 : 0.0));
+        }
+        env_t env;
+        env.temperature = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), temp}, gpts_t{sc::geo_point(10000.0, 0.0, 800.0), temp}});
+        env.precipitation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(x_prec, 0.0, 100.0), prec}, gpts_t{sc::geo_point(6000.0, 1000.0, 400.0), prec}});
+        env.radiation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rad}});
+        env.rel_hum = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rhum}});
+        env.wind_speed = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), wind}});
+        return env;
+    };
+    vector<sc::geo_cell_data> gcd;
+    for (size_t i = 0; i < 20; ++i)
+        gcd.emplace_back(sc::geo_point(500.0*i, 500.0*(i%3), 100.0 + 30.0*i), 1000.0*1000.0, int(i%2));
+    pt_gs_k::parameter_t p;
+    sc::region_model<cell_t, env_t> m(gcd, p);
+    sc::interpolation_parameter ip;
+    auto check_fresh = [&](const env_t& env) {// compare to a model without kept weights
+        sc::region_model<cell_t, env_t> mf(gcd, p);
+        mf.run_interpolation(ip, ta, env);
+        for (size_t c = 0; c < gcd.size(); ++c) {
+            const auto& a = (*mf.get_cells())[c].env_ts;
+            const auto& b = (*m.get_cells())[c].env_ts;
+            for (size_t i = 0; i < ta.size(); ++i) {
+                FAST_CHECK_EQ(b.temperature.value(i), doctest::Approx(a.temperature.value(i)));
+                FAST_CHECK_EQ(b.precipitation.value(i), doctest::Approx(a.precipitation.value(i)));
+            }
+        }
+    };
+    m.run_interpolation(ip, ta, make_env(0.0, 0.0));
+    auto btk_op = m.ip_cache.temperature_btk.value;
+    auto prec_w = m.ip_cache.precipitation.value;
+    FAST_REQUIRE_UNARY(btk_op);
+    FAST_REQUIRE_UNARY(prec_w);
+    auto env = make_env(1.0, 0.0);// new data, same locations
+    m.run_interpolation(ip, ta, env);
+    FAST_CHECK_EQ(m.ip_cache.temperature_btk.value, btk_op);
+    FAST_CHECK_EQ(m.ip_cache.precipitation.value, prec_w);
+    check_fresh(env);
+    SUBCASE("source_moved") {
+        auto env_m = make_env(1.0, 2500.0);
+        m.run_interpolation(ip, ta, env_m);
+        FAST_CHECK_EQ(m.ip_cache.temperature_btk.value, btk_op);
+        FAST_CHECK_NE(m.ip_cache.precipitation.value, prec_w);
+        check_fresh(env_m);
+    }
+    SUBCASE("parameter_changed") {
+        ip.precipitation.max_distance = 5000.0;
+        ip.temperature = sc::btk::parameter(-0.6, 0.5);
+        m.run_interpolation(ip, ta, env);
+        FAST_CHECK_NE(m.ip_cache.temperature_btk.value, btk_op);
+        FAST_CHECK_NE(m.ip_cache.precipitation.value, prec_w);
+        check_fresh(env);
+        ip = sc::interpolation_parameter();
+    }
+    SUBCASE("cells_changed") {
+        auto g3 = gcd[3];
+        auto& c3 = (*m.get_cells())[3];
+        gcd[3] = sc::geo_cell_data(sc::geo_point(g3.mid_point().x, g3.mid_point().y, g3.mid_point().z + 200.0), g3.area(), int(g3.catchment_id()));
+        size_t cix = c3.geo.catchment_ix;
+        c3.geo = gcd[3];
+        c3.geo.catchment_ix = cix;
+        m.run_interpolation(ip, ta, env);
+        FAST_CHECK_NE(m.ip_cache.temperature_btk.value, btk_op);
+        check_fresh(env);
+        gcd[3] = g3;
+        c3.geo = g3;
+        c3.geo.catchment_ix = cix;
+    }
+    SUBCASE("clone_shares") {
+        sc::region_model<cell_t, env_t> mc(m);
+        FAST_CHECK_EQ(mc.ip_cache.precipitation.value, m.ip_cache.precipitation.value);
+    }
+}
+
+TEST_CASE("response_sums") {
+    // a region model with catchment sum cells, compared to the same model using the usual discharge cells
+    using cell_t = pt_gs_k::cell_discharge_response_t;
+    using sum_cell_t = pt_gs_k::cell_catchment_sum_response_t;
+    typedef sc::geo_point_ts<pts_t> gpts_t;
+    typedef sc::region_environment<gpts_t, gpts_t, gpts_t, gpts_t, gpts_t> env_t;
+    sc::calendar cal;
+    ta_t ta(cal.time(2016, 1, 1), sc::deltahours(3), 8*30);
+    ta_t ta_src(ta.start(), ta.delta(), ta.size() + 1);// covering the last step of ta
+    pts_t temp(ta_src, 0.0), prec(ta_src, 0.0), rad(ta_src, 0.0), rhum(ta_src, 0.7), wind(ta_src, 2.0);
+    for (size_t i = 0; i < ta_src.size(); ++i) {
+        temp.set(i, 5.0*std::sin(0.05*i));
+        prec.set(i, (i/8)%4 == 0 ? 2.0 : 0.0);
+        rad.set(i, std::max(0.0, 200.0*std::sin(0.8*i)));
+    }
+    env_t env;
+    env.temperature = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), temp}, gpts_t{sc::geo_point(10000.0, 0.0, 800.0), temp}});
+    env.precipitation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), prec}});
+    env.radiation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rad}});
+    env.rel_hum = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rhum}});
+    env.wind_speed = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), wind}});
+
+    vector<sc::geo_cell_data> gcd;
+    for (size_t i = 0; i < 30; ++i) {
+        gcd.emplace_back(sc::geo_point(500.0*i, 500.0*(i%3), 100.0 + 30.0*i), 1000.0*1000.0, int(i%3));
+        gcd.back().routing.distance = 3*3600.0*(i%4);// 4 distinct cell to river uhgs, 0..3 steps at 1 m/s
+    }
+    pt_gs_k::parameter_t p;
+    sc::region_model<cell_t, env_t> m(gcd, p);
+    sc::region_model<sum_cell_t, env_t> ms(gcd, p);
+    sc::routing::river_network rn;
+    rn.add(sc::routing::river(1, sc::routing_info(0)));
+    rn.add(sc::routing::river(2, sc::routing_info(1, 7200.0)));
+    m.river_network = rn;
+    ms.river_network = rn;
+    m.connect_catchment_to_river(0, 2);
+    m.connect_catchment_to_river(1, 1);// catchment 2 is not routed
+    ms.connect_catchment_to_river(0, 2);
+    ms.connect_catchment_to_river(1, 1);
+    sc::interpolation_parameter ip;
+    ip.use_idw_for_temperature = true;
+    m.run_interpolation(ip, ta, env);
+    ms.run_interpolation(ip, ta, env);
+    m.ncore = ms.ncore = 4;
+    auto check_equal = [&](const sc::region_model<sum_cell_t, env_t>& ms) {
+        vector<pts_t> q, qs, c, cs;
+        m.catchment_discharges(q);
+        ms.catchment_discharges(qs);
+        m.catchment_charges(c);
+        ms.catchment_charges(cs);
+        FAST_REQUIRE_EQ(qs.size(), q.size());
+        vector<pts_t> r{*m.river_output_flow_m3s(1), *m.river_local_inflow_m3s(2)};
+        vector<pts_t> rs{*ms.river_output_flow_m3s(1), *ms.river_local_inflow_m3s(2)};
+        for (size_t k = 0; k < q.size(); ++k) {
+            for (size_t i = 0; i < ta.size(); ++i) {
+                FAST_CHECK_EQ(qs[k].value(i), doctest::Approx(q[k].value(i)));
+                FAST_CHECK_EQ(cs[k].value(i), doctest::Approx(c[k].value(i)));
+            }
+        }
+        for (size_t k = 0; k < r.size(); ++k) {
+            for (size_t i = 0; i < ta.size(); ++i)
+                FAST_CHECK_EQ(rs[k].value(i), doctest::Approx(r[k].value(i)));
+        }
+    };
+    m.run_cells();
+    ms.run_cells();
+    FAST_CHECK_EQ(ms.get_cells()->front().rc.sums->n_slots, 3u + 2*4u);// 3 catchments, and 4 uhgs for each of the 2 routed catchments
+    check_equal(ms);
+    auto flows = ms.river_output_flows_m3s();
+    FAST_REQUIRE_EQ(flows.size(), 2u);
+    for (int rid : {1, 2}) {
+        auto q = m.river_output_flow_m3s(rid);
+        for (size_t i = 0; i < ta.size(); ++i)
+            FAST_CHECK_EQ(flows[rid].value(i), doctest::Approx(q->value(i)));
+    }
+    SUBCASE("partial_run") {
+        for (auto& s : m.initial_state) s.kirchner.q = 10.0;
+        for (auto& s : ms.initial_state) s.kirchner.q = 10.0;
+        m.revert_to_initial_state();
+        ms.revert_to_initial_state();
+        m.run_cells(0, 20, 50);
+        ms.run_cells(0, 20, 50);
+        check_equal(ms);
+    }
+    SUBCASE("catchment_filter") {// river 2 gets catchment 0 and 2, only catchment 0 is calculated
+        m.connect_catchment_to_river(2, 2);
+        ms.connect_catchment_to_river(2, 2);
+        m.run_cells();
+        ms.run_cells();
+        check_equal(ms);
+        for (auto& s : m.initial_state) s.kirchner.q = 10.0;
+        for (auto& s : ms.initial_state) s.kirchner.q = 10.0;
+        m.revert_to_initial_state();
+        ms.revert_to_initial_state();
+        m.set_catchment_calculation_filter(vector<int>{0});
+        ms.set_catchment_calculation_filter(vector<int>{0});
+        m.run_cells();
+        ms.run_cells();
+        m.set_catchment_calculation_filter(vector<int>{});// to compare all the catchment sums
+        ms.set_catchment_calculation_filter(vector<int>{});
+        check_equal(ms);
+    }
+    SUBCASE("clone_has_own_sums") {
+        sc::region_model<sum_cell_t, env_t> mc(ms);
+        m.revert_to_initial_state();
+        mc.revert_to_initial_state();
+        m.run_cells();
+        mc.run_cells();
+        FAST_CHECK_NE(mc.get_cells()->front().rc.sums, ms.get_cells()->front().rc.sums);
+        check_equal(mc);
+    }
+}
+
+TEST_CASE("run_routing") {
+    // the routed flows of the river filter are computed by run_cells, the others on request,
+    // and only the rivers that needs it are recomputed
+    using cell_t = pt_gs_k::cell_discharge_response_t;
+    typedef sc::geo_point_ts<pts_t> gpts_t;
+    typedef sc::region_environment<gpts_t, gpts_t, gpts_t, gpts_t, gpts_t> env_t;
+    sc::calendar cal;
+    ta_t ta(cal.time(2016, 1, 1), sc::deltahours(3), 8*20);
+    ta_t ta_src(ta.start(), ta.delta(), ta.size() + 1);
+    pts_t temp(ta_src, 0.0), prec(ta_src, 0.0), rad(ta_src, 0.0), rhum(ta_src, 0.7), wind(ta_src, 2.0);
+    for (size_t i = 0; i < ta_src.size(); ++i) {
+        temp.set(i, 5.0*std::sin(0.05*i));
+        prec.set(i, (i/8)%4 == 0 ? 2.0 : 0.0);
+        rad.set(i, std::max(0.0, 200.0*std::sin(0.8*i)));
+    }
+    env_t env;
+    env.temperature = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), temp}, gpts_t{sc::geo_point(10000.0, 0.0, 800.0), temp}});
+    env.precipitation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), prec}});
+    env.radiation = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rad}});
+    env.rel_hum = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), rhum}});
+    env.wind_speed = make_shared<vector<gpts_t>>(vector<gpts_t>{gpts_t{sc::geo_point(0.0, 0.0, 100.0), wind}});
+    vector<sc::geo_cell_data> gcd;
+    for (size_t i = 0; i < 30; ++i) {
+        gcd.emplace_back(sc::geo_point(500.0*i, 500.0*(i%3), 100.0 + 30.0*i), 1000.0*1000.0, int(i%3));
+        gcd.back().routing.distance = 3*3600.0*(i%4);
+    }
+    pt_gs_k::parameter_t p;
+    sc::region_model<cell_t, env_t> m(gcd, p);
+    sc::routing::river_network rn;// 2 -> 1 <- 3
+    rn.add(sc::routing::river(1, sc::routing_info(0)));
+    rn.add(sc::routing::river(2, sc::routing_info(1, 7200.0)));
+    rn.add(sc::routing::river(3, sc::routing_info(1, 3600.0)));
+    m.river_network = rn;
+    m.connect_catchment_to_river(0, 2);
+    m.connect_catchment_to_river(1, 3);
+    m.connect_catchment_to_river(2, 1);
+    sc::interpolation_parameter ip;
+    ip.use_idw_for_temperature = true;
+    m.run_interpolation(ip, ta, env);
+    m.ncore = 4;
+    auto fresh = [&m](int rid) {// computed from the cells, without the routed flows of the model
+        return sc::routing::model<cell_t>(m.river_network, m.get_cells(), m.time_axis).output_m3s(rid);
+    };
+    auto check_equal = [&ta](const pts_t& a, const pts_t& b) {
+        FAST_REQUIRE_EQ(a.size(), b.size());
+        for (size_t i = 0; i < ta.size(); ++i)
+            FAST_CHECK_EQ(a.value(i), doctest::Approx(b.value(i)));
+    };
+    m.run_cells();
+    for (auto& c : *m.get_cells())// without a river filter, nothing is routed by the run, so this is seen
+        c.rc.avg_discharge.scale_by(2.0);
+    for (int rid : {1, 2, 3})
+        check_equal(*m.river_output_flow_m3s(rid), fresh(rid));
+    auto flows = m.river_output_flows_m3s();
+    check_equal(flows[1], fresh(1));
+    vector<pts_t> rd;
+    m.routing_discharges(rd);
+    FAST_REQUIRE_EQ(rd.size(), 3u);
+    check_equal(rd[2], fresh(3));
+
+    SUBCASE("calculation_filter") {
+        // change the results of catchment 0 behind the back of the model, then run catchment 1 only:
+        // river 2 keeps the flow from the previous run, river 3 and the downstream river 1 are recomputed
+        auto q2 = *m.river_output_flow_m3s(2);
+        for (auto& c : *m.get_cells())
+            if (c.geo.catchment_id() == 0) c.rc.avg_discharge.scale_by(2.0);
+        for (auto& s : m.initial_state) s.kirchner.q = 5.0;
+        m.revert_to_initial_state();
+        m.set_calculation_filter(vector<int>{1}, vector<int>{});
+        m.run_cells();
+        check_equal(*m.river_output_flow_m3s(2), q2);
+        check_equal(*m.river_output_flow_m3s(3), fresh(3));
+        size_t i_max = 0;// river 1 is computed, on request, with the kept flow of river 2, there is no delay from 2 to 1
+        for (size_t i = 0; i < ta.size(); ++i)
+            if (q2.value(i) > q2.value(i_max)) i_max = i;
+        FAST_CHECK_EQ(fresh(1).value(i_max) - m.river_output_flows_m3s()[1].value(i_max), doctest::Approx(q2.value(i_max)));
+        m.set_calculation_filter(vector<int>{}, vector<int>{});
+        m.run_cells();
+        for (int rid : {1, 2, 3})
+            check_equal(*m.river_output_flow_m3s(rid), fresh(rid));
+    }
+    SUBCASE("river_filter") {
+        // only river 3 is routed, the downstream river 1 is left pending, with the flow of the previous run,
+        // that is not returned by the accessors, they compute it from the cells
+        for (auto& s : m.initial_state) s.kirchner.q = 5.0;
+        m.revert_to_initial_state();
+        m.set_calculation_filter(vector<int>{}, vector<int>{3});
+        FAST_CHECK_EQ(m.get_catchment_calculation_filter(), vector<int>{1});
+        FAST_CHECK_EQ(m.get_river_calculation_filter(), vector<int>{3});
+        m.run_cells();
+        check_equal(*m.river_output_flow_m3s(3), fresh(3));
+        check_equal(*m.river_output_flow_m3s(1), fresh(1));
+        auto q2 = fresh(2), q3 = fresh(3);
+        auto u1 = *m.river_upstream_inflow_m3s(1);
+        for (size_t i = 0; i < ta.size(); ++i)
+            FAST_CHECK_EQ(u1.value(i), doctest::Approx(q2.value(i) + q3.value(i)));
+        m.run_cells();// river 1 is still pending
+        check_equal(*m.river_output_flow_m3s(1), fresh(1));
+        auto flows = m.river_output_flows_m3s();// computes the pending rivers
+        for (int rid : {1, 2, 3})
+            check_equal(flows[rid], fresh(rid));
+        m.set_catchment_calculation_filter(vector<int>{});
+        FAST_CHECK_EQ(m.get_river_calculation_filter().size(), 0u);
+    }
+    SUBCASE("signature_changed") {
+        // routing changes after the run are detected by the accessors, and recomputed by the next run
+        m.river_network.river_by_id(2).parameter.velocity = 0.5;
+        check_equal(*m.river_output_flow_m3s(1), fresh(1));
+        m.connect_catchment_to_river(2, 3);
+        check_equal(*m.river_output_flow_m3s(3), fresh(3));
+        check_equal(m.river_output_flows_m3s()[1], fresh(1));
+        m.get_region_parameter().routing.velocity *= 2.0;
+        check_equal(*m.river_output_flow_m3s(3), fresh(3));
+        check_equal(m.river_output_flows_m3s()[1], fresh(1));
+        m.run_cells();
+        for (int rid : {1, 2, 3})
+            check_equal(*m.river_output_flow_m3s(rid), fresh(rid));
+        check_equal(*m.river_upstream_inflow_m3s(1), sc::routing::model<cell_t>(m.river_network, m.get_cells(), m.time_axis).upstream_inflow(1));
+        m.river_network = rn;
+        m.connect_catchment_to_river(2, 1);
+    }
+}
+
+TEST_CASE("work_pool") {
+    sc::work_pool pool(3);
+    FAST_CHECK_EQ(pool.size(), 3u);
+    const size_t n = 10000;
+    SUBCASE("each_item_once") {
+        vector<int> hits(n, 0);
+        for (size_t n_workers : {1u, 2u, 4u, 16u}) {// 16 is limited to pool.size()+1
+            pool.parallel_for(n, n_workers, [&hits](size_t i0, size_t i1) {
+                for (size_t i = i0; i < i1; ++i) ++hits[i];
+            });
+        }
+        FAST_CHECK_EQ(size_t(count(begin(hits), end(hits), 4)), n);
+        pool.parallel_for(0, 4, [](size_t, size_t) { FAST_CHECK_UNARY(false); });
+    }
+    SUBCASE("steal_expensive_items") {
+        // all the cost is in the range initially given to the calling thread,
+        // so the other workers have to steal from it
+        vector<std::thread::id> by(n);
+        pool.parallel_for(n, 4, [&by, n](size_t i0, size_t i1) {
+            for (size_t i = i0; i < i1; ++i) {
+                if (i < n/4 && i%100 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                by[i] = std::this_thread::get_id();
+            }
+        });
+        std::set<std::thread::id> workers(begin(by), begin(by) + n/4);
+        FAST_CHECK_GT(workers.size(), 1u);
+    }
+    SUBCASE("exception") {
+        CHECK_THROWS_AS(pool.parallel_for(n, 4, [n](size_t i0, size_t i1) {
+            if (i0 <= n/2 && n/2 < i1) throw runtime_error("item failed");
+        }), runtime_error);
+        size_t sum = 0;
+        std::mutex mx;
+        pool.parallel_for(n, 4, [&](size_t i0, size_t i1) {// still usable
+            std::lock_guard<std::mutex> lock(mx);
+            sum += i1 - i0;
+        });
+        FAST_CHECK_EQ(sum, n);
+    }
+    SUBCASE("nested_runs_serial") {
+        std::atomic<size_t> sum{0};
+        pool.parallel_for(4, 4, [&](size_t i0, size_t i1) {
+            for (size_t i = i0; i < i1; ++i)
+                pool.parallel_for(100, 4, [&](size_t j0, size_t j1) { sum += j1 - j0; });
+        });
+        FAST_CHECK_EQ(sum.load(), 400u);
+    }
+}
+}
@@ -170,6 +170,86 @@ TEST_CASE("test_routing_model") {
     //for(size_t i=0;i<observation_m3s.size();++i)
     //    TS_ASSERT_DELTA(observation_m3s.value(i),expected_m3s[i],0.001);
 
+    // verify against the flows computed step by step, downstream from the cells
+    auto conv = [&ta](const ts_t& x, const std::vector<double>& w) {
+        shyft::time_series::convolve_w_ts<ts_t> r(x, w, shyft::time_series::convolve_policy::USE_ZERO);
+        return ts_t(ta, routing::ts_values(r), shyft::time_series::POINT_AVERAGE_VALUE);
+    };
+    auto sum = [&ta](const ts_t& x, const ts_t& y) {
+        ts_t r(ta, 0.0, shyft::time_series::POINT_AVERAGE_VALUE);
+        for (size_t t = 0; t < ta.size(); ++t) r.set(t, x.value(t) + y.value(t));
+        return r;
+    };
+    auto cell_out = [&](const cell_t& c) { return conv(c.rc.avg_discharge, m.cell_uhg(c, ta.delta())); };
+    const auto dt = ta.delta();
+    ts_t q_a = conv(sum(cell_out((*cells)[0]), cell_out((*cells)[1])), a.uhg(dt));
+    ts_t q_b = conv(q_a, b.uhg(dt));
+    ts_t q_c = conv(cell_out((*cells)[2]), c.uhg(dt));
+    ts_t up_d = sum(q_b, q_c);
+    ts_t q_d = conv(up_d, d.uhg(dt));
+    std::vector<ts_t> expected{q_a, q_b, q_c, q_d};// ascending river id
+    auto check_equal = [&ta](const ts_t& x, const ts_t& y) {
+        FAST_REQUIRE_EQ(x.size(), y.size());
+        for (size_t t = 0; t < ta.size(); ++t)
+            TS_ASSERT_DELTA(x.value(t), y.value(t), 1e-9);
+    };
+    check_equal(m.output_m3s(d_id), q_d);
+    check_equal(m.upstream_inflow(d_id), up_d);
+    check_equal(m.output_m3s(b_id), q_b);
+    check_equal(m.local_inflow(b_id), ts_t(ta, 0.0, shyft::time_series::POINT_AVERAGE_VALUE));
+    auto all = m.all_output_m3s();
+    FAST_REQUIRE_EQ(all.size(), expected.size());
+    for (size_t i = 0; i < all.size(); ++i)
+        check_equal(all[i], expected[i]);
+    shyft::core::work_pool pool(3);
+    auto all_p = m.all_output_m3s(&pool, 4);
+    for (size_t i = 0; i < all_p.size(); ++i)
+        check_equal(all_p[i], expected[i]);
+}
 
+TEST_CASE("routing_large_network") {
+    // several basins, each a long chain of rivers with one cell each, and no delays,
+    // so that the output of a river is the sum of the upstream cells
+    using namespace shyft::core;
+    using ta_t = shyft::time_axis::fixed_dt;
+    using ts_t = shyft::time_series::point_ts<ta_t>;
+    using cell_t = routing::cell_node<ts_t>;
+    calendar utc;
+    ta_t ta(utc.time(2016, 1, 1), deltahours(1), 10);
+    const int n_basins = 4;
+    const int n_chain = 2000;// deep enough to hurt a recursive implementation
+    auto cells = std::make_shared<std::vector<cell_t>>();
+    auto rn = std::make_shared<routing::river_network>();
+    auto cp = std::make_shared<routing::cell_parameter>();
+    for (int b = 0; b < n_basins; ++b) {
+        for (int k = 0; k < n_chain; ++k) {
+            int rid = b*n_chain + k + 1;
+            // added directly, since river_network::add checks for cycles, that is slow for long chains
+            rn->rid_map[rid] = routing::river(rid, routing_info(k > 0 ? rid - 1 : 0, 0.0));
+            cell_t cx;
+            cx.parameter = cp;
+            cx.geo.routing.id = rid;
+            cx.rc.avg_discharge = ts_t(ta, double(b + 1), shyft::time_series::POINT_AVERAGE_VALUE);
+            cells->push_back(cx);
+        }
+    }
+    routing::model<cell_t> m(rn, cells, ta);
+    routing::river_graph g(*rn);
+    FAST_CHECK_EQ(g.n_basins(), size_t(n_basins));
+    FAST_CHECK_EQ(g.order.size(), size_t(n_basins*n_chain));
+    shyft::core::work_pool pool(3);
+    auto all = m.all_output_m3s(&pool, 4);
+    FAST_REQUIRE_EQ(all.size(), size_t(n_basins*n_chain));
+    for (int b = 0; b < n_basins; ++b) {
+        for (int k : {0, 1, n_chain/2, n_chain - 1}) {
+            const auto& q = all[size_t(b*n_chain + k)];
+            for (size_t t = 0; t < ta.size(); ++t)
+                TS_ASSERT_DELTA(q.value(t), double((b + 1)*(n_chain - k)), 1e-6);
+        }
+    }
+    // the output of one river is the same as from the bulk computation
+    auto q1 = m.output_m3s(n_chain + 1);
+    for (size_t t = 0; t < ta.size(); ++t)
+        TS_ASSERT_DELTA(q1.value(t), 2.0*n_chain, 1e-6);
 }
 }
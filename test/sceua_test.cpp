@@ -26,6 +26,19 @@ struct fx_complex:public ifx {
         return y;
     }
 };
+
+struct x2_concurrent_fx:public ifx {
+    std::atomic<size_t> n_eval{0};
+    size_t n_concurrent=4;
+    size_t concurrency() const { return n_concurrent; }
+    double evaluate(const vector<double>& xv) {
+        double y=0;
+        for(auto x:xv )
+            y += x*x;
+        n_eval++;
+        return y;
+    }
+};
 TEST_SUITE("sceua") {
 TEST_CASE("test_basic") {
     sceua opt;
@@ -79,4 +92,34 @@ TEST_CASE("test_complex") {
         cout<<endl<<"2. approximate Found solution x{"<<x[0]<<","<<x[1]<<"}(r="<<rr <<") -> "<<y<<endl<<"\t n_iterations:"<<f_complex.n_eval<<endl;
     }
 }
+
+TEST_CASE("test_concurrent_evaluation") {
+    x2_concurrent_fx f;
+    vector<vector<double>> xs;
+    for(size_t i=0;i<100;++i)
+        xs.push_back(vector<double>{double(i),1.0});
+    vector<double> ys;
+    f.evaluate_batch(xs,ys);
+    FAST_REQUIRE_EQ(ys.size(),xs.size());
+    for(size_t i=0;i<xs.size();++i)
+        FAST_CHECK_EQ(ys[i],double(i*i)+1.0);
+    FAST_CHECK_EQ(size_t(f.n_eval),xs.size());
+
+    sceua opt;
+    const size_t n=2;
+    double x[2]={-1.0, 2.5};
+    double x_min[2]= {-10,-10};
+    double x_max[2]= { 10, 10.0};
+    const double eps=1e-6;
+    double x_eps[2]= {eps,eps};
+    double y=-1;
+    f.n_eval=0;
+    const size_t max_iterations=20000;
+    auto r=opt.find_min(n,x_min,x_max,x,y,f,eps, -1,-2,x_eps,max_iterations);
+    TS_ASSERT_LESS_THAN(f.n_eval, max_iterations);
+    TS_ASSERT_EQUALS(r,OptimizerState::FinishedXconvergence);
+    TS_ASSERT_DELTA(y,0.0,1e-5);
+    TS_ASSERT_DELTA(x[0],0.0,1e-5);
+    TS_ASSERT_DELTA(x[1],0.0,1e-5);
+}
 }
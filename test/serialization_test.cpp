@@ -1,6 +1,7 @@
 #include "test_pch.h"
 #include "core/expression_serialization.h"
 #include "core/core_archive.h"
+#include "core/dtss_cache.h"
 
 using namespace std;
 using namespace shyft;
@@ -632,4 +633,13 @@ TEST_CASE("test_tuple_serialization") {
     FAST_CHECK_EQ(std::get<0>(xtra.ts_reps)[0], std::get<0>(xtra2.ts_reps)[0]);
 }
 
+TEST_CASE("test_cache_stats_serialization") {
+    shyft::dtss::cache_stats cs;
+    cs.hits = 1; cs.misses = 2; cs.coverage_misses = 3; cs.id_count = 4; cs.point_count = 5; cs.fragment_count = 6; cs.byte_count = 40;
+    auto cs2 = serialize_loop(cs);// class version 1 keeps the byte_count
+    FAST_CHECK_EQ(cs2.hits, cs.hits);
+    FAST_CHECK_EQ(cs2.fragment_count, cs.fragment_count);
+    FAST_CHECK_EQ(cs2.byte_count, cs.byte_count);
+}
+
 } // end TEST_SUITE
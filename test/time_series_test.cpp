@@ -848,6 +848,76 @@ TEST_SUITE("time_series") {
         TS_ASSERT_DELTA(d.value(0),a_value+b_value,0.00001);
         a.set(0,b_value);
         TS_ASSERT_DELTA(d.value(0),b_value+b_value,0.00001);
+    }
+    TEST_CASE("test_api_ts_fused_values") {
+        using namespace shyft::time_series::dd;
+        // verify that fused evaluation of aligned expressions equals the value by value evaluation,
+        // also for sizes not a multiple of the block-size, and with non-aligned sub-expressions
+        size_t n = 2*1024 + 17;
+        gta_t ta(shyft::time_axis::fixed_dt(0, deltahours(1), n));
+        gta_t tb(shyft::time_axis::fixed_dt(0, deltahours(2), n/2));
+        vector<double> va, vb;
+        for (size_t i = 0; i < n; ++i) {
+            va.push_back(i % 7 == 0 ? shyft::nan : 0.1*i);
+            vb.push_back(1.0 + i % 13);
+        }
+        apoint_ts a(ta, va), b(ta, vb), c(tb, 2.0);
+        auto e = max(a*b - 3.0*(a + b)/b + 2.0, 0.5) + min(a, b)*(1.0 - a) - c + (a + c)*b;
+        auto ev = e.values();
+        FAST_REQUIRE_EQ(ev.size(), e.size());
+        for (size_t i = 0; i < ev.size(); ++i) {
+            if (std::isfinite(e.value(i)))
+                FAST_CHECK_EQ(ev[i], doctest::Approx(e.value(i)));
+            else
+                FAST_CHECK_UNARY(!std::isfinite(ev[i]));
+        }
+        auto d = deflate_ts_vector<gts_t>(vector<apoint_ts>{e, 2.0*a + b});
+        FAST_REQUIRE_EQ(d.size(), 2u);
+        FAST_CHECK_EQ(d[1].v[1], doctest::Approx(2.0*va[1] + vb[1]));
+    }
+    TEST_CASE("test_api_ts_common_subexpressions") {
+        using namespace shyft::time_series::dd;
+        gta_t ta(shyft::time_axis::fixed_dt(0, deltahours(1), 48));
+        gta_t ta24(shyft::time_axis::fixed_dt(0, deltahours(24), 2));
+        apoint_ts a(ta, 2.0, POINT_AVERAGE_VALUE), b(ta, 3.0, POINT_AVERAGE_VALUE);
+        // separately built, but equal sub-expressions
+        vector<apoint_ts> tsv{
+            average(a*b, ta24) + 1.0,
+            average(a*b, ta24)*2.0,
+            (a*b).time_shift(deltahours(1)),
+            a + b,
+            average(a*b, ta24)
+        };
+        auto cse = evaluate_common_subexpressions(tsv);
+        FAST_REQUIRE_EQ(cse.size(), tsv.size());
+        // the common average(a*b) is evaluated, and referenced as a concrete ts
+        auto avg_0 = dynamic_pointer_cast<abin_op_ts_scalar>(cse[0].ts);
+        auto avg_1 = dynamic_pointer_cast<abin_op_ts_scalar>(cse[1].ts);
+        FAST_REQUIRE_UNARY(avg_0);
+        FAST_REQUIRE_UNARY(avg_1);
+        FAST_CHECK_EQ(avg_0->lhs.ts, avg_1->lhs.ts);
+        FAST_CHECK_EQ(avg_0->lhs.ts, cse[4].ts);
+        FAST_CHECK_UNARY(dynamic_pointer_cast<gpoint_ts>(cse[4].ts) != nullptr);
+        // the passed expressions are untouched
+        FAST_CHECK_UNARY(dynamic_pointer_cast<shyft::time_series::dd::average_ts>(tsv[4].ts) != nullptr);
+        auto r = deflate_ts_vector<apoint_ts>(tsv);
+        FAST_REQUIRE_EQ(r.size(), tsv.size());
+        for (size_t i = 0; i < tsv.size(); ++i) {
+            FAST_REQUIRE_EQ(r[i].size(), tsv[i].size());
+            FAST_CHECK_EQ(r[i].time_axis(), tsv[i].time_axis());
+            for (size_t j = 0; j < r[i].size(); ++j)
+                FAST_CHECK_EQ(r[i].value(j), doctest::Approx(tsv[i].value(j)));
+        }
+        // an explicitly set point interpretation is kept, with or without a shared node below
+        auto ab = a*b; ab.set_point_interpretation(POINT_INSTANT_VALUE);
+        auto ab_s = (a*b)*2.0; ab_s.set_point_interpretation(POINT_INSTANT_VALUE);
+        auto fx = evaluate_common_subexpressions(vector<apoint_ts>{ab, ab_s, a*b + 1.0});
+        FAST_REQUIRE_EQ(fx.size(), 3u);
+        FAST_CHECK_EQ(fx[0].point_interpretation(), POINT_INSTANT_VALUE);
+        FAST_CHECK_EQ(fx[1].point_interpretation(), POINT_INSTANT_VALUE);
+        FAST_CHECK_EQ(fx[2].point_interpretation(), POINT_AVERAGE_VALUE);
+        FAST_CHECK_EQ(fx[0].ts, ab.ts);// nothing shared below, so kept as is
+        FAST_CHECK_NE(fx[1].ts, ab_s.ts);
     }
 	TEST_CASE("test_api_ts_stair_nan_after_end") {
 		using namespace shyft::time_series::dd;
@@ -1608,6 +1678,54 @@ TEST_SUITE("time_series") {
 
     }
 
+    TEST_CASE("test_convolution_w_values") {
+        // the bulk values() equals the point by point value(i), exact for the direct convolution
+        // and within fp tolerance for the fft used with long weights
+        using namespace shyft::core;
+        using namespace shyft;
+        calendar utc;
+        time_axis::fixed_dt ta(utc.time(2016,1,1),deltahours(1),3000);
+        time_series::point_ts<decltype(ta)> ts(ta,0.0,shyft::time_series::POINT_AVERAGE_VALUE);
+        for(size_t i=0; i<ta.size(); ++i)
+            ts.set(i,10.0+5.0*std::sin(i/50.0)+(i%7));
+        auto routing_uhg = [](size_t n) {// a smooth hydrograph, sum 1.0
+            std::vector<double> w;
+            double s = 0.0;
+            for (size_t k = 0; k < n; ++k) {
+                w.push_back(std::exp(-double(k)/(1.0 + n/5.0))*(k + 1));
+                s += w.back();
+            }
+            for (auto& x : w) x /= s;
+            return w;
+        };
+        for (size_t n_w : {1u, 5u, 300u, 700u}) {
+            std::vector<double> w = routing_uhg(n_w);
+            for (auto policy : {time_series::convolve_policy::USE_FIRST, time_series::convolve_policy::USE_ZERO, time_series::convolve_policy::USE_NAN}) {
+                time_series::convolve_w_ts<decltype(ts)> cts(ts, w, policy);
+                auto v = cts.values();
+                FAST_REQUIRE_EQ(v.size(), ta.size());
+                for (size_t i = 0; i < ta.size(); ++i) {
+                    double e = cts.value(i);
+                    if (!std::isfinite(e)) {
+                        FAST_CHECK_UNARY(!std::isfinite(v[i]));
+                    } else if (n_w < time_series::convolve::fft_min_weights) {
+                        FAST_CHECK_EQ(v[i], e);
+                    } else {
+                        TS_ASSERT_DELTA(v[i], e, 1e-9);
+                    }
+                }
+            }
+        }
+        // a nan in the series falls back to the direct convolution, so that nan is kept local
+        ts.set(2000, shyft::nan);
+        time_series::convolve_w_ts<decltype(ts)> cts(ts, routing_uhg(300), time_series::convolve_policy::USE_ZERO);
+        auto v = cts.values();
+        FAST_CHECK_UNARY(std::isfinite(v[1999]));
+        FAST_CHECK_UNARY(!std::isfinite(v[2000]));
+        FAST_CHECK_UNARY(!std::isfinite(v[2299]));
+        FAST_CHECK_UNARY(std::isfinite(v[2300]));
+    }
+
     TEST_CASE("test_uniform_sum_ts") {
         using namespace shyft::core;
         using namespace shyft;